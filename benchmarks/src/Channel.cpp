@@ -0,0 +1,93 @@
+#include "common/Channel.hpp"
+#include "messages/Message.hpp"
+
+#include <benchmark/benchmark.h>
+#include <QString>
+
+using namespace chatterino;
+
+namespace {
+
+std::shared_ptr<Channel> makeChannel(size_t messageCount)
+{
+    auto channel = std::make_shared<Channel>("testchannel", Channel::Type::None,
+                                             messageCount);
+
+    for (size_t i = 0; i < messageCount; i++)
+    {
+        auto message = std::make_shared<Message>();
+        message->id = QString("message-%1").arg(i);
+        message->loginName = QString("user%1").arg(i % 500);
+
+        channel->addMessage(message);
+    }
+
+    return channel;
+}
+
+std::vector<QString> makeDeletionIds(size_t messageCount, size_t count)
+{
+    std::vector<QString> ids;
+    ids.reserve(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        // about half of the ids target messages that aren't in the channel
+        auto n = (i * 7919) % (messageCount * 2);
+        ids.push_back(QString("message-%1").arg(n));
+    }
+
+    return ids;
+}
+
+}  // namespace
+
+// Disables 10k messages by id in a channel holding 5k messages, like a burst
+// of CLEARMSG/PubSub deletions would
+static void BM_ChannelDeleteMessage(benchmark::State &state)
+{
+    const size_t messageCount = 5000;
+    const size_t deletionCount = 10000;
+
+    auto channel = makeChannel(messageCount);
+    auto ids = makeDeletionIds(messageCount, deletionCount);
+
+    for (auto _ : state)
+    {
+        for (const auto &id : ids)
+        {
+            channel->deleteMessage(id);
+        }
+    }
+}
+
+BENCHMARK(BM_ChannelDeleteMessage);
+
+// Same as above, but looking messages up by scanning a snapshot the way
+// Channel::findMessage used to
+static void BM_ChannelDeleteMessageLinearScan(benchmark::State &state)
+{
+    const size_t messageCount = 5000;
+    const size_t deletionCount = 10000;
+
+    auto channel = makeChannel(messageCount);
+    auto ids = makeDeletionIds(messageCount, deletionCount);
+
+    for (auto _ : state)
+    {
+        for (const auto &id : ids)
+        {
+            auto snapshot = channel->getMessageSnapshot();
+            for (int i = int(snapshot.size()) - 1; i >= 0; --i)
+            {
+                if (snapshot[i]->id == id)
+                {
+                    snapshot[i]->flags.set(MessageFlag::Disabled);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_ChannelDeleteMessageLinearScan);
@@ -0,0 +1,130 @@
+#include "controllers/filters/parser/FilterParser.hpp"
+#include "messages/Message.hpp"
+
+#include <benchmark/benchmark.h>
+#include <QString>
+
+using namespace chatterino;
+using namespace filterparser;
+
+namespace {
+
+struct RecordedMessage {
+    const char *displayName;
+    const char *color;
+    std::vector<std::pair<const char *, const char *>> badges;
+    const char *subLength;
+    const char *text;
+};
+
+// Messages recorded from a busy channel
+const std::vector<RecordedMessage> CORPUS = {
+    {"pajlada", "#CC44FF", {{"moderator", "1"}, {"subscriber", "48"}}, "50",
+     "@forsen hello there how is it going"},
+    {"Zneix", "#FF0000", {{"vip", "1"}}, nullptr, "LUL LUL LUL"},
+    {"randers", "", {}, nullptr, "is the stream lagging for anyone else?"},
+    {"Felanbird", "#1E90FF", {{"subscriber", "12"}, {"premium", "1"}}, "12",
+     "cheer100 great stream today"},
+    {"Mm2PL", "#00FF7F", {{"founder", "0"}}, "30",
+     "https://github.com/Chatterino/chatterino2/pull/1 check this out"},
+    {"someviewer", "", {{"glhf-pledge", "1"}}, nullptr, "KEKW"},
+    {"AnotherOne", "#DAA520", {{"subscriber", "3"}, {"bits", "1000"}}, "3",
+     "does anyone know the song name? it sounds really familiar"},
+    {"spammer123", "", {}, nullptr,
+     "FREE VIEWERS AT bigfollows dot com FREE VIEWERS"},
+    {"lurker", "#8A2BE2", {{"subscriber", "1"}}, "1", "first time chatter hi"},
+    {"Regular", "#2E8B57", {{"vip", "1"}, {"subscriber", "24"}}, "24",
+     "PogChamp PogChamp what a play"},
+};
+
+std::vector<MessagePtr> makeMessages(size_t count)
+{
+    std::vector<MessagePtr> messages;
+    messages.reserve(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto &recorded = CORPUS[i % CORPUS.size()];
+
+        auto message = std::make_shared<Message>();
+        message->displayName = recorded.displayName;
+        message->loginName = message->displayName.toLower();
+        message->channelName = "testchannel";
+        message->usernameColor = QColor(recorded.color);
+        message->messageText = recorded.text;
+        for (const auto &badge : recorded.badges)
+        {
+            message->badges.emplace_back(badge.first, badge.second);
+        }
+        if (recorded.subLength)
+        {
+            message->badgeInfos.emplace("subscriber", recorded.subLength);
+        }
+        if (i % 7 == 0)
+        {
+            message->flags.set(MessageFlag::Highlighted);
+        }
+
+        messages.push_back(message);
+    }
+
+    return messages;
+}
+
+// Filters like the ones people use for mod views, spam and sub-only splits
+const std::vector<QString> FILTERS = {
+    "author.badges contains \"moderator\" || author.badges contains \"vip\"",
+    "!(message.content match ri\"free viewers|bigfollows\")",
+    "author.subbed && author.sub_length >= 6",
+    "message.length > 10 && !author.no_color",
+    "flags.highlighted || message.content contains \"song\"",
+    "(message.content match {r\"cheer(\\d+)\", 1}) == \"100\"",
+};
+
+}  // namespace
+
+// Runs every filter on 5000 messages, the way a few filtered splits would
+static void BM_FilterParser(benchmark::State &state)
+{
+    auto messages = makeMessages(5000);
+
+    std::vector<std::unique_ptr<FilterParser>> filters;
+    for (const auto &filter : FILTERS)
+    {
+        filters.push_back(std::make_unique<FilterParser>(filter));
+    }
+
+    for (auto _ : state)
+    {
+        for (const auto &message : messages)
+        {
+            FilterContext context(message, nullptr);
+            for (const auto &filter : filters)
+            {
+                benchmark::DoNotOptimize(filter->execute(context));
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_FilterParser);
+
+// Same as above, but compiling the filters for every message
+static void BM_FilterParserCompile(benchmark::State &state)
+{
+    auto messages = makeMessages(100);
+
+    for (auto _ : state)
+    {
+        for (const auto &message : messages)
+        {
+            FilterContext context(message, nullptr);
+            for (const auto &filter : FILTERS)
+            {
+                benchmark::DoNotOptimize(FilterParser(filter).execute(context));
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_FilterParserCompile);
@@ -0,0 +1,88 @@
+#include "controllers/highlights/HighlightMatcher.hpp"
+
+#include <benchmark/benchmark.h>
+#include <QString>
+
+using namespace chatterino;
+
+namespace {
+
+std::vector<HighlightPhrase> makePhrases(size_t count)
+{
+    std::vector<HighlightPhrase> phrases;
+    phrases.reserve(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        // mostly plain phrases with the occasional regex, like a typical
+        // list of highlights
+        bool isRegex = i % 10 == 0;
+        auto pattern = isRegex ? QString("word%1[0-9]+").arg(i)
+                               : QString("phrase%1").arg(i);
+
+        phrases.emplace_back(pattern, false, false, false, isRegex,
+                             i % 3 == 0, "", QColor());
+    }
+
+    return phrases;
+}
+
+std::vector<QString> makeMessages(size_t count)
+{
+    std::vector<QString> messages;
+    messages.reserve(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        auto message = QString("this is chat message number %1 with some "
+                               "filler words LUL Kappa PogChamp")
+                           .arg(i);
+        // every 50th message contains a highlighted phrase
+        if (i % 50 == 0)
+        {
+            message += QString(" phrase%1").arg(i % 300);
+        }
+        messages.push_back(message);
+    }
+
+    return messages;
+}
+
+}  // namespace
+
+// Checks 1000 messages against 300 highlight phrases one phrase at a time,
+// like SharedMessageBuilder::parseHighlights used to
+static void BM_HighlightPhrasesLoop(benchmark::State &state)
+{
+    auto phrases = makePhrases(300);
+    auto messages = makeMessages(1000);
+
+    for (auto _ : state)
+    {
+        for (const auto &message : messages)
+        {
+            for (const auto &phrase : phrases)
+            {
+                benchmark::DoNotOptimize(phrase.isMatch(message));
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_HighlightPhrasesLoop);
+
+static void BM_HighlightMatcher(benchmark::State &state)
+{
+    HighlightMatcher matcher(makePhrases(300));
+    auto messages = makeMessages(1000);
+
+    for (auto _ : state)
+    {
+        for (const auto &message : messages)
+        {
+            benchmark::DoNotOptimize(matcher.match(message));
+        }
+    }
+}
+
+BENCHMARK(BM_HighlightMatcher);
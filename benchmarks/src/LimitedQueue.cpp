@@ -0,0 +1,236 @@
+#include "messages/LimitedQueue.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace chatterino;
+
+namespace {
+
+// The chunked copy-on-write LimitedQueue that was used before the current
+// implementation, reduced to the parts exercised by the benchmarks below
+template <typename T>
+class ChunkedQueueSnapshot
+{
+public:
+    using ChunkVector = std::vector<std::shared_ptr<std::vector<T>>>;
+
+    ChunkedQueueSnapshot(std::shared_ptr<ChunkVector> chunks, size_t length,
+                         size_t firstChunkOffset)
+        : chunks_(std::move(chunks))
+        , length_(length)
+        , firstChunkOffset_(firstChunkOffset)
+    {
+    }
+
+    size_t size() const
+    {
+        return this->length_;
+    }
+
+    const T &operator[](size_t index) const
+    {
+        index += this->firstChunkOffset_;
+
+        size_t x = 0;
+        for (auto &chunk : *this->chunks_)
+        {
+            if (x <= index && x + chunk->size() > index)
+            {
+                return chunk->at(index - x);
+            }
+            x += chunk->size();
+        }
+
+        return this->chunks_->at(0)->at(0);
+    }
+
+private:
+    std::shared_ptr<ChunkVector> chunks_;
+    size_t length_;
+    size_t firstChunkOffset_;
+};
+
+template <typename T>
+class ChunkedQueue
+{
+    using Chunk = std::vector<T>;
+    using ChunkVector = std::vector<std::shared_ptr<Chunk>>;
+
+public:
+    ChunkedQueue(size_t limit)
+        : limit_(limit)
+    {
+        this->chunks_ = std::make_shared<ChunkVector>();
+        auto chunk = std::make_shared<Chunk>();
+        chunk->resize(this->chunkSize_);
+        this->chunks_->push_back(chunk);
+    }
+
+    bool pushBack(const T &item, T &deleted)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        auto lastChunk = this->chunks_->back();
+
+        if (lastChunk->size() <= this->lastChunkEnd_)
+        {
+            auto newVector = std::make_shared<ChunkVector>(*this->chunks_);
+
+            auto newChunk = std::make_shared<Chunk>();
+            newChunk->resize(this->chunkSize_);
+            newVector->push_back(newChunk);
+
+            this->chunks_ = newVector;
+            this->lastChunkEnd_ = 0;
+            lastChunk = this->chunks_->back();
+        }
+
+        lastChunk->at(this->lastChunkEnd_++) = item;
+
+        if (this->space() > 0)
+        {
+            return false;
+        }
+
+        deleted = this->chunks_->front()->at(this->firstChunkOffset_);
+
+        if (this->firstChunkOffset_ == this->chunks_->front()->size() - 1)
+        {
+            this->chunks_ = std::make_shared<ChunkVector>(
+                this->chunks_->begin() + 1, this->chunks_->end());
+            this->firstChunkOffset_ = 0;
+        }
+        else
+        {
+            this->firstChunkOffset_++;
+        }
+
+        return true;
+    }
+
+    ChunkedQueueSnapshot<T> getSnapshot()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        return ChunkedQueueSnapshot<T>(this->chunks_,
+                                       this->limit_ - this->space(),
+                                       this->firstChunkOffset_);
+    }
+
+private:
+    size_t space() const
+    {
+        size_t totalSize = 0;
+        for (auto &chunk : *this->chunks_)
+        {
+            totalSize += chunk->size();
+        }
+
+        totalSize -= this->chunks_->back()->size() - this->lastChunkEnd_;
+        if (this->chunks_->size() != 1)
+        {
+            totalSize -= this->firstChunkOffset_;
+        }
+
+        return this->limit_ - totalSize;
+    }
+
+    std::shared_ptr<ChunkVector> chunks_;
+    std::mutex mutex_;
+
+    size_t firstChunkOffset_ = 0;
+    size_t lastChunkEnd_ = 0;
+    const size_t limit_;
+
+    const size_t chunkSize_ = 100;
+};
+
+template <typename Queue>
+void fillQueue(Queue &queue, size_t count)
+{
+    std::shared_ptr<int> deleted;
+    for (size_t i = 0; i < count; i++)
+    {
+        queue.pushBack(std::make_shared<int>(int(i)), deleted);
+    }
+}
+
+// Push into a full queue, which evicts an item for every push
+template <typename Queue>
+void BM_QueuePushBack(benchmark::State &state)
+{
+    Queue queue(size_t(state.range(0)));
+    fillQueue(queue, size_t(state.range(0)));
+
+    auto item = std::make_shared<int>(0);
+    std::shared_ptr<int> deleted;
+
+    for (auto _ : state)
+    {
+        queue.pushBack(item, deleted);
+    }
+}
+
+// Push one item and take a snapshot, like ChannelView does for every message
+template <typename Queue>
+void BM_QueuePushAndSnapshot(benchmark::State &state)
+{
+    Queue queue(size_t(state.range(0)));
+    fillQueue(queue, size_t(state.range(0)));
+
+    auto item = std::make_shared<int>(0);
+    std::shared_ptr<int> deleted;
+
+    for (auto _ : state)
+    {
+        queue.pushBack(item, deleted);
+        benchmark::DoNotOptimize(queue.getSnapshot());
+    }
+}
+
+// Iterate over a whole snapshot, like the layout and search code does
+template <typename Queue>
+void BM_QueueSnapshotIterate(benchmark::State &state)
+{
+    Queue queue(size_t(state.range(0)));
+    fillQueue(queue, size_t(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto snapshot = queue.getSnapshot();
+
+        int sum = 0;
+        for (size_t i = 0; i < snapshot.size(); i++)
+        {
+            sum += *snapshot[i];
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_QueuePushBack, ChunkedQueue<std::shared_ptr<int>>)
+    ->Arg(1000)
+    ->Arg(10000);
+BENCHMARK_TEMPLATE(BM_QueuePushBack, LimitedQueue<std::shared_ptr<int>>)
+    ->Arg(1000)
+    ->Arg(10000);
+
+BENCHMARK_TEMPLATE(BM_QueuePushAndSnapshot, ChunkedQueue<std::shared_ptr<int>>)
+    ->Arg(1000)
+    ->Arg(10000);
+BENCHMARK_TEMPLATE(BM_QueuePushAndSnapshot, LimitedQueue<std::shared_ptr<int>>)
+    ->Arg(1000)
+    ->Arg(10000);
+
+BENCHMARK_TEMPLATE(BM_QueueSnapshotIterate, ChunkedQueue<std::shared_ptr<int>>)
+    ->Arg(1000)
+    ->Arg(10000);
+BENCHMARK_TEMPLATE(BM_QueueSnapshotIterate, LimitedQueue<std::shared_ptr<int>>)
+    ->Arg(1000)
+    ->Arg(10000);
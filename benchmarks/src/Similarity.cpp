@@ -0,0 +1,149 @@
+#include "messages/MessageSimilarity.hpp"
+
+#include <benchmark/benchmark.h>
+#include <QString>
+
+#include <vector>
+
+using namespace chatterino;
+
+namespace {
+
+// The longest common substring check IrcMessageHandler used before, which
+// allocates a full table for every comparison
+float tableSimilarity(const QString &str1, const QString &str2)
+{
+    std::vector<std::vector<int>> tree(str1.size(),
+                                       std::vector<int>(str2.size(), 0));
+    int z = 0;
+
+    for (int i = 0; i < str1.size(); ++i)
+    {
+        for (int j = 0; j < str2.size(); ++j)
+        {
+            if (str1[i] == str2[j])
+            {
+                tree[i][j] = i == 0 || j == 0 ? 1 : tree[i - 1][j - 1] + 1;
+                z = std::max(z, tree[i][j]);
+            }
+        }
+    }
+
+    return z == 0 ? 0.f
+                  : float(z) /
+                        std::max<int>(1, std::max(str1.size(), str2.size()));
+}
+
+// A chat flooded with variations of a long copypasta, mixed with regular
+// messages
+std::vector<QString> makeSpam(size_t count)
+{
+    const QString copypasta =
+        "I'm not saying this streamer is bad but every time they play this "
+        "game my grandma calls me from the other room asking why I'm crying "
+        "again. She doesn't understand. Nobody understands. The boss has "
+        "three phases and they died to the first one eleven times in a row "
+        "while explaining how easy it is. Chat, this is our life now. Copy "
+        "this message if you were there when it happened, we will never "
+        "forget the great wipe of the third phase, may it rest in peace "
+        "forever and ever";
+
+    std::vector<QString> messages;
+    messages.reserve(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i % 4 == 3)
+        {
+            messages.push_back(
+                QString("LUL what happened, I just got here %1").arg(i));
+        }
+        else
+        {
+            // spammers change a few characters to get around duplicate
+            // message checks
+            auto message = copypasta;
+            message[int(i % size_t(message.size()))] = '!';
+            message += QString(" %1").arg(i % 7);
+            messages.push_back(message);
+        }
+    }
+
+    return messages;
+}
+
+}  // namespace
+
+// Compares every message with the 3 messages before it, like
+// hideSimilarMaxMessagesToCheck does by default
+static void BM_SimilarityTable(benchmark::State &state)
+{
+    auto messages = makeSpam(200);
+
+    for (auto _ : state)
+    {
+        for (size_t i = 3; i < messages.size(); i++)
+        {
+            for (size_t j = i - 3; j < i; j++)
+            {
+                if (tableSimilarity(messages[i], messages[j]) > 0.9f)
+                {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_SimilarityTable);
+
+static void BM_SimilarityRollingRow(benchmark::State &state)
+{
+    auto messages = makeSpam(200);
+
+    for (auto _ : state)
+    {
+        for (size_t i = 3; i < messages.size(); i++)
+        {
+            for (size_t j = i - 3; j < i; j++)
+            {
+                if (MessageSimilarity::relativeSimilarity(messages[i],
+                                                          messages[j]) > 0.9f)
+                {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_SimilarityRollingRow);
+
+// Includes preprocessing each message once, like MessageSimilarity::of
+static void BM_SimilarityPreprocessed(benchmark::State &state)
+{
+    auto messages = makeSpam(200);
+
+    for (auto _ : state)
+    {
+        std::vector<MessageSimilarity> preprocessed;
+        preprocessed.reserve(messages.size());
+        for (const auto &message : messages)
+        {
+            preprocessed.emplace_back(message);
+        }
+
+        for (size_t i = 3; i < preprocessed.size(); i++)
+        {
+            for (size_t j = i - 3; j < i; j++)
+            {
+                if (preprocessed[i].isSimilarTo(preprocessed[j], 0.9f))
+                {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_SimilarityPreprocessed);
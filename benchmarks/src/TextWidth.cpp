@@ -0,0 +1,141 @@
+#include "messages/Message.hpp"
+#include "messages/MessageElement.hpp"
+#include "messages/layouts/MessageLayout.hpp"
+#include "messages/layouts/MessageLayoutContainer.hpp"
+#include "messages/layouts/TextWidthCache.hpp"
+#include "singletons/Fonts.hpp"
+#include "singletons/Resources.hpp"
+#include "singletons/Settings.hpp"
+#include "singletons/Theme.hpp"
+
+#include <benchmark/benchmark.h>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <memory>
+
+using namespace chatterino;
+
+namespace {
+
+// What TextElement::addToContainer and MessageLayoutContainer use, without
+// the rest of the application
+class LayoutEnvironment
+{
+public:
+    LayoutEnvironment()
+        : settings_(settingsDirectory_.path())
+    {
+        // the theme uses the resources
+        initResources();
+
+        this->theme_ = std::make_unique<Theme>();
+        this->fonts_ = std::make_unique<Fonts>();
+    }
+
+private:
+    QTemporaryDir settingsDirectory_;
+    Settings settings_;
+    std::unique_ptr<Theme> theme_;
+    std::unique_ptr<Fonts> fonts_;
+};
+
+void initEnvironment()
+{
+    static LayoutEnvironment environment;
+}
+
+// The messages of a busy chat, most of their words repeat across messages
+std::vector<MessagePtr> makeMessages(size_t count)
+{
+    const QStringList vocabulary{
+        "LUL",  "Kappa", "PogChamp", "the",   "streamer", "is",   "so",
+        "good", "at",    "this",     "game",  "KEKW",     "chat", "what",
+        "just", "happened", "no",    "way",   "monkaS",   "GG",   "clip",
+        "it",   "@username", "lmao", "OMEGALUL", "5Head", "true", "xD",
+    };
+
+    std::vector<MessagePtr> messages;
+    messages.reserve(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        // 12 words per message, with a unique one now and then
+        QStringList words;
+        for (size_t j = 0; j < 12; j++)
+        {
+            auto index = (i * 7 + j * 13) % size_t(vocabulary.size());
+            words.append(j == 11 && i % 5 == 0 ? QString("word%1").arg(i)
+                                               : vocabulary[int(index)]);
+        }
+
+        auto message = std::make_shared<Message>();
+        message->elements.push_back(std::make_unique<TextElement>(
+            QString("user%1:").arg(i % 100), MessageElementFlag::Username));
+        message->elements.push_back(std::make_unique<TextElement>(
+            words.join(' '), MessageElementFlag::Text));
+        messages.push_back(message);
+    }
+
+    return messages;
+}
+
+// Lays out every message once per split. The splits have different widths,
+// like splits side by side in a window.
+void layoutSplits(const std::vector<MessagePtr> &messages, bool measureWords)
+{
+    for (int split = 0; split < 20; split++)
+    {
+        // drops the widths measured so far, so every word is measured
+        // again like before TextWidthCache
+        if (measureWords)
+        {
+            TextWidthCache::instance().clear();
+        }
+
+        for (const auto &message : messages)
+        {
+            MessageLayoutRequest request;
+            request.message = message;
+            request.width = 300 + split * 10;
+            request.scale = 1.f;
+            request.devicePixelRatio = 1;
+            request.flags = {MessageElementFlag::Username,
+                             MessageElementFlag::Text};
+            request.messageFlags = message->flags;
+            request.serial = 0;
+
+            benchmark::DoNotOptimize(MessageLayout::buildLayout(request));
+        }
+    }
+}
+
+}  // namespace
+
+// Relayouts 1000 messages in 20 splits, measuring every word like
+// TextElement::addToContainer used to
+static void BM_TextWidthLayoutMeasure(benchmark::State &state)
+{
+    initEnvironment();
+    auto messages = makeMessages(1000);
+
+    for (auto _ : state)
+    {
+        layoutSplits(messages, true);
+    }
+}
+
+BENCHMARK(BM_TextWidthLayoutMeasure);
+
+static void BM_TextWidthLayoutCached(benchmark::State &state)
+{
+    initEnvironment();
+    auto messages = makeMessages(1000);
+
+    for (auto _ : state)
+    {
+        layoutSplits(messages, false);
+    }
+}
+
+BENCHMARK(BM_TextWidthLayoutCached);
@@ -136,6 +136,8 @@ SOURCES += \
     src/common/Env.cpp \
     src/common/LinkParser.cpp \
     src/common/Modes.cpp \
+    src/common/NetworkBlobStore.cpp \
+    src/common/NetworkCache.cpp \
     src/common/NetworkCommon.cpp \
     src/common/NetworkManager.cpp \
     src/common/NetworkPrivate.cpp \
@@ -151,12 +153,15 @@ SOURCES += \
     src/controllers/commands/CommandController.cpp \
     src/controllers/commands/CommandModel.cpp \
     src/controllers/filters/FilterModel.cpp \
+    src/controllers/filters/parser/FilterContext.cpp \
     src/controllers/filters/parser/FilterParser.cpp \
+    src/controllers/filters/parser/FilterProgram.cpp \
     src/controllers/filters/parser/Tokenizer.cpp \
     src/controllers/filters/parser/Types.cpp \
     src/controllers/highlights/BadgeHighlightModel.cpp \
     src/controllers/highlights/HighlightBadge.cpp \
     src/controllers/highlights/HighlightBlacklistModel.cpp \
+    src/controllers/highlights/HighlightMatcher.cpp \
     src/controllers/highlights/HighlightModel.cpp \
     src/controllers/highlights/HighlightPhrase.cpp \
     src/controllers/highlights/UserHighlightModel.cpp \
@@ -166,6 +171,7 @@ SOURCES += \
     src/controllers/hotkeys/HotkeyModel.cpp \
     src/controllers/ignores/IgnoreController.cpp \
     src/controllers/ignores/IgnoreModel.cpp \
+    src/controllers/ignores/IgnoreReplacer.cpp \
     src/controllers/moderationactions/ModerationAction.cpp \
     src/controllers/moderationactions/ModerationActionModel.cpp \
     src/controllers/nicknames/NicknamesModel.cpp \
@@ -176,16 +182,25 @@ SOURCES += \
     src/main.cpp \
     src/messages/Emote.cpp \
     src/messages/Image.cpp \
+    src/messages/ImageDecoder.cpp \
+    src/messages/ImageMemoryBudget.cpp \
     src/messages/ImageSet.cpp \
+    src/messages/layouts/LayoutElementArena.cpp \
+    src/messages/layouts/MessageBufferPool.cpp \
     src/messages/layouts/MessageLayout.cpp \
+    src/messages/layouts/MessageLayoutCache.cpp \
     src/messages/layouts/MessageLayoutContainer.cpp \
     src/messages/layouts/MessageLayoutElement.cpp \
+    src/messages/layouts/MessageLayoutWorker.cpp \
+    src/messages/layouts/TextWidthCache.cpp \
     src/messages/Link.cpp \
     src/messages/Message.cpp \
     src/messages/MessageBuilder.cpp \
     src/messages/MessageColor.cpp \
     src/messages/MessageContainer.cpp \
     src/messages/MessageElement.cpp \
+    src/messages/MessageIndex.cpp \
+    src/messages/MessageSimilarity.cpp \
     src/messages/search/AuthorPredicate.cpp \
     src/messages/search/ChannelPredicate.cpp \
     src/messages/search/LinkPredicate.cpp \
@@ -193,6 +208,7 @@ SOURCES += \
     src/messages/search/RegexPredicate.cpp \
     src/messages/search/SubstringPredicate.cpp \
     src/messages/SharedMessageBuilder.cpp \
+    src/messages/SimilarityIndex.cpp \
     src/providers/bttv/BttvEmotes.cpp \
     src/providers/bttv/LoadBttvChannelEmote.cpp \
     src/providers/chatterino/ChatterinoBadges.cpp \
@@ -213,6 +229,8 @@ SOURCES += \
     src/providers/twitch/api/Helix.cpp \
     src/providers/twitch/ChannelPointReward.cpp \
     src/providers/twitch/IrcMessageHandler.cpp \
+    src/providers/twitch/LocalMessageHistory.cpp \
+    src/providers/twitch/MergedEmoteMap.cpp \
     src/providers/twitch/PubSubActions.cpp \
     src/providers/twitch/PubSubClient.cpp \
     src/providers/twitch/PubSubManager.cpp \
@@ -238,6 +256,7 @@ SOURCES += \
     src/singletons/Emotes.cpp \
     src/singletons/Fonts.cpp \
     src/singletons/helper/GifTimer.cpp \
+    src/singletons/helper/LogArchive.cpp \
     src/singletons/helper/LoggingChannel.cpp \
     src/singletons/Logging.cpp \
     src/singletons/NativeMessaging.cpp \
@@ -249,6 +268,7 @@ SOURCES += \
     src/singletons/TooltipPreviewImage.cpp \
     src/singletons/Updates.cpp \
     src/singletons/WindowManager.cpp \
+    src/util/AhoCorasick.cpp \
     src/util/AttachToConsole.cpp \
     src/util/Clipboard.cpp \
     src/util/DebugCount.cpp \
@@ -368,6 +388,8 @@ HEADERS += \
     src/common/IrcColors.hpp \
     src/common/LinkParser.hpp \
     src/common/Modes.hpp \
+    src/common/NetworkBlobStore.hpp \
+    src/common/NetworkCache.hpp \
     src/common/NetworkCommon.hpp \
     src/common/NetworkManager.hpp \
     src/common/NetworkPrivate.hpp \
@@ -392,13 +414,16 @@ HEADERS += \
     src/controllers/filters/FilterModel.hpp \
     src/controllers/filters/FilterRecord.hpp \
     src/controllers/filters/FilterSet.hpp \
+    src/controllers/filters/parser/FilterContext.hpp \
     src/controllers/filters/parser/FilterParser.hpp \
+    src/controllers/filters/parser/FilterProgram.hpp \
     src/controllers/filters/parser/Tokenizer.hpp \
     src/controllers/filters/parser/Types.hpp \
     src/controllers/highlights/BadgeHighlightModel.hpp \
     src/controllers/highlights/HighlightBadge.hpp \
     src/controllers/highlights/HighlightBlacklistModel.hpp \
     src/controllers/highlights/HighlightBlacklistUser.hpp \
+    src/controllers/highlights/HighlightMatcher.hpp \
     src/controllers/highlights/HighlightModel.hpp \
     src/controllers/highlights/HighlightPhrase.hpp \
     src/controllers/highlights/UserHighlightModel.hpp \
@@ -411,6 +436,7 @@ HEADERS += \
     src/controllers/ignores/IgnoreController.hpp \
     src/controllers/ignores/IgnoreModel.hpp \
     src/controllers/ignores/IgnorePhrase.hpp \
+    src/controllers/ignores/IgnoreReplacer.hpp \
     src/controllers/moderationactions/ModerationAction.hpp \
     src/controllers/moderationactions/ModerationActionModel.hpp \
     src/controllers/nicknames/Nickname.hpp \
@@ -423,10 +449,17 @@ HEADERS += \
     src/ForwardDecl.hpp \
     src/messages/Emote.hpp \
     src/messages/Image.hpp \
+    src/messages/ImageDecoder.hpp \
+    src/messages/ImageMemoryBudget.hpp \
     src/messages/ImageSet.hpp \
+    src/messages/layouts/LayoutElementArena.hpp \
+    src/messages/layouts/MessageBufferPool.hpp \
     src/messages/layouts/MessageLayout.hpp \
+    src/messages/layouts/MessageLayoutCache.hpp \
     src/messages/layouts/MessageLayoutContainer.hpp \
     src/messages/layouts/MessageLayoutElement.hpp \
+    src/messages/layouts/MessageLayoutWorker.hpp \
+    src/messages/layouts/TextWidthCache.hpp \
     src/messages/LimitedQueue.hpp \
     src/messages/LimitedQueueSnapshot.hpp \
     src/messages/Link.hpp \
@@ -435,7 +468,9 @@ HEADERS += \
     src/messages/MessageColor.hpp \
     src/messages/MessageContainer.hpp \
     src/messages/MessageElement.hpp \
+    src/messages/MessageIndex.hpp \
     src/messages/MessageParseArgs.hpp \
+    src/messages/MessageSimilarity.hpp \
     src/messages/search/AuthorPredicate.hpp \
     src/messages/search/ChannelPredicate.hpp \
     src/messages/search/LinkPredicate.hpp \
@@ -445,6 +480,7 @@ HEADERS += \
     src/messages/search/SubstringPredicate.hpp \
     src/messages/Selection.hpp \
     src/messages/SharedMessageBuilder.hpp \
+    src/messages/SimilarityIndex.hpp \
     src/PrecompiledHeader.hpp \
     src/providers/bttv/BttvEmotes.hpp \
     src/providers/bttv/LoadBttvChannelEmote.hpp \
@@ -468,6 +504,8 @@ HEADERS += \
     src/providers/twitch/ChatterinoWebSocketppLogger.hpp \
     src/providers/twitch/EmoteValue.hpp \
     src/providers/twitch/IrcMessageHandler.hpp \
+    src/providers/twitch/LocalMessageHistory.hpp \
+    src/providers/twitch/MergedEmoteMap.hpp \
     src/providers/twitch/PubSubActions.hpp \
     src/providers/twitch/PubSubClient.hpp \
     src/providers/twitch/PubSubClientOptions.hpp \
@@ -499,6 +537,7 @@ HEADERS += \
     src/singletons/Emotes.hpp \
     src/singletons/Fonts.hpp \
     src/singletons/helper/GifTimer.hpp \
+    src/singletons/helper/LogArchive.hpp \
     src/singletons/helper/LoggingChannel.hpp \
     src/singletons/Logging.hpp \
     src/singletons/NativeMessaging.hpp \
@@ -510,6 +549,7 @@ HEADERS += \
     src/singletons/TooltipPreviewImage.hpp \
     src/singletons/Updates.hpp \
     src/singletons/WindowManager.hpp \
+    src/util/AhoCorasick.hpp \
     src/util/AttachToConsole.hpp \
     src/util/Clamp.hpp \
     src/util/Clipboard.hpp \
@@ -5,12 +5,12 @@
 #include <QPalette>
 #include <QStyleFactory>
 #include <Qt>
-#include <QtConcurrent>
 #include <csignal>
 
 #include "Application.hpp"
 #include "common/Args.hpp"
 #include "common/Modes.hpp"
+#include "common/NetworkCache.hpp"
 #include "common/NetworkManager.hpp"
 #include "common/QLogging.hpp"
 #include "singletons/Paths.hpp"
@@ -167,23 +167,6 @@ namespace {
         signal(SIGSEGV, handleSignal);
 #endif
     }
-
-    // We delete cache files that haven't been modified in 14 days. This strategy may be
-    // improved in the future.
-    void clearCache(const QDir &dir)
-    {
-        int deletedCount = 0;
-        for (auto &&info : dir.entryInfoList(QDir::Files))
-        {
-            if (info.lastModified().addDays(14) < QDateTime::currentDateTime())
-            {
-                bool res = QFile(info.absoluteFilePath()).remove();
-                if (res)
-                    ++deletedCount;
-            }
-        }
-        qCDebug(chatterinoCache) << "Deleted" << deletedCount << "files";
-    }
 }  // namespace
 
 void runGui(QApplication &a, Paths &paths, Settings &settings)
@@ -213,13 +196,6 @@ void runGui(QApplication &a, Paths &paths, Settings &settings)
         }
     });
 
-    // Clear the cache 1 minute after start.
-    QTimer::singleShot(60 * 1000, [cachePath = paths.cacheDirectory()] {
-        QtConcurrent::run([cachePath]() {
-            clearCache(cachePath);
-        });
-    });
-
     chatterino::NetworkManager::init();
     chatterino::Updates::instance().checkForUpdates();
 
@@ -253,6 +229,8 @@ void runGui(QApplication &a, Paths &paths, Settings &settings)
     }
 
     chatterino::NetworkManager::deinit();
+    // no more responses are cached once the requests are gone
+    NetworkCache::flushAll();
 
 #ifdef USEWINSDK
     // flushing windows clipboard to keep copied messages
@@ -22,10 +22,11 @@ namespace chatterino {
 //
 // Channel
 //
-Channel::Channel(const QString &name, Type type)
+Channel::Channel(const QString &name, Type type, size_t messageLimit)
     : completionModel(*this)
     , lastDate_(QDate::currentDate())
     , name_(name)
+    , messages_(messageLimit)
     , type_(type)
 {
 }
@@ -78,17 +79,30 @@ LimitedQueueSnapshot<MessagePtr> Channel::getMessageSnapshot()
 void Channel::addMessage(MessagePtr message,
                          boost::optional<MessageFlags> overridingFlags)
 {
-    auto app = getApp();
     MessagePtr deleted;
 
     // FOURTF: change this when adding more providers
     if (this->isTwitchChannel() &&
         (!overridingFlags || !overridingFlags->has(MessageFlag::DoNotLog)))
     {
-        app->logging->addMessage(this->name_, message);
+        getApp()->logging->addMessage(this->name_, message);
     }
 
-    if (this->messages_.pushBack(message, deleted))
+    bool didDelete;
+    {
+        std::lock_guard<std::mutex> lock(this->messageIndexMutex_);
+
+        didDelete = this->messages_.pushBack(message, deleted);
+        if (didDelete)
+        {
+            this->messageIndex_.removeFirst(deleted);
+        }
+        this->messageIndex_.append(message);
+        this->similarityIndex_.append(message, this->similarityWindow_,
+                                      QTime::currentTime());
+    }
+
+    if (didDelete)
     {
         this->messageRemovedFromStart.invoke(deleted);
     }
@@ -98,11 +112,32 @@ void Channel::addMessage(MessagePtr message,
 
 void Channel::addOrReplaceTimeout(MessagePtr message)
 {
-    LimitedQueueSnapshot<MessagePtr> snapshot = this->getMessageSnapshot();
+    LimitedQueueSnapshot<MessagePtr> snapshot;
+    boost::optional<size_t> lastTimeout;
+    std::vector<size_t> userMessages;
+    {
+        std::lock_guard<std::mutex> lock(this->messageIndexMutex_);
+
+        snapshot = this->messages_.getSnapshot();
+        lastTimeout = this->messageIndex_.findLastTimeout(message->timeoutUser);
+        userMessages = this->messageIndex_.findByUser(message->timeoutUser);
+    }
     int snapshotLength = snapshot.size();
 
     int end = std::max(0, snapshotLength - 20);
 
+    // The loop below can only stack onto a timeout of this user in the last
+    // 20 messages and stops at the first (un)timeout of them, so there is
+    // nothing to look at unless the index has one in range.
+    if (lastTimeout && int(*lastTimeout) >= end)
+    {
+        end = int(*lastTimeout);
+    }
+    else
+    {
+        end = snapshotLength;
+    }
+
     bool addMessage = true;
 
     QTime minimumTime = QTime::currentTime().addSecs(-5);
@@ -169,7 +204,7 @@ void Channel::addOrReplaceTimeout(MessagePtr message)
     }
 
     // disable the messages from the user
-    for (int i = 0; i < snapshotLength; i++)
+    for (auto i : userMessages)
     {
         auto &s = snapshot[i];
         if (s->loginName == message->timeoutUser &&
@@ -193,9 +228,19 @@ void Channel::addOrReplaceTimeout(MessagePtr message)
 
 void Channel::disableAllMessages()
 {
-    LimitedQueueSnapshot<MessagePtr> snapshot = this->getMessageSnapshot();
-    int snapshotLength = snapshot.size();
-    for (int i = 0; i < snapshotLength; i++)
+    LimitedQueueSnapshot<MessagePtr> snapshot;
+    size_t start;
+    {
+        std::lock_guard<std::mutex> lock(this->messageIndexMutex_);
+
+        snapshot = this->messages_.getSnapshot();
+
+        // messages before this were disabled by a previous call already
+        start = this->messageIndex_.disabledUntil();
+        this->messageIndex_.setDisabledUntil(snapshot.size());
+    }
+
+    for (size_t i = start; i < snapshot.size(); i++)
     {
         auto &message = snapshot[i];
         if (message->flags.hasAny({MessageFlag::System, MessageFlag::Timeout,
@@ -211,8 +256,15 @@ void Channel::disableAllMessages()
 
 void Channel::addMessagesAtStart(std::vector<MessagePtr> &_messages)
 {
-    std::vector<MessagePtr> addedMessages =
-        this->messages_.pushFront(_messages);
+    std::vector<MessagePtr> addedMessages;
+    {
+        std::lock_guard<std::mutex> lock(this->messageIndexMutex_);
+
+        addedMessages = this->messages_.pushFront(_messages);
+        this->messageIndex_.prepend(addedMessages);
+        this->similarityIndex_.prepend(addedMessages, this->similarityWindow_,
+                                       QTime::currentTime());
+    }
 
     if (addedMessages.size() != 0)
     {
@@ -222,7 +274,29 @@ void Channel::addMessagesAtStart(std::vector<MessagePtr> &_messages)
 
 void Channel::replaceMessage(MessagePtr message, MessagePtr replacement)
 {
-    int index = this->messages_.replaceItem(message, replacement);
+    int index = -1;
+    {
+        std::lock_guard<std::mutex> lock(this->messageIndexMutex_);
+
+        if (auto position = this->messageIndex_.find(message))
+        {
+            if (this->messages_.replaceItem(*position, replacement))
+            {
+                index = int(*position);
+            }
+        }
+        else
+        {
+            // messages without an id (e.g. system messages) aren't indexed
+            index = this->messages_.replaceItem(message, replacement);
+        }
+
+        if (index >= 0)
+        {
+            this->messageIndex_.replace(size_t(index), message, replacement);
+            this->similarityIndex_.replace(message, replacement);
+        }
+    }
 
     if (index >= 0)
     {
@@ -232,7 +306,22 @@ void Channel::replaceMessage(MessagePtr message, MessagePtr replacement)
 
 void Channel::replaceMessage(size_t index, MessagePtr replacement)
 {
-    if (this->messages_.replaceItem(index, replacement))
+    bool replaced = false;
+    {
+        std::lock_guard<std::mutex> lock(this->messageIndexMutex_);
+
+        auto snapshot = this->messages_.getSnapshot();
+        if (index < snapshot.size())
+        {
+            auto previous = snapshot[index];
+
+            replaced = this->messages_.replaceItem(index, replacement);
+            this->messageIndex_.replace(index, previous, replacement);
+            this->similarityIndex_.replace(previous, replacement);
+        }
+    }
+
+    if (replaced)
     {
         this->messageReplaced.invoke(index, replacement);
     }
@@ -246,23 +335,48 @@ void Channel::deleteMessage(QString messageID)
         msg->flags.set(MessageFlag::Disabled);
     }
 }
-MessagePtr Channel::findMessage(QString messageID)
+
+std::vector<MessagePtr> Channel::findUserMessages(const QString &userName)
 {
-    LimitedQueueSnapshot<MessagePtr> snapshot = this->getMessageSnapshot();
-    int snapshotLength = snapshot.size();
+    std::lock_guard<std::mutex> lock(this->messageIndexMutex_);
 
-    int end = std::max(0, snapshotLength - 200);
+    auto snapshot = this->messages_.getSnapshot();
 
-    for (int i = snapshotLength - 1; i >= end; --i)
+    std::vector<MessagePtr> messages;
+    for (auto index : this->messageIndex_.findByUser(userName))
     {
-        auto &s = snapshot[i];
+        messages.push_back(snapshot[index]);
+    }
 
-        if (s->id == messageID)
-        {
-            return s;
-        }
+    return messages;
+}
+
+std::vector<MessagePtr> Channel::findSimilarityCandidates(
+    const boost::optional<QString> &loginName,
+    const SimilarityIndex::Window &window)
+{
+    std::lock_guard<std::mutex> lock(this->messageIndexMutex_);
+
+    // new messages are kept for the window of the last check
+    this->similarityWindow_ = window;
+
+    return this->similarityIndex_.find(loginName, window, QTime::currentTime());
+}
+
+MessagePtr Channel::findMessage(QString messageID)
+{
+    std::lock_guard<std::mutex> lock(this->messageIndexMutex_);
+
+    auto index = this->messageIndex_.findById(messageID);
+    if (!index)
+    {
+        return nullptr;
     }
-    return nullptr;
+
+    auto snapshot = this->messages_.getSnapshot();
+    assert(*index < snapshot.size());
+
+    return snapshot[*index];
 }
 
 bool Channel::canSendMessage() const
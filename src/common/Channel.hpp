@@ -3,6 +3,8 @@
 #include "common/CompletionModel.hpp"
 #include "common/FlagsEnum.hpp"
 #include "messages/LimitedQueue.hpp"
+#include "messages/MessageIndex.hpp"
+#include "messages/SimilarityIndex.hpp"
 
 #include <QDate>
 #include <QString>
@@ -11,6 +13,7 @@
 #include <pajlada/signals/signal.hpp>
 
 #include <memory>
+#include <mutex>
 
 namespace chatterino {
 
@@ -43,7 +46,8 @@ public:
         Misc
     };
 
-    explicit Channel(const QString &name, Type type);
+    explicit Channel(const QString &name, Type type,
+                     size_t messageLimit = 1000);
     virtual ~Channel();
 
     // SIGNALS
@@ -79,6 +83,15 @@ public:
     void replaceMessage(size_t index, MessagePtr replacement);
     void deleteMessage(QString messageID);
     MessagePtr findMessage(QString messageID);
+    // Returns the messages sent by or targeting (e.g. timeouts) a user,
+    // oldest first
+    std::vector<MessagePtr> findUserMessages(const QString &userName);
+    // Returns the recent messages a new message is compared with to find
+    // similar messages, newest first. If loginName is set, only messages of
+    // that user are returned. See IrcMessageHandler::isSimilar
+    std::vector<MessagePtr> findSimilarityCandidates(
+        const boost::optional<QString> &loginName,
+        const SimilarityIndex::Window &window);
 
     bool hasMessages() const;
 
@@ -105,6 +118,14 @@ protected:
 private:
     const QString name_;
     LimitedQueue<MessagePtr> messages_;
+    // guards messageIndex_ and similarityIndex_ and keeps them in sync with
+    // messages_
+    std::mutex messageIndexMutex_;
+    MessageIndex messageIndex_;
+    SimilarityIndex similarityIndex_;
+    // the window of the last findSimilarityCandidates call, the settings
+    // are only read while similar messages are checked
+    SimilarityIndex::Window similarityWindow_;
     Type type_;
     QTimer clearCompletionModelTimer_;
 };
@@ -0,0 +1,208 @@
+#include "common/NetworkBlobStore.hpp"
+
+#include "common/QLogging.hpp"
+#include "util/DebugCount.hpp"
+
+#include <QDir>
+
+namespace chatterino {
+
+namespace {
+
+    const QString segmentPrefix = "segment-";
+
+}  // namespace
+
+NetworkBlobStore::NetworkBlobStore(QString directory, qint64 maxSegmentSize)
+    : directory_(std::move(directory))
+    , maxSegmentSize_(maxSegmentSize)
+{
+    // only lists the few segment files
+    for (const auto &info : QDir(this->directory_)
+                                .entryInfoList({segmentPrefix + "*"},
+                                               QDir::Files | QDir::NoSymLinks))
+    {
+        bool ok = false;
+        auto id = info.fileName().mid(segmentPrefix.size()).toInt(&ok);
+        if (ok)
+        {
+            this->segments_[id].size = info.size();
+            this->current_ = std::max(this->current_, id);
+        }
+    }
+}
+
+bool NetworkBlobStore::isSegmentFile(const QString &fileName)
+{
+    return fileName.startsWith(segmentPrefix);
+}
+
+boost::optional<std::vector<NetworkBlobStore::Location>>
+    NetworkBlobStore::append(const std::vector<QByteArray> &blobs)
+{
+    QByteArray buffer;
+    for (const auto &blob : blobs)
+    {
+        buffer.append(blob);
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    auto *segment = &this->segments_[this->current_];
+    if (segment->size > 0 &&
+        segment->size + buffer.size() > this->maxSegmentSize_)
+    {
+        this->current_++;
+        segment = &this->segments_[this->current_];
+    }
+
+    QFile file(this->segmentPath(this->current_));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        qCWarning(chatterinoCache) << "Failed to open cache segment"
+                                   << this->current_ << file.errorString();
+        return boost::none;
+    }
+
+    if (this->write(file, buffer) != buffer.size())
+    {
+        qCWarning(chatterinoCache) << "Failed to write cache segment"
+                                   << this->current_ << file.errorString();
+
+        // The locations of later blobs start at segment->size, so the bytes
+        // that were written must go. If they can't, later blobs go into a
+        // new segment.
+        if (!file.resize(segment->size))
+        {
+            qCWarning(chatterinoCache)
+                << "Failed to truncate cache segment" << this->current_
+                << file.errorString();
+            this->current_++;
+        }
+
+        return boost::none;
+    }
+
+    std::vector<Location> locations;
+    locations.reserve(blobs.size());
+
+    auto offset = segment->size;
+    for (const auto &blob : blobs)
+    {
+        locations.push_back({this->current_, offset});
+        offset += blob.size();
+    }
+    segment->size = offset;
+
+    return locations;
+}
+
+qint64 NetworkBlobStore::write(QFile &file, const QByteArray &buffer)
+{
+    return file.write(buffer);
+}
+
+boost::optional<QByteArray> NetworkBlobStore::read(Location location,
+                                                   qint64 size)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    auto it = this->segments_.find(location.segment);
+    if (it == this->segments_.end())
+    {
+        return boost::none;
+    }
+
+    auto &segment = it->second;
+    auto end = location.offset + size;
+
+    // segments are remapped after they grew
+    if (end > segment.mappedSize && !this->map(location.segment, segment))
+    {
+        return boost::none;
+    }
+
+    if (end > segment.mappedSize)
+    {
+        return boost::none;
+    }
+
+    return QByteArray(reinterpret_cast<const char *>(segment.data) +
+                          location.offset,
+                      int(size));
+}
+
+std::map<qint32, qint64> NetworkBlobStore::segments()
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    std::map<qint32, qint64> sizes;
+    for (const auto &[id, segment] : this->segments_)
+    {
+        sizes[id] = segment.size;
+    }
+
+    return sizes;
+}
+
+qint32 NetworkBlobStore::currentSegment()
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    return this->current_;
+}
+
+void NetworkBlobStore::removeSegment(qint32 segment)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    // unmaps the segment first, mapped files can't be removed everywhere
+    this->segments_.erase(segment);
+    QFile::remove(this->segmentPath(segment));
+
+    DebugCount::increase("network cache segments removed");
+}
+
+void NetworkBlobStore::clear()
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    this->segments_.clear();
+    this->current_ = 0;
+}
+
+QString NetworkBlobStore::segmentPath(qint32 segment) const
+{
+    return this->directory_ + "/" + segmentPrefix + QString::number(segment);
+}
+
+bool NetworkBlobStore::map(qint32 id, Segment &segment)
+{
+    if (segment.file)
+    {
+        segment.file->unmap(segment.data);
+    }
+    segment.data = nullptr;
+    segment.mappedSize = 0;
+
+    segment.file = std::make_unique<QFile>(this->segmentPath(id));
+    if (!segment.file->open(QIODevice::ReadOnly))
+    {
+        segment.file.reset();
+        return false;
+    }
+
+    auto size = segment.file->size();
+    segment.data = segment.file->map(0, size);
+    if (segment.data == nullptr)
+    {
+        segment.file.reset();
+        return false;
+    }
+
+    segment.mappedSize = size;
+
+    return true;
+}
+
+}  // namespace chatterino
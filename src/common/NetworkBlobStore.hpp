@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace chatterino {
+
+/// NetworkBlobStore packs many small blobs into a few large segment files.
+///
+/// Blobs are only ever appended to the newest segment, a whole batch with a
+/// single write. Segments are memory mapped for reading. Blobs can't be
+/// removed on their own, the owner of the index copies the blobs it still
+/// needs out of a segment and then removes the whole segment.
+///
+/// This class is thread safe.
+class NetworkBlobStore : boost::noncopyable
+{
+public:
+    struct Location {
+        qint32 segment = -1;
+        qint64 offset = 0;
+    };
+
+    // A new segment is started once the current one would grow larger
+    static constexpr qint64 defaultMaxSegmentSize = 64 * 1024 * 1024;
+
+    explicit NetworkBlobStore(
+        QString directory, qint64 maxSegmentSize = defaultMaxSegmentSize);
+    virtual ~NetworkBlobStore() = default;
+
+    static bool isSegmentFile(const QString &fileName);
+
+    /// Appends blobs to the current segment. Returns their locations in the
+    /// same order, or none if writing failed.
+    boost::optional<std::vector<Location>> append(
+        const std::vector<QByteArray> &blobs);
+    /// Returns none if the blob can't be read, e.g. because its segment has
+    /// been removed
+    boost::optional<QByteArray> read(Location location, qint64 size);
+
+    /// Returns the sizes of all segments
+    std::map<qint32, qint64> segments();
+    qint32 currentSegment();
+    void removeSegment(qint32 segment);
+    /// Forgets all segments, their files are deleted by the caller
+    void clear();
+
+protected:
+    // Appends buffer to the open segment file, returns the number of bytes
+    // written
+    virtual qint64 write(QFile &file, const QByteArray &buffer);
+
+private:
+    struct Segment {
+        qint64 size = 0;
+        // mapped for reading, may be smaller than size
+        std::unique_ptr<QFile> file;
+        uchar *data = nullptr;
+        qint64 mappedSize = 0;
+    };
+
+    QString segmentPath(qint32 segment) const;
+    bool map(qint32 id, Segment &segment);
+
+    const QString directory_;
+    const qint64 maxSegmentSize_;
+
+    std::mutex mutex_;
+    std::map<qint32, Segment> segments_;
+    qint32 current_ = 0;
+};
+
+}  // namespace chatterino
@@ -0,0 +1,623 @@
+#include "common/NetworkCache.hpp"
+
+#include "common/QLogging.hpp"
+#include "singletons/Paths.hpp"
+#include "util/DebugCount.hpp"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace chatterino {
+
+namespace {
+
+    const QString indexFileName = "cache-index";
+    // bump when the format of the index changes
+    constexpr quint32 indexVersion = 2;
+    constexpr qint64 defaultMaxBytes = qint64(1024) * 1024 * 1024;
+
+    // new responses are collected for this long before they are written
+    constexpr auto batchDelay = std::chrono::seconds(2);
+    // lastAccess is only updated when it is older than this, so reading a
+    // response doesn't dirty the index every time
+    constexpr qint64 accessGranularity = 60 * 60;
+
+    qint64 currentTime()
+    {
+        return QDateTime::currentSecsSinceEpoch();
+    }
+
+    std::mutex cachesMutex;
+    // never destroyed, requests might still be running on exit
+    auto *caches = new std::unordered_map<QString, NetworkCache *>;
+
+}  // namespace
+
+bool NetworkCache::Entry::isExpired(qint64 now) const
+{
+    return this->expires != 0 && this->expires <= now;
+}
+
+NetworkCache &NetworkCache::instance()
+{
+    auto directory = getPaths()->cacheDirectory();
+
+    std::lock_guard<std::mutex> lock(cachesMutex);
+
+    auto &cache = (*caches)[directory];
+    if (cache == nullptr)
+    {
+        cache = new NetworkCache(directory, defaultMaxBytes);
+    }
+
+    return *cache;
+}
+
+void NetworkCache::flushAll()
+{
+    std::lock_guard<std::mutex> lock(cachesMutex);
+
+    for (auto &&cache : *caches)
+    {
+        cache.second->flush();
+    }
+}
+
+NetworkCache::NetworkCache(QString directory, qint64 maxBytes,
+                           qint64 maxSegmentSize)
+    : directory_(std::move(directory))
+    , maxBytes_(maxBytes)
+    , blobs_(this->directory_, maxSegmentSize)
+{
+    this->loadIndex();
+
+    this->thread_ = std::thread([this] {
+        this->run();
+    });
+}
+
+NetworkCache::~NetworkCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->stopping_ = true;
+    }
+    this->condition_.notify_one();
+    this->thread_.join();
+
+    this->flush();
+}
+
+boost::optional<NetworkCache::Entry> NetworkCache::find(const QString &key)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    auto it = this->entries_.find(key);
+    if (it == this->entries_.end())
+    {
+        return boost::none;
+    }
+
+    return it->second;
+}
+
+boost::optional<QByteArray> NetworkCache::read(const QString &key)
+{
+    Entry entry;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        auto it = this->entries_.find(key);
+        if (it == this->entries_.end())
+        {
+            return boost::none;
+        }
+
+        auto now = currentTime();
+        if (now - it->second.lastAccess > accessGranularity)
+        {
+            it->second.lastAccess = now;
+            this->indexDirty_ = true;
+        }
+
+        auto pending = this->pending_.find(key);
+        if (pending != this->pending_.end())
+        {
+            return pending->second;
+        }
+
+        entry = it->second;
+    }
+
+    if (entry.location.segment >= 0)
+    {
+        if (auto bytes = this->blobs_.read(entry.location, entry.size))
+        {
+            return bytes;
+        }
+    }
+    else
+    {
+        QFile file(this->filePath(key));
+        if (file.open(QIODevice::ReadOnly))
+        {
+            return file.readAll();
+        }
+    }
+
+    // removed behind our back
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    auto it = this->entries_.find(key);
+    if (it != this->entries_.end() && !this->pending_.count(key) &&
+        it->second.location.segment == entry.location.segment &&
+        it->second.location.offset == entry.location.offset)
+    {
+        this->totalBytes_ -= it->second.size;
+        this->entries_.erase(it);
+        this->indexDirty_ = true;
+    }
+
+    return boost::none;
+}
+
+void NetworkCache::write(const QString &key, const QByteArray &bytes,
+                         QByteArray etag, qint64 expires)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        auto &entry = this->entries_[key];
+        this->totalBytes_ += bytes.size() - entry.size;
+
+        // a response moving into a segment leaves its file behind
+        if (entry.size != 0 && entry.location.segment < 0 &&
+            !this->pending_.count(key))
+        {
+            this->staleFiles_.push_back(key);
+        }
+
+        entry.size = bytes.size();
+        entry.lastAccess = currentTime();
+        entry.expires = expires;
+        entry.etag = std::move(etag);
+        // the previous response is left behind in its segment
+        entry.location = {};
+
+        this->pending_[key] = bytes;
+        this->indexDirty_ = true;
+    }
+
+    this->scheduleFlush();
+}
+
+void NetworkCache::refresh(const QString &key, qint64 expires)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        auto it = this->entries_.find(key);
+        if (it == this->entries_.end())
+        {
+            return;
+        }
+
+        it->second.expires = expires;
+        it->second.lastAccess = currentTime();
+        this->indexDirty_ = true;
+    }
+
+    this->scheduleFlush();
+}
+
+void NetworkCache::clear()
+{
+    // a flush running at the same time could write files again which
+    // nothing refers to anymore
+    std::lock_guard<std::mutex> flushLock(this->flushMutex_);
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    this->blobs_.clear();
+
+    QDir dir(this->directory_);
+    dir.removeRecursively();
+    dir.mkpath(this->directory_);
+
+    this->entries_.clear();
+    this->pending_.clear();
+    this->staleFiles_.clear();
+    this->totalBytes_ = 0;
+    this->indexDirty_ = false;
+}
+
+void NetworkCache::flush()
+{
+    std::lock_guard<std::mutex> flushLock(this->flushMutex_);
+
+    std::unordered_map<QString, QByteArray> written;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        written = this->pending_;
+    }
+
+    // write the responses without blocking lookups, small ones with a single
+    // append to the current segment
+    std::vector<QString> blobKeys;
+    std::vector<QByteArray> blobs;
+    for (const auto &[key, bytes] : written)
+    {
+        if (bytes.size() <= maxBlobSize)
+        {
+            blobKeys.push_back(key);
+            blobs.push_back(bytes);
+            continue;
+        }
+
+        QFile file(this->filePath(key));
+        if (file.open(QIODevice::WriteOnly))
+        {
+            file.write(bytes);
+        }
+    }
+
+    auto locations = blobs.empty()
+                         ? std::vector<NetworkBlobStore::Location>()
+                         : this->blobs_.append(blobs).value_or(
+                               std::vector<NetworkBlobStore::Location>());
+
+    std::vector<QString> removedFiles;
+    std::vector<std::pair<QString, Entry>> moved;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        for (size_t i = 0; i < blobKeys.size(); i++)
+        {
+            auto it = this->entries_.find(blobKeys[i]);
+            if (it == this->entries_.end())
+            {
+                continue;
+            }
+
+            // the response might have been replaced in the meantime
+            auto pending = this->pending_.find(blobKeys[i]);
+            if (pending == this->pending_.end() ||
+                pending->second.constData() != blobs[i].constData())
+            {
+                continue;
+            }
+
+            if (i < locations.size())
+            {
+                it->second.location = locations[i];
+            }
+            else
+            {
+                // writing the segment failed
+                this->totalBytes_ -= it->second.size;
+                this->entries_.erase(it);
+            }
+        }
+
+        for (const auto &[key, bytes] : written)
+        {
+            auto it = this->pending_.find(key);
+            if (it != this->pending_.end() &&
+                it->second.constData() == bytes.constData())
+            {
+                this->pending_.erase(it);
+            }
+        }
+
+        for (const auto &key : this->staleFiles_)
+        {
+            // the file might have been written again in the meantime
+            auto it = this->entries_.find(key);
+            if (it == this->entries_.end() || it->second.location.segment >= 0)
+            {
+                removedFiles.push_back(key);
+            }
+        }
+        this->staleFiles_.clear();
+
+        // remove responses nobody used for a long time, then the least
+        // recently used ones until we are within the budget
+        auto now = currentTime();
+        std::vector<std::pair<qint64, QString>> byAge;
+        byAge.reserve(this->entries_.size());
+        for (const auto &[key, entry] : this->entries_)
+        {
+            if (!this->pending_.count(key))
+            {
+                byAge.emplace_back(entry.lastAccess, key);
+            }
+        }
+        std::sort(byAge.begin(), byAge.end());
+
+        int64_t evicted = 0;
+        for (const auto &[lastAccess, key] : byAge)
+        {
+            if (now - lastAccess <= maxAgeSeconds &&
+                this->totalBytes_ <= this->maxBytes_)
+            {
+                break;
+            }
+
+            auto it = this->entries_.find(key);
+            if (it->second.location.segment < 0)
+            {
+                removedFiles.push_back(key);
+            }
+            this->totalBytes_ -= it->second.size;
+            this->entries_.erase(it);
+            evicted++;
+        }
+
+        if (evicted != 0)
+        {
+            this->indexDirty_ = true;
+            DebugCount::increase("network cache evictions", evicted);
+        }
+
+        moved = this->planCompaction();
+    }
+
+    // copy the responses which are still used out of mostly empty segments
+    std::vector<QByteArray> movedBlobs;
+    for (const auto &[key, entry] : moved)
+    {
+        movedBlobs.push_back(
+            this->blobs_.read(entry.location, entry.size).value_or(QByteArray()));
+    }
+
+    auto movedLocations = movedBlobs.empty()
+                              ? std::vector<NetworkBlobStore::Location>()
+                              : this->blobs_.append(movedBlobs).value_or(
+                                    std::vector<NetworkBlobStore::Location>());
+
+    std::vector<qint32> unusedSegments;
+    QByteArray index;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        for (size_t i = 0; i < moved.size() && i < movedLocations.size(); i++)
+        {
+            auto it = this->entries_.find(moved[i].first);
+            const auto &from = moved[i].second.location;
+
+            // skip responses which got replaced or couldn't be read
+            if (it == this->entries_.end() ||
+                it->second.location.segment != from.segment ||
+                it->second.location.offset != from.offset ||
+                movedBlobs[i].size() != it->second.size)
+            {
+                continue;
+            }
+
+            it->second.location = movedLocations[i];
+            this->indexDirty_ = true;
+        }
+
+        unusedSegments = this->unusedSegments();
+
+        if (this->indexDirty_)
+        {
+            QDataStream stream(&index, QIODevice::WriteOnly);
+            stream << indexVersion << quint64(this->entries_.size());
+            for (const auto &[key, entry] : this->entries_)
+            {
+                stream << key << entry.size << entry.lastAccess
+                       << entry.expires << entry.etag
+                       << entry.location.segment << entry.location.offset;
+            }
+
+            this->indexDirty_ = false;
+        }
+    }
+
+    // the index has to point away from segments before they are removed
+    if (!index.isEmpty())
+    {
+        this->saveIndex(index);
+    }
+
+    for (const auto &key : removedFiles)
+    {
+        QFile::remove(this->filePath(key));
+    }
+
+    for (auto segment : unusedSegments)
+    {
+        this->blobs_.removeSegment(segment);
+    }
+}
+
+qint64 NetworkCache::totalBytes()
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    return this->totalBytes_;
+}
+
+std::vector<std::pair<QString, NetworkCache::Entry>>
+    NetworkCache::planCompaction()
+{
+    auto segments = this->blobs_.segments();
+    auto current = this->blobs_.currentSegment();
+
+    std::unordered_map<qint32, qint64> liveBytes;
+    for (const auto &[key, entry] : this->entries_)
+    {
+        if (entry.location.segment >= 0 && !this->pending_.count(key))
+        {
+            liveBytes[entry.location.segment] += entry.size;
+        }
+    }
+
+    std::vector<std::pair<QString, Entry>> moved;
+    for (const auto &[key, entry] : this->entries_)
+    {
+        auto segment = entry.location.segment;
+        if (segment < 0 || segment == current || this->pending_.count(key))
+        {
+            continue;
+        }
+
+        // segments which are at least half full are left alone
+        auto size = segments.find(segment);
+        if (size != segments.end() && liveBytes[segment] * 2 < size->second)
+        {
+            moved.emplace_back(key, entry);
+        }
+    }
+
+    return moved;
+}
+
+std::vector<qint32> NetworkCache::unusedSegments()
+{
+    auto segments = this->blobs_.segments();
+    segments.erase(this->blobs_.currentSegment());
+
+    for (const auto &[key, entry] : this->entries_)
+    {
+        segments.erase(entry.location.segment);
+    }
+
+    std::vector<qint32> unused;
+    for (const auto &[segment, size] : segments)
+    {
+        unused.push_back(segment);
+    }
+
+    return unused;
+}
+
+void NetworkCache::loadIndex()
+{
+    QFile file(this->filePath(indexFileName));
+
+    if (file.open(QIODevice::ReadOnly))
+    {
+        QDataStream stream(&file);
+
+        quint32 version = 0;
+        quint64 count = 0;
+        stream >> version >> count;
+
+        // version 1 indexes only know about responses in their own file
+        if (version == 1 || version == indexVersion)
+        {
+            for (quint64 i = 0; i < count && stream.status() == QDataStream::Ok;
+                 i++)
+            {
+                QString key;
+                Entry entry;
+                stream >> key >> entry.size >> entry.lastAccess >>
+                    entry.expires >> entry.etag;
+                if (version == indexVersion)
+                {
+                    stream >> entry.location.segment >> entry.location.offset;
+                }
+
+                this->totalBytes_ += entry.size;
+                this->entries_.emplace(std::move(key), std::move(entry));
+            }
+
+            if (stream.status() == QDataStream::Ok)
+            {
+                this->indexDirty_ = version != indexVersion;
+                return;
+            }
+        }
+
+        qCWarning(chatterinoCache) << "Rebuilding invalid cache index";
+        this->entries_.clear();
+        this->totalBytes_ = 0;
+    }
+
+    // Caches written before the index existed or with a broken index. This
+    // lists the directory once, afterwards the index is used.
+    for (const auto &info :
+         QDir(this->directory_).entryInfoList(QDir::Files | QDir::NoSymLinks))
+    {
+        // responses in segments can't be recovered without the index, the
+        // segments are removed with the next flush
+        if (info.fileName() == indexFileName ||
+            NetworkBlobStore::isSegmentFile(info.fileName()))
+        {
+            continue;
+        }
+
+        Entry entry;
+        entry.size = info.size();
+        entry.lastAccess = info.lastModified().toSecsSinceEpoch();
+
+        this->totalBytes_ += entry.size;
+        this->entries_.emplace(info.fileName(), std::move(entry));
+    }
+
+    this->indexDirty_ = true;
+    this->flushRequested_ = true;
+}
+
+void NetworkCache::saveIndex(const QByteArray &index)
+{
+    QSaveFile file(this->filePath(indexFileName));
+
+    if (!file.open(QIODevice::WriteOnly) || file.write(index) != index.size() ||
+        !file.commit())
+    {
+        qCWarning(chatterinoCache) << "Failed to save cache index";
+    }
+}
+
+void NetworkCache::scheduleFlush()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->flushRequested_ = true;
+    }
+
+    this->condition_.notify_one();
+}
+
+void NetworkCache::run()
+{
+    std::unique_lock<std::mutex> lock(this->mutex_);
+
+    while (!this->stopping_)
+    {
+        this->condition_.wait(lock, [this] {
+            return this->flushRequested_ || this->stopping_;
+        });
+
+        // collect more responses before writing
+        this->condition_.wait_for(lock, batchDelay, [this] {
+            return this->stopping_;
+        });
+
+        this->flushRequested_ = false;
+
+        lock.unlock();
+        this->flush();
+        lock.lock();
+    }
+}
+
+QString NetworkCache::filePath(const QString &key) const
+{
+    return this->directory_ + "/" + key;
+}
+
+}  // namespace chatterino
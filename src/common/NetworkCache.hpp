@@ -0,0 +1,117 @@
+#pragma once
+
+#include "common/NetworkBlobStore.hpp"
+#include "util/QStringHash.hpp"
+
+#include <QByteArray>
+#include <QString>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace chatterino {
+
+/// NetworkCache stores the responses of requests made with
+/// NetworkRequest::cache() in a directory.
+///
+/// An index of all responses is kept in memory and in a file in the same
+/// directory, so looking up a response doesn't touch the disk. New responses
+/// are written in batches by a background thread. Small responses, like most
+/// emotes, are packed into the segments of a NetworkBlobStore, larger ones
+/// get a file each. Once the responses use more than the byte budget, the
+/// least recently used ones are removed and mostly empty segments are
+/// compacted.
+///
+/// This class is thread safe.
+class NetworkCache : boost::noncopyable
+{
+public:
+    struct Entry {
+        qint64 size = 0;
+        // seconds since epoch
+        qint64 lastAccess = 0;
+        // seconds since epoch, 0 if the response has no expiry
+        qint64 expires = 0;
+        QByteArray etag;
+        // where the response is stored, segment is -1 for responses stored
+        // in their own file
+        NetworkBlobStore::Location location;
+
+        bool isExpired(qint64 now) const;
+    };
+
+    // Responses not used for this long are removed
+    static constexpr qint64 maxAgeSeconds = 14 * 24 * 60 * 60;
+    // Larger responses are stored in their own file
+    static constexpr qint64 maxBlobSize = 1024 * 1024;
+
+    /// The cache for the current cache directory, see Paths::cacheDirectory
+    static NetworkCache &instance();
+    /// Flushes the caches created by instance(). They are never destroyed,
+    /// so this has to be called on exit to keep the last batch.
+    static void flushAll();
+
+    NetworkCache(QString directory, qint64 maxBytes,
+                 qint64 maxSegmentSize =
+                     NetworkBlobStore::defaultMaxSegmentSize);
+    ~NetworkCache();
+
+    /// Returns the entry for key without touching the disk
+    boost::optional<Entry> find(const QString &key);
+    /// Returns the stored response and marks it as used. Returns none if it
+    /// isn't cached (anymore).
+    boost::optional<QByteArray> read(const QString &key);
+    /// Stores a response, it is written to disk with the next batch
+    void write(const QString &key, const QByteArray &bytes, QByteArray etag,
+               qint64 expires);
+    /// Updates the expiry of a response the server confirmed to be unchanged
+    void refresh(const QString &key, qint64 expires);
+    /// Removes all responses
+    void clear();
+
+    /// Writes pending responses and the index to disk right away
+    void flush();
+
+    qint64 totalBytes();
+
+private:
+    void loadIndex();
+    void saveIndex(const QByteArray &index);
+    void scheduleFlush();
+    void run();
+    QString filePath(const QString &key) const;
+
+    // Returns the entries of mostly empty segments, which are copied to the
+    // current segment
+    std::vector<std::pair<QString, Entry>> planCompaction();
+    // Returns the segments no entry is stored in anymore
+    std::vector<qint32> unusedSegments();
+
+    const QString directory_;
+    const qint64 maxBytes_;
+    NetworkBlobStore blobs_;
+    // only one flush at a time
+    std::mutex flushMutex_;
+
+    std::mutex mutex_;
+    std::unordered_map<QString, Entry> entries_;
+    // responses which haven't been written to disk yet
+    std::unordered_map<QString, QByteArray> pending_;
+    // files of responses which were moved into a segment
+    std::vector<QString> staleFiles_;
+    qint64 totalBytes_ = 0;
+    bool indexDirty_ = false;
+
+    // background writer
+    std::condition_variable condition_;
+    bool flushRequested_ = false;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+}  // namespace chatterino
@@ -1,16 +1,17 @@
 #include "common/NetworkPrivate.hpp"
 
+#include "common/NetworkCache.hpp"
 #include "common/NetworkManager.hpp"
 #include "common/NetworkResult.hpp"
 #include "common/Outcome.hpp"
 #include "debug/AssertInGuiThread.hpp"
-#include "singletons/Paths.hpp"
 #include "util/DebugCount.hpp"
 #include "util/PostToThread.hpp"
 
 #include <QCryptographicHash>
-#include <QFile>
+#include <QDateTime>
 #include <QNetworkReply>
+#include <QRegularExpression>
 #include <QtConcurrent>
 #include "common/QLogging.hpp"
 
@@ -55,20 +56,50 @@ QString NetworkData::getHash()
     return this->hash_;
 }
 
+namespace {
+
+    // Returns when a response has to be revalidated according to its
+    // headers, 0 if it doesn't say
+    qint64 expiresAt(QNetworkReply *reply)
+    {
+        auto now = QDateTime::currentSecsSinceEpoch();
+        auto cacheControl = QString(reply->rawHeader("Cache-Control"));
+
+        if (cacheControl.contains("no-cache") ||
+            cacheControl.contains("no-store"))
+        {
+            return now;
+        }
+
+        static const QRegularExpression maxAgeRegex(R"(max-age=(\d+))");
+        auto match = maxAgeRegex.match(cacheControl);
+        if (match.hasMatch())
+        {
+            return now + match.captured(1).toLongLong();
+        }
+
+        if (reply->hasRawHeader("Expires"))
+        {
+            auto expires = QDateTime::fromString(
+                QString(reply->rawHeader("Expires")), Qt::RFC2822Date);
+
+            // invalid dates like "0" mean already expired
+            return expires.isValid() ? expires.toSecsSinceEpoch() : now;
+        }
+
+        return 0;
+    }
+
+}  // namespace
+
 void writeToCache(const std::shared_ptr<NetworkData> &data,
-                  const QByteArray &bytes)
+                  QNetworkReply *reply, const QByteArray &bytes)
 {
     if (data->cache_)
     {
-        QtConcurrent::run([data, bytes] {
-            QFile cachedFile(getPaths()->cacheDirectory() + "/" +
-                             data->getHash());
-
-            if (cachedFile.open(QIODevice::WriteOnly))
-            {
-                cachedFile.write(bytes);
-            }
-        });
+        NetworkCache::instance().write(data->getHash(), bytes,
+                                       reply->rawHeader("ETag"),
+                                       expiresAt(reply));
     }
 }
 
@@ -233,11 +264,22 @@ void loadUncached(const std::shared_ptr<NetworkData> &data)
             }
 
             QByteArray bytes = reply->readAll();
-            writeToCache(data, bytes);
-
             auto status =
                 reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
 
+            if (status.toInt() == 304 && !data->cachedBytes_.isNull())
+            {
+                // our cached response is still up to date
+                bytes = data->cachedBytes_;
+                status = 200;
+                NetworkCache::instance().refresh(data->getHash(),
+                                                 expiresAt(reply));
+            }
+            else
+            {
+                writeToCache(data, reply, bytes);
+            }
+
             NetworkResult result(bytes, status.toInt());
 
             DebugCount::increase("http request success");
@@ -318,18 +360,38 @@ void loadUncached(const std::shared_ptr<NetworkData> &data)
 // First tried to load cached, then uncached.
 void loadCached(const std::shared_ptr<NetworkData> &data)
 {
-    QFile cachedFile(getPaths()->cacheDirectory() + "/" + data->getHash());
+    auto &cache = NetworkCache::instance();
+    // computes the hash before the request is changed below
+    auto key = data->getHash();
+
+    auto entry = cache.find(key);
+    boost::optional<QByteArray> cached;
+    if (entry)
+    {
+        cached = cache.read(key);
+    }
 
-    if (!cachedFile.exists() || !cachedFile.open(QIODevice::ReadOnly))
+    if (!cached)
     {
-        // File didn't exist OR File could not be opened
+        loadUncached(data);
+        return;
+    }
+    else if (entry->isExpired(QDateTime::currentSecsSinceEpoch()))
+    {
+        // ask the server whether our response is still up to date
+        if (!entry->etag.isEmpty())
+        {
+            data->request_.setRawHeader("If-None-Match", entry->etag);
+            data->cachedBytes_ = *cached;
+        }
+
         loadUncached(data);
         return;
     }
     else
     {
         // XXX: check if bytes is empty?
-        QByteArray bytes = cachedFile.readAll();
+        QByteArray bytes = *cached;
         NetworkResult result(bytes, 200);
 
         qCDebug(chatterinoHTTP)
@@ -61,6 +61,10 @@ struct NetworkData {
     QTimer *timer_ = nullptr;
     QObject *lifetimeManager_;
 
+    // expired response from the NetworkCache which is used if the server
+    // responds with 304 Not Modified
+    QByteArray cachedBytes_;
+
     QString getHash();
 
 private:
@@ -11,6 +11,7 @@
 #include <QUuid>
 #include <pajlada/serialize.hpp>
 
+#include <atomic>
 #include <memory>
 
 namespace chatterino {
@@ -29,6 +30,7 @@ public:
         , filter_(filter)
         , id_(QUuid::createUuid())
         , parser_(std::make_unique<filterparser::FilterParser>(filter))
+        , cacheKey_(nextCacheKey())
     {
     }
 
@@ -37,6 +39,7 @@ public:
         , filter_(filter)
         , id_(id)
         , parser_(std::make_unique<filterparser::FilterParser>(filter))
+        , cacheKey_(nextCacheKey())
     {
     }
 
@@ -60,17 +63,43 @@ public:
         return this->parser_->valid();
     }
 
-    bool filter(const filterparser::ContextMap &context) const
+    bool filter(const filterparser::FilterContext &context) const
     {
         return this->parser_->execute(context);
     }
 
+    /// Results of filters which only depend on the message are remembered in
+    /// Message::filterResults
+    bool isCacheable() const
+    {
+        return this->parser_->isCacheable();
+    }
+
+    /// Identifies this filter and its version in Message::filterResults
+    uint64_t cacheKey() const
+    {
+        return this->cacheKey_;
+    }
+
+    /// Makes results remembered for the previous version unreachable
+    void bumpVersion()
+    {
+        this->cacheKey_ = nextCacheKey();
+    }
+
 private:
+    static uint64_t nextCacheKey()
+    {
+        static std::atomic<uint64_t> nextKey{1};
+        return nextKey++;
+    }
+
     QString name_;
     QString filter_;
     QUuid id_;
 
     std::unique_ptr<filterparser::FilterParser> parser_;
+    uint64_t cacheKey_;
 };
 
 using FilterRecordPtr = std::shared_ptr<FilterRecord>;
@@ -3,6 +3,8 @@
 #include "controllers/filters/FilterRecord.hpp"
 #include "singletons/Settings.hpp"
 
+#include <boost/optional.hpp>
+
 namespace chatterino {
 
 class FilterSet
@@ -41,11 +43,32 @@ public:
         if (this->filters_.size() == 0)
             return true;
 
-        filterparser::ContextMap context =
-            filterparser::buildContextMap(m, channel.get());
-        for (const auto &f : this->filters_.values())
+        // message values are only computed once a filter needs them
+        boost::optional<filterparser::FilterContext> context;
+        for (const auto &f : this->filters_)
         {
-            if (!f->valid() || !f->filter(context))
+            if (!f->valid())
+                return false;
+
+            // other views using the same filter might have run it already
+            if (f->isCacheable())
+            {
+                if (auto result = m->filterResults.get(f->cacheKey()))
+                {
+                    if (!*result)
+                        return false;
+                    continue;
+                }
+            }
+
+            if (!context)
+                context.emplace(m, channel.get());
+
+            bool result = f->filter(*context);
+            if (f->isCacheable())
+                m->filterResults.set(f->cacheKey(), result);
+
+            if (!result)
                 return false;
         }
 
@@ -72,6 +95,8 @@ private:
                 if (f->getId() == key)
                 {
                     found = true;
+                    // results remembered on messages might be outdated
+                    f->bumpVersion();
                     this->filters_.insert(key, f);
                 }
             }
@@ -0,0 +1,158 @@
+#include "controllers/filters/parser/FilterContext.hpp"
+
+#include "Application.hpp"
+#include "common/Channel.hpp"
+#include "providers/twitch/TwitchChannel.hpp"
+#include "providers/twitch/TwitchIrcServer.hpp"
+#include "util/QStringHash.hpp"
+
+#include <unordered_map>
+
+namespace filterparser {
+
+boost::optional<Identifier> identifierFromString(const QString &name)
+{
+    static const std::unordered_map<QString, Identifier> identifiers = {
+        {"author.badges", Identifier::AuthorBadges},
+        {"author.color", Identifier::AuthorColor},
+        {"author.name", Identifier::AuthorName},
+        {"author.no_color", Identifier::AuthorNoColor},
+        {"author.subbed", Identifier::AuthorSubbed},
+        {"author.sub_length", Identifier::AuthorSubLength},
+
+        {"channel.name", Identifier::ChannelName},
+        {"channel.watching", Identifier::ChannelWatching},
+        {"channel.live", Identifier::ChannelLive},
+
+        {"flags.highlighted", Identifier::FlagsHighlighted},
+        {"flags.points_redeemed", Identifier::FlagsPointsRedeemed},
+        {"flags.sub_message", Identifier::FlagsSubMessage},
+        {"flags.system_message", Identifier::FlagsSystemMessage},
+        {"flags.reward_message", Identifier::FlagsRewardMessage},
+        {"flags.first_message", Identifier::FlagsFirstMessage},
+        {"flags.whisper", Identifier::FlagsWhisper},
+
+        {"message.content", Identifier::MessageContent},
+        {"message.length", Identifier::MessageLength},
+    };
+
+    auto it = identifiers.find(name);
+    if (it == identifiers.end())
+    {
+        return boost::none;
+    }
+    return it->second;
+}
+
+ValueType identifierType(Identifier identifier)
+{
+    switch (identifier)
+    {
+        case Identifier::AuthorBadges:
+            return ValueType::StringList;
+        case Identifier::AuthorColor:
+            return ValueType::Variant;
+        case Identifier::AuthorName:
+        case Identifier::ChannelName:
+        case Identifier::MessageContent:
+            return ValueType::String;
+        case Identifier::AuthorSubLength:
+        case Identifier::MessageLength:
+            return ValueType::Int;
+        default:
+            return ValueType::Bool;
+    }
+}
+
+FilterContext::FilterContext(MessagePtr message, chatterino::Channel *channel)
+    : message_(std::move(message))
+    , channel_(channel)
+{
+}
+
+const chatterino::Message &FilterContext::message() const
+{
+    return *this->message_;
+}
+
+const QStringList &FilterContext::badges() const
+{
+    if (!this->badges_)
+    {
+        QStringList badges;
+        badges.reserve(this->message_->badges.size());
+        for (const auto &e : this->message_->badges)
+        {
+            badges << e.key_;
+        }
+        this->badges_ = std::move(badges);
+    }
+
+    return *this->badges_;
+}
+
+bool FilterContext::subscribed() const
+{
+    this->computeSubscription();
+    return *this->subscribed_;
+}
+
+int FilterContext::subLength() const
+{
+    this->computeSubscription();
+    return this->subLength_;
+}
+
+bool FilterContext::watching() const
+{
+    if (!this->watching_)
+    {
+        auto watchingChannel =
+            chatterino::getApp()->twitch->watchingChannel.get();
+
+        this->watching_ = !watchingChannel->getName().isEmpty() &&
+                          watchingChannel->getName().compare(
+                              this->message_->channelName,
+                              Qt::CaseInsensitive) == 0;
+    }
+
+    return *this->watching_;
+}
+
+bool FilterContext::live() const
+{
+    if (!this->live_)
+    {
+        auto *tc = dynamic_cast<chatterino::TwitchChannel *>(this->channel_);
+        this->live_ = this->channel_ && !this->channel_->isEmpty() && tc &&
+                      tc->isLive();
+    }
+
+    return *this->live_;
+}
+
+void FilterContext::computeSubscription() const
+{
+    if (this->subscribed_)
+    {
+        return;
+    }
+
+    this->subscribed_ = false;
+    for (const QString &subBadge : {"subscriber", "founder"})
+    {
+        if (!this->badges().contains(subBadge))
+        {
+            continue;
+        }
+        this->subscribed_ = true;
+
+        auto it = this->message_->badgeInfos.find(subBadge);
+        if (it != this->message_->badgeInfos.end())
+        {
+            this->subLength_ = it->second.toInt();
+        }
+    }
+}
+
+}  // namespace filterparser
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "controllers/filters/parser/Types.hpp"
+
+#include <QStringList>
+#include <boost/optional.hpp>
+
+namespace chatterino {
+
+class Channel;
+
+}  // namespace chatterino
+
+namespace filterparser {
+
+/// Identifiers which can be used in filters
+enum class Identifier : uint8_t {
+    AuthorBadges,
+    AuthorColor,
+    AuthorName,
+    AuthorNoColor,
+    AuthorSubbed,
+    AuthorSubLength,
+
+    ChannelName,
+    ChannelWatching,
+    ChannelLive,
+
+    FlagsHighlighted,
+    FlagsPointsRedeemed,
+    FlagsSubMessage,
+    FlagsSystemMessage,
+    FlagsRewardMessage,
+    FlagsFirstMessage,
+    FlagsWhisper,
+
+    MessageContent,
+    MessageLength,
+};
+
+/// Resolves an identifier like "author.name"
+boost::optional<Identifier> identifierFromString(const QString &name);
+
+/// Type of the value an identifier stands for
+ValueType identifierType(Identifier identifier);
+
+/// The message a filter is run on. Values which are expensive to compute
+/// are only computed once a filter asks for them, and then shared by all
+/// filters run with the same context.
+class FilterContext
+{
+public:
+    FilterContext(MessagePtr message, chatterino::Channel *channel);
+
+    const chatterino::Message &message() const;
+
+    const QStringList &badges() const;
+    bool subscribed() const;
+    int subLength() const;
+    bool watching() const;
+    bool live() const;
+
+private:
+    void computeSubscription() const;
+
+    MessagePtr message_;
+    chatterino::Channel *channel_;
+
+    mutable boost::optional<QStringList> badges_;
+    mutable boost::optional<bool> subscribed_;
+    mutable int subLength_ = 0;
+    mutable boost::optional<bool> watching_;
+    mutable boost::optional<bool> live_;
+};
+
+}  // namespace filterparser
@@ -1,24 +1,20 @@
 #pragma once
 
+#include "controllers/filters/parser/FilterContext.hpp"
+#include "controllers/filters/parser/FilterProgram.hpp"
 #include "controllers/filters/parser/Tokenizer.hpp"
 #include "controllers/filters/parser/Types.hpp"
 
-namespace chatterino {
-
-class Channel;
-
-}  // namespace chatterino
-
 namespace filterparser {
 
-ContextMap buildContextMap(const MessagePtr &m, chatterino::Channel *channel);
-
 class FilterParser
 {
 public:
     FilterParser(const QString &text);
-    bool execute(const ContextMap &context) const;
+    bool execute(const FilterContext &context) const;
     bool valid() const;
+    /// Returns true if the result for a message never changes
+    bool isCacheable() const;
 
     const QStringList &errors() const;
     const QString debugString() const;
@@ -41,5 +37,6 @@ private:
     QString text_;
     Tokenizer tokenizer_;
     ExpressionPtr builtExpression_;
+    FilterProgram program_;
 };
 }  // namespace filterparser
@@ -0,0 +1,460 @@
+#include "controllers/filters/parser/FilterProgram.hpp"
+
+#include "controllers/filters/parser/FilterContext.hpp"
+
+#include <algorithm>
+
+namespace filterparser {
+
+namespace {
+
+    using Value = FilterProgram::Value;
+
+    Value boolValue(bool boolean)
+    {
+        Value value;
+        value.type = ValueType::Bool;
+        value.boolean = boolean;
+        return value;
+    }
+
+    Value intValue(int integer)
+    {
+        Value value;
+        value.type = ValueType::Int;
+        value.integer = integer;
+        return value;
+    }
+
+    Value stringValue(QString string)
+    {
+        Value value;
+        value.type = ValueType::String;
+        value.string = std::move(string);
+        return value;
+    }
+
+    Value variantValue(QVariant variant)
+    {
+        Value value;
+        value.type = ValueType::Variant;
+        value.variant = std::move(variant);
+        return value;
+    }
+
+    Value loadIdentifier(const FilterContext &context, Identifier identifier)
+    {
+        using MessageFlag = chatterino::MessageFlag;
+        const auto &message = context.message();
+
+        switch (identifier)
+        {
+            case Identifier::AuthorBadges: {
+                Value value;
+                value.type = ValueType::StringList;
+                value.list = context.badges();
+                return value;
+            }
+            case Identifier::AuthorColor:
+                return variantValue(message.usernameColor);
+            case Identifier::AuthorName:
+                return stringValue(message.displayName);
+            case Identifier::AuthorNoColor:
+                return boolValue(!message.usernameColor.isValid());
+            case Identifier::AuthorSubbed:
+                return boolValue(context.subscribed());
+            case Identifier::AuthorSubLength:
+                return intValue(context.subLength());
+
+            case Identifier::ChannelName:
+                return stringValue(message.channelName);
+            case Identifier::ChannelWatching:
+                return boolValue(context.watching());
+            case Identifier::ChannelLive:
+                return boolValue(context.live());
+
+            case Identifier::FlagsHighlighted:
+                return boolValue(message.flags.has(MessageFlag::Highlighted));
+            case Identifier::FlagsPointsRedeemed:
+                return boolValue(
+                    message.flags.has(MessageFlag::RedeemedHighlight));
+            case Identifier::FlagsSubMessage:
+                return boolValue(message.flags.has(MessageFlag::Subscription));
+            case Identifier::FlagsSystemMessage:
+                return boolValue(message.flags.has(MessageFlag::System));
+            case Identifier::FlagsRewardMessage:
+                return boolValue(
+                    message.flags.has(MessageFlag::RedeemedChannelPointReward));
+            case Identifier::FlagsFirstMessage:
+                return boolValue(message.flags.has(MessageFlag::FirstMessage));
+            case Identifier::FlagsWhisper:
+                return boolValue(message.flags.has(MessageFlag::Whisper));
+
+            case Identifier::MessageContent:
+                return stringValue(message.messageText);
+            case Identifier::MessageLength:
+                return intValue(message.messageText.length());
+        }
+
+        return variantValue(QVariant());
+    }
+
+    // Change of the stack size caused by an instruction
+    int stackEffect(FilterProgram::Op op, int arg)
+    {
+        using Op = FilterProgram::Op;
+
+        switch (op)
+        {
+            case Op::PushConstant:
+            case Op::PushIdentifier:
+                return 1;
+            case Op::MakeList:
+            case Op::MakeStringList:
+                return 1 - arg;
+            case Op::Nop:
+            case Op::AndJump:
+            case Op::OrJump:
+            case Op::Not:
+            case Op::Unary:
+                return 0;
+            default:
+                return -1;
+        }
+    }
+
+}  // namespace
+
+FilterProgram::FilterProgram(const Expression &expression)
+{
+    expression.compile(*this);
+}
+
+bool FilterProgram::execute(const FilterContext &context) const
+{
+    std::vector<Value> stack;
+    stack.reserve(this->maxStackSize_);
+
+    for (size_t pc = 0; pc < this->instructions_.size(); pc++)
+    {
+        const auto &instruction = this->instructions_[pc];
+
+        switch (instruction.op)
+        {
+            case Op::Nop:
+                break;
+
+            case Op::PushConstant:
+                stack.push_back(this->constants_[instruction.arg]);
+                break;
+
+            case Op::PushIdentifier:
+                stack.push_back(
+                    loadIdentifier(context, Identifier(instruction.arg)));
+                break;
+
+            case Op::MakeList:
+            case Op::MakeStringList: {
+                auto first = stack.size() - size_t(instruction.arg);
+                auto list =
+                    this->makeList(stack.data() + first, instruction.arg,
+                                   instruction.op == Op::MakeStringList);
+                stack.resize(first);
+                stack.push_back(std::move(list));
+            }
+            break;
+
+            case Op::AndJump: {
+                bool ok;
+                if (!this->toBool(stack.back(), ok) || !ok)
+                {
+                    stack.back() = boolValue(false);
+                    pc = size_t(instruction.arg) - 1;
+                }
+            }
+            break;
+
+            case Op::OrJump: {
+                bool ok;
+                if (this->toBool(stack.back(), ok) && ok)
+                {
+                    stack.back() = boolValue(true);
+                    pc = size_t(instruction.arg) - 1;
+                }
+            }
+            break;
+
+            case Op::Not:
+                stack.back().boolean = !stack.back().boolean;
+                break;
+
+            case Op::Unary:
+                stack.back() = variantValue(evaluateUnaryOperation(
+                    TokenType(instruction.arg), this->toVariant(stack.back())));
+                break;
+
+            default: {
+                auto right = std::move(stack.back());
+                stack.pop_back();
+                stack.back() =
+                    this->evaluateBinary(instruction, stack.back(), right);
+            }
+            break;
+        }
+    }
+
+    bool ok;
+    return this->toBool(stack.back(), ok);
+}
+
+bool FilterProgram::usesChannelState() const
+{
+    return this->usesChannelState_;
+}
+
+void FilterProgram::emit(Op op, int arg)
+{
+    this->instructions_.push_back({op, arg});
+
+    if (op == Op::PushIdentifier &&
+        (Identifier(arg) == Identifier::ChannelLive ||
+         Identifier(arg) == Identifier::ChannelWatching))
+    {
+        this->usesChannelState_ = true;
+    }
+
+    this->stackSize_ += stackEffect(op, arg);
+    this->maxStackSize_ = std::max(this->maxStackSize_, this->stackSize_);
+}
+
+void FilterProgram::emitConstant(Value value)
+{
+    this->constants_.push_back(std::move(value));
+    this->emit(Op::PushConstant, int(this->constants_.size() - 1));
+}
+
+void FilterProgram::emitRegex(const QRegularExpression &regex)
+{
+    this->regexes_.push_back(regex);
+    this->regexes_.back().optimize();
+
+    Value value;
+    value.type = ValueType::RegularExpression;
+    value.integer = int(this->regexes_.size() - 1);
+    this->emitConstant(std::move(value));
+}
+
+void FilterProgram::emitList(int count, bool allStrings)
+{
+    auto first = this->instructions_.end() - count;
+    bool constant = std::all_of(first, this->instructions_.end(),
+                                [](const Instruction &instruction) {
+                                    return instruction.op == Op::PushConstant;
+                                });
+
+    if (!constant)
+    {
+        this->emit(allStrings ? Op::MakeStringList : Op::MakeList, count);
+        return;
+    }
+
+    // lists of literals are built right away
+    std::vector<Value> items;
+    for (auto it = first; it != this->instructions_.end(); ++it)
+    {
+        items.push_back(this->constants_[it->arg]);
+    }
+
+    this->instructions_.erase(first, this->instructions_.end());
+    this->stackSize_ -= count;
+
+    this->emitConstant(this->makeList(items.data(), count, allStrings));
+}
+
+size_t FilterProgram::emitJump(Op op)
+{
+    this->emit(op);
+    return this->instructions_.size() - 1;
+}
+
+void FilterProgram::patchJump(size_t jump)
+{
+    this->instructions_[jump].arg = int(this->instructions_.size());
+}
+
+void FilterProgram::removeJump(size_t jump)
+{
+    this->instructions_[jump].op = Op::Nop;
+}
+
+const std::vector<FilterProgram::Instruction> &FilterProgram::instructions()
+    const
+{
+    return this->instructions_;
+}
+
+Value FilterProgram::makeList(const Value *items, int count,
+                              bool allStrings) const
+{
+    if (allStrings)
+    {
+        Value value;
+        value.type = ValueType::StringList;
+        value.list.reserve(count);
+        for (int i = 0; i < count; i++)
+        {
+            value.list << items[i].string;
+        }
+        return value;
+    }
+
+    // same as ListExpression used to do: the values might still all turn
+    // out to be strings
+    QList<QVariant> results;
+    bool runtimeAllStrings = true;
+    for (int i = 0; i < count; i++)
+    {
+        auto result = this->toVariant(items[i]);
+        if (runtimeAllStrings && result.type() != QVariant::Type::String)
+        {
+            runtimeAllStrings = false;
+        }
+        results.append(result);
+    }
+
+    if (runtimeAllStrings)
+    {
+        QStringList strings;
+        strings.reserve(results.size());
+        for (const auto &val : results)
+        {
+            strings << val.toString();
+        }
+        return variantValue(strings);
+    }
+
+    return variantValue(results);
+}
+
+QVariant FilterProgram::toVariant(const Value &value) const
+{
+    switch (value.type)
+    {
+        case ValueType::Bool:
+            return value.boolean;
+        case ValueType::Int:
+            return value.integer;
+        case ValueType::String:
+            return value.string;
+        case ValueType::StringList:
+            return value.list;
+        case ValueType::RegularExpression:
+            return this->regexes_[value.integer];
+        default:
+            return value.variant;
+    }
+}
+
+bool FilterProgram::toBool(const Value &value, bool &ok) const
+{
+    switch (value.type)
+    {
+        case ValueType::Bool:
+            ok = true;
+            return value.boolean;
+        case ValueType::Int:
+            ok = true;
+            return value.integer != 0;
+        default: {
+            auto variant = this->toVariant(value);
+            ok = variant.convert(QMetaType::Bool);
+            return ok && variant.toBool();
+        }
+    }
+}
+
+Value FilterProgram::evaluateBinary(const Instruction &instruction,
+                                    const Value &left,
+                                    const Value &right) const
+{
+    switch (instruction.op)
+    {
+        case Op::And:
+        case Op::Or: {
+            bool leftOk, rightOk;
+            auto a = this->toBool(left, leftOk);
+            auto b = this->toBool(right, rightOk);
+            if (!leftOk || !rightOk)
+            {
+                return boolValue(false);
+            }
+            return boolValue(instruction.op == Op::And ? a && b : a || b);
+        }
+
+        case Op::Add:
+            return intValue(left.integer + right.integer);
+        case Op::Subtract:
+            return intValue(left.integer - right.integer);
+        case Op::Multiply:
+            return intValue(left.integer * right.integer);
+        case Op::Divide:
+            return intValue(right.integer == 0 ? 0
+                                               : left.integer / right.integer);
+        case Op::Modulo:
+            return intValue(right.integer == 0 ? 0
+                                               : left.integer % right.integer);
+        case Op::Less:
+            return boolValue(left.integer < right.integer);
+        case Op::Greater:
+            return boolValue(left.integer > right.integer);
+        case Op::LessEqual:
+            return boolValue(left.integer <= right.integer);
+        case Op::GreaterEqual:
+            return boolValue(left.integer >= right.integer);
+
+        case Op::Equals:
+        case Op::NotEquals: {
+            bool equal = left.type == ValueType::Int
+                             ? left.integer == right.integer
+                             : left.boolean == right.boolean;
+            return boolValue(equal == (instruction.op == Op::Equals));
+        }
+
+        case Op::Concat:
+            return stringValue(left.string +
+                               (right.type == ValueType::Int
+                                    ? QString::number(right.integer)
+                                    : right.string));
+
+        case Op::StringEquals:
+            return boolValue(left.string.compare(right.string,
+                                                 Qt::CaseInsensitive) == 0);
+        case Op::StringNotEquals:
+            return boolValue(left.string.compare(right.string,
+                                                 Qt::CaseInsensitive) != 0);
+        case Op::StringContains:
+            return boolValue(
+                left.string.contains(right.string, Qt::CaseInsensitive));
+        case Op::StartsWith:
+            return boolValue(
+                left.string.startsWith(right.string, Qt::CaseInsensitive));
+        case Op::EndsWith:
+            return boolValue(
+                left.string.endsWith(right.string, Qt::CaseInsensitive));
+
+        case Op::ListContains:
+            return boolValue(
+                left.list.contains(right.string, Qt::CaseInsensitive));
+
+        case Op::Match:
+            return boolValue(
+                this->regexes_[right.integer].match(left.string).hasMatch());
+
+        default:
+            return variantValue(evaluateBinaryOperation(
+                TokenType(instruction.arg), this->toVariant(left),
+                this->toVariant(right)));
+    }
+}
+
+}  // namespace filterparser
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "controllers/filters/parser/Types.hpp"
+
+#include <QRegularExpression>
+#include <QStringList>
+#include <QVariant>
+
+#include <vector>
+
+namespace filterparser {
+
+class FilterContext;
+
+/// A filter expression compiled into instructions for a small stack
+/// machine.
+///
+/// Identifiers are resolved while compiling, and operations whose operand
+/// types are known up front run on plain values. Everything else falls back
+/// to the QVariant based rules of evaluateBinaryOperation and
+/// evaluateUnaryOperation, so a compiled filter gives the same results as
+/// the expression it was compiled from.
+class FilterProgram
+{
+public:
+    enum class Op : uint8_t {
+        Nop,
+        PushConstant,    // arg: index into constants_
+        PushIdentifier,  // arg: Identifier
+        MakeList,        // arg: item count
+        MakeStringList,  // arg: item count
+
+        // && and ||: jump to arg if the result is already decided
+        AndJump,
+        OrJump,
+        And,
+        Or,
+        Not,
+
+        // Int, Int
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Modulo,
+        Less,
+        Greater,
+        LessEqual,
+        GreaterEqual,
+
+        // Int, Int or Bool, Bool
+        Equals,
+        NotEquals,
+
+        // String, String or String, Int
+        Concat,
+
+        // String, String
+        StringEquals,
+        StringNotEquals,
+        StringContains,
+        StartsWith,
+        EndsWith,
+
+        // StringList, String
+        ListContains,
+
+        // String, RegularExpression
+        Match,
+
+        // anything else, arg: TokenType
+        Binary,
+        Unary,
+    };
+
+    struct Instruction {
+        Op op;
+        int arg;
+    };
+
+    struct Value {
+        ValueType type = ValueType::Bool;
+        bool boolean = false;
+        // Int value, or the index into regexes_ for regular expressions
+        int integer = 0;
+        QString string;
+        QStringList list;
+        QVariant variant;
+    };
+
+    explicit FilterProgram(const Expression &expression);
+
+    bool execute(const FilterContext &context) const;
+
+    /// Returns true if the result depends on more than the message, e.g.
+    /// on whether the channel is live
+    bool usesChannelState() const;
+
+    // Used by Expression::compile
+    void emit(Op op, int arg = 0);
+    void emitConstant(Value value);
+    void emitRegex(const QRegularExpression &regex);
+    void emitList(int count, bool allStrings);
+    /// Emits a jump which is pointed at the next instruction by patchJump
+    size_t emitJump(Op op);
+    void patchJump(size_t jump);
+    void removeJump(size_t jump);
+
+    const std::vector<Instruction> &instructions() const;
+
+private:
+    Value makeList(const Value *items, int count, bool allStrings) const;
+    QVariant toVariant(const Value &value) const;
+    bool toBool(const Value &value, bool &ok) const;
+    Value evaluateBinary(const Instruction &instruction, const Value &left,
+                         const Value &right) const;
+
+    std::vector<Instruction> instructions_;
+    std::vector<Value> constants_;
+    std::vector<QRegularExpression> regexes_;
+
+    int stackSize_ = 0;
+    int maxStackSize_ = 0;
+    bool usesChannelState_ = false;
+};
+
+}  // namespace filterparser
@@ -1,5 +1,8 @@
 #include "controllers/filters/parser/Types.hpp"
 
+#include "controllers/filters/parser/FilterContext.hpp"
+#include "controllers/filters/parser/FilterProgram.hpp"
+
 namespace filterparser {
 
 bool convertVariantTypes(QVariant &a, QVariant &b, int type)
@@ -84,145 +87,9 @@ QString tokenTypeToInfoString(TokenType type)
     }
 }
 
-// ValueExpression
-
-ValueExpression::ValueExpression(QVariant value, TokenType type)
-    : value_(value)
-    , type_(type){};
-
-QVariant ValueExpression::execute(const ContextMap &context) const
-{
-    if (this->type_ == TokenType::IDENTIFIER)
-    {
-        return context.value(this->value_.toString());
-    }
-    return this->value_;
-}
-
-TokenType ValueExpression::type()
-{
-    return this->type_;
-}
-
-QString ValueExpression::debug() const
-{
-    return this->value_.toString();
-}
-
-QString ValueExpression::filterString() const
-{
-    switch (this->type_)
-    {
-        case INT:
-            return QString::number(this->value_.toInt());
-        case STRING:
-            return QString("\"%1\"").arg(
-                this->value_.toString().replace("\"", "\\\""));
-        case IDENTIFIER:
-            return this->value_.toString();
-        default:
-            return "";
-    }
-}
-
-// RegexExpression
-
-RegexExpression::RegexExpression(QString regex, bool caseInsensitive)
-    : regexString_(regex)
-    , caseInsensitive_(caseInsensitive)
-    , regex_(QRegularExpression(
-          regex, caseInsensitive ? QRegularExpression::CaseInsensitiveOption
-                                 : QRegularExpression::NoPatternOption)){};
-
-QVariant RegexExpression::execute(const ContextMap &) const
-{
-    return this->regex_;
-}
-
-QString RegexExpression::debug() const
-{
-    return this->regexString_;
-}
-
-QString RegexExpression::filterString() const
+QVariant evaluateBinaryOperation(TokenType op, QVariant left, QVariant right)
 {
-    auto s = this->regexString_;
-    return QString("%1\"%2\"")
-        .arg(this->caseInsensitive_ ? "ri" : "r")
-        .arg(s.replace("\"", "\\\""));
-}
-
-// ListExpression
-
-ListExpression::ListExpression(ExpressionList list)
-    : list_(std::move(list)){};
-
-QVariant ListExpression::execute(const ContextMap &context) const
-{
-    QList<QVariant> results;
-    bool allStrings = true;
-    for (const auto &exp : this->list_)
-    {
-        auto res = exp->execute(context);
-        if (allStrings && res.type() != QVariant::Type::String)
-        {
-            allStrings = false;
-        }
-        results.append(res);
-    }
-
-    // if everything is a string return a QStringList for case-insensitive comparison
-    if (allStrings)
-    {
-        QStringList strings;
-        strings.reserve(results.size());
-        for (const auto &val : results)
-        {
-            strings << val.toString();
-        }
-        return strings;
-    }
-    else
-    {
-        return results;
-    }
-}
-
-QString ListExpression::debug() const
-{
-    QStringList debugs;
-    for (const auto &exp : this->list_)
-    {
-        debugs.append(exp->debug());
-    }
-    return QString("{%1}").arg(debugs.join(", "));
-}
-
-QString ListExpression::filterString() const
-{
-    QStringList strings;
-    for (const auto &exp : this->list_)
-    {
-        strings.append(QString("(%1)").arg(exp->filterString()));
-    }
-    return QString("{%1}").arg(strings.join(", "));
-}
-
-// BinaryOperation
-
-BinaryOperation::BinaryOperation(TokenType op, ExpressionPtr left,
-                                 ExpressionPtr right)
-    : op_(op)
-    , left_(std::move(left))
-    , right_(std::move(right))
-{
-}
-
-QVariant BinaryOperation::execute(const ContextMap &context) const
-{
-    auto left = this->left_->execute(context);
-    auto right = this->right_->execute(context);
-    switch (this->op_)
+    switch (op)
     {
         case PLUS:
             if (left.type() == QVariant::Type::String &&
@@ -409,6 +276,295 @@ QVariant BinaryOperation::execute(const ContextMap &context) const
     }
 }
 
+QVariant evaluateUnaryOperation(TokenType op, const QVariant &right)
+{
+    switch (op)
+    {
+        case NOT:
+            if (right.canConvert<bool>())
+                return !right.toBool();
+            return false;
+        default:
+            return false;
+    }
+}
+
+// Expression
+
+ValueType Expression::compile(FilterProgram &program) const
+{
+    program.emitConstant({});
+    return ValueType::Bool;
+}
+
+// ValueExpression
+
+ValueExpression::ValueExpression(QVariant value, TokenType type)
+    : value_(value)
+    , type_(type){};
+
+ValueType ValueExpression::compile(FilterProgram &program) const
+{
+    FilterProgram::Value value;
+
+    switch (this->type_)
+    {
+        case IDENTIFIER: {
+            auto identifier = identifierFromString(this->value_.toString());
+            if (identifier)
+            {
+                program.emit(FilterProgram::Op::PushIdentifier,
+                             int(*identifier));
+                return identifierType(*identifier);
+            }
+
+            // unknown identifiers have no value
+            value.type = ValueType::Variant;
+        }
+        break;
+        case INT:
+            value.type = ValueType::Int;
+            value.integer = this->value_.toInt();
+            break;
+        case STRING:
+            value.type = ValueType::String;
+            value.string = this->value_.toString();
+            break;
+        default:
+            value.type = ValueType::Variant;
+            value.variant = this->value_;
+            break;
+    }
+
+    program.emitConstant(value);
+    return value.type;
+}
+
+TokenType ValueExpression::type()
+{
+    return this->type_;
+}
+
+QString ValueExpression::debug() const
+{
+    return this->value_.toString();
+}
+
+QString ValueExpression::filterString() const
+{
+    switch (this->type_)
+    {
+        case INT:
+            return QString::number(this->value_.toInt());
+        case STRING:
+            return QString("\"%1\"").arg(
+                this->value_.toString().replace("\"", "\\\""));
+        case IDENTIFIER:
+            return this->value_.toString();
+        default:
+            return "";
+    }
+}
+
+// RegexExpression
+
+RegexExpression::RegexExpression(QString regex, bool caseInsensitive)
+    : regexString_(regex)
+    , caseInsensitive_(caseInsensitive)
+    , regex_(QRegularExpression(
+          regex, caseInsensitive ? QRegularExpression::CaseInsensitiveOption
+                                 : QRegularExpression::NoPatternOption)){};
+
+ValueType RegexExpression::compile(FilterProgram &program) const
+{
+    program.emitRegex(this->regex_);
+    return ValueType::RegularExpression;
+}
+
+QString RegexExpression::debug() const
+{
+    return this->regexString_;
+}
+
+QString RegexExpression::filterString() const
+{
+    auto s = this->regexString_;
+    return QString("%1\"%2\"")
+        .arg(this->caseInsensitive_ ? "ri" : "r")
+        .arg(s.replace("\"", "\\\""));
+}
+
+// ListExpression
+
+ListExpression::ListExpression(ExpressionList list)
+    : list_(std::move(list)){};
+
+ValueType ListExpression::compile(FilterProgram &program) const
+{
+    bool allStrings = true;
+    for (const auto &exp : this->list_)
+    {
+        if (exp->compile(program) != ValueType::String)
+        {
+            allStrings = false;
+        }
+    }
+
+    program.emitList(int(this->list_.size()), allStrings);
+
+    // if everything is a string it's a QStringList for case-insensitive
+    // comparison
+    return allStrings ? ValueType::StringList : ValueType::Variant;
+}
+
+QString ListExpression::debug() const
+{
+    QStringList debugs;
+    for (const auto &exp : this->list_)
+    {
+        debugs.append(exp->debug());
+    }
+    return QString("{%1}").arg(debugs.join(", "));
+}
+
+QString ListExpression::filterString() const
+{
+    QStringList strings;
+    for (const auto &exp : this->list_)
+    {
+        strings.append(QString("(%1)").arg(exp->filterString()));
+    }
+    return QString("{%1}").arg(strings.join(", "));
+}
+
+// BinaryOperation
+
+BinaryOperation::BinaryOperation(TokenType op, ExpressionPtr left,
+                                 ExpressionPtr right)
+    : op_(op)
+    , left_(std::move(left))
+    , right_(std::move(right))
+{
+}
+
+ValueType BinaryOperation::compile(FilterProgram &program) const
+{
+    using Op = FilterProgram::Op;
+
+    auto left = this->left_->compile(program);
+
+    if (this->op_ == AND || this->op_ == OR)
+    {
+        auto jump =
+            program.emitJump(this->op_ == AND ? Op::AndJump : Op::OrJump);
+        auto right = this->right_->compile(program);
+        program.emit(this->op_ == AND ? Op::And : Op::Or);
+
+        // || is only decided by a true left side if the right side can
+        // always be converted to bool
+        if (this->op_ == OR && right != ValueType::Bool &&
+            right != ValueType::Int)
+        {
+            program.removeJump(jump);
+        }
+        else
+        {
+            program.patchJump(jump);
+        }
+
+        return ValueType::Bool;
+    }
+
+    auto right = this->right_->compile(program);
+
+    auto both = [&](ValueType type) {
+        return left == type && right == type;
+    };
+    auto typed = [&](Op op, ValueType result) {
+        program.emit(op);
+        return result;
+    };
+
+    switch (this->op_)
+    {
+        case PLUS:
+            if (left == ValueType::String &&
+                (right == ValueType::String || right == ValueType::Int))
+                return typed(Op::Concat, ValueType::String);
+            if (both(ValueType::Int))
+                return typed(Op::Add, ValueType::Int);
+            break;
+        case MINUS:
+            if (both(ValueType::Int))
+                return typed(Op::Subtract, ValueType::Int);
+            break;
+        case MULTIPLY:
+            if (both(ValueType::Int))
+                return typed(Op::Multiply, ValueType::Int);
+            break;
+        case DIVIDE:
+            if (both(ValueType::Int))
+                return typed(Op::Divide, ValueType::Int);
+            break;
+        case MOD:
+            if (both(ValueType::Int))
+                return typed(Op::Modulo, ValueType::Int);
+            break;
+        case EQ:
+            if (both(ValueType::String))
+                return typed(Op::StringEquals, ValueType::Bool);
+            if (both(ValueType::Int) || both(ValueType::Bool))
+                return typed(Op::Equals, ValueType::Bool);
+            break;
+        case NEQ:
+            if (both(ValueType::String))
+                return typed(Op::StringNotEquals, ValueType::Bool);
+            if (both(ValueType::Int) || both(ValueType::Bool))
+                return typed(Op::NotEquals, ValueType::Bool);
+            break;
+        case LT:
+            if (both(ValueType::Int))
+                return typed(Op::Less, ValueType::Bool);
+            break;
+        case GT:
+            if (both(ValueType::Int))
+                return typed(Op::Greater, ValueType::Bool);
+            break;
+        case LTE:
+            if (both(ValueType::Int))
+                return typed(Op::LessEqual, ValueType::Bool);
+            break;
+        case GTE:
+            if (both(ValueType::Int))
+                return typed(Op::GreaterEqual, ValueType::Bool);
+            break;
+        case CONTAINS:
+            if (left == ValueType::StringList && right == ValueType::String)
+                return typed(Op::ListContains, ValueType::Bool);
+            if (both(ValueType::String))
+                return typed(Op::StringContains, ValueType::Bool);
+            break;
+        case STARTS_WITH:
+            if (both(ValueType::String))
+                return typed(Op::StartsWith, ValueType::Bool);
+            break;
+        case ENDS_WITH:
+            if (both(ValueType::String))
+                return typed(Op::EndsWith, ValueType::Bool);
+            break;
+        case MATCH:
+            if (left == ValueType::String &&
+                right == ValueType::RegularExpression)
+                return typed(Op::Match, ValueType::Bool);
+            break;
+        default:
+            break;
+    }
+
+    program.emit(Op::Binary, this->op_);
+    return ValueType::Variant;
+}
+
 QString BinaryOperation::debug() const
 {
     return QString("(%1 %2 %3)")
@@ -474,18 +630,18 @@ UnaryOperation::UnaryOperation(TokenType op, ExpressionPtr right)
 {
 }
 
-QVariant UnaryOperation::execute(const ContextMap &context) const
+ValueType UnaryOperation::compile(FilterProgram &program) const
 {
-    auto right = this->right_->execute(context);
-    switch (this->op_)
+    auto right = this->right_->compile(program);
+
+    if (this->op_ == NOT && right == ValueType::Bool)
     {
-        case NOT:
-            if (right.canConvert<bool>())
-                return !right.toBool();
-            return false;
-        default:
-            return false;
+        program.emit(FilterProgram::Op::Not);
+        return ValueType::Bool;
     }
+
+    program.emit(FilterProgram::Op::Unary, this->op_);
+    return ValueType::Variant;
 }
 
 QString UnaryOperation::debug() const
@@ -7,7 +7,8 @@
 namespace filterparser {
 
 using MessagePtr = std::shared_ptr<const chatterino::Message>;
-using ContextMap = QMap<QString, QVariant>;
+
+class FilterProgram;
 
 enum TokenType {
     // control
@@ -59,18 +60,32 @@ enum TokenType {
     NONE = 200
 };
 
+/// Type of a value in a compiled filter, known before the filter runs.
+/// Variant values are only known at runtime and use the QVariant conversion
+/// rules.
+enum class ValueType : uint8_t {
+    Bool,
+    Int,
+    String,
+    StringList,
+    RegularExpression,
+    Variant,
+};
+
 bool convertVariantTypes(QVariant &a, QVariant &b, int type);
 QString tokenTypeToInfoString(TokenType type);
 
+QVariant evaluateBinaryOperation(TokenType op, QVariant left, QVariant right);
+QVariant evaluateUnaryOperation(TokenType op, const QVariant &right);
+
 class Expression
 {
 public:
     virtual ~Expression() = default;
 
-    virtual QVariant execute(const ContextMap &) const
-    {
-        return false;
-    }
+    /// Appends the instructions computing this expression to program and
+    /// returns the type of the value they leave on the stack
+    virtual ValueType compile(FilterProgram &program) const;
 
     virtual QString debug() const
     {
@@ -91,7 +106,7 @@ public:
     ValueExpression(QVariant value, TokenType type);
     TokenType type();
 
-    QVariant execute(const ContextMap &context) const override;
+    ValueType compile(FilterProgram &program) const override;
     QString debug() const override;
     QString filterString() const override;
 
@@ -105,7 +120,7 @@ class RegexExpression : public Expression
 public:
     RegexExpression(QString regex, bool caseInsensitive);
 
-    QVariant execute(const ContextMap &context) const override;
+    ValueType compile(FilterProgram &program) const override;
     QString debug() const override;
     QString filterString() const override;
 
@@ -122,7 +137,7 @@ class ListExpression : public Expression
 public:
     ListExpression(ExpressionList list);
 
-    QVariant execute(const ContextMap &context) const override;
+    ValueType compile(FilterProgram &program) const override;
     QString debug() const override;
     QString filterString() const override;
 
@@ -135,7 +150,7 @@ class BinaryOperation : public Expression
 public:
     BinaryOperation(TokenType op, ExpressionPtr left, ExpressionPtr right);
 
-    QVariant execute(const ContextMap &context) const override;
+    ValueType compile(FilterProgram &program) const override;
     QString debug() const override;
     QString filterString() const override;
 
@@ -150,7 +165,7 @@ class UnaryOperation : public Expression
 public:
     UnaryOperation(TokenType op, ExpressionPtr right);
 
-    QVariant execute(const ContextMap &context) const override;
+    ValueType compile(FilterProgram &program) const override;
     QString debug() const override;
     QString filterString() const override;
 
@@ -0,0 +1,243 @@
+#include "controllers/highlights/HighlightMatcher.hpp"
+
+#include "common/SignalVector.hpp"
+
+#include <algorithm>
+
+namespace chatterino {
+
+namespace {
+
+    // Regex features which can't be used once multiple patterns are joined
+    // into one: numbered or named groups being referenced, recursion,
+    // extended mode comments swallowing the closing parenthesis and
+    // options which are only valid at the start of a pattern.
+    const QRegularExpression UNCOMBINABLE_REGEX(
+        R"(\\[1-9gk]|\(\?(P?<[A-Za-z_]|P[=>]|'|[0-9+&R-])|\(\?[a-zA-Z]*x|\(\*)");
+
+    // Mirrors \w with QRegularExpression::UseUnicodePropertiesOption
+    bool isWordCharacter(QChar c)
+    {
+        return c.isLetterOrNumber() || c == '_';
+    }
+
+    // Mirrors (\b|\s|^) in front of the character at index
+    bool isStartBoundary(const QString &text, int index)
+    {
+        if (index == 0)
+        {
+            return true;
+        }
+
+        auto previous = text[index - 1];
+        return previous.isSpace() ||
+               isWordCharacter(previous) != isWordCharacter(text[index]);
+    }
+
+    // Mirrors (\b|\s|$) behind the character at index
+    bool isEndBoundary(const QString &text, int index)
+    {
+        if (index == text.size() - 1)
+        {
+            return true;
+        }
+
+        auto next = text[index + 1];
+        return next.isSpace() ||
+               isWordCharacter(next) != isWordCharacter(text[index]);
+    }
+
+}  // namespace
+
+HighlightMatcher::HighlightMatcher(std::vector<HighlightPhrase> phrases)
+    : phrases_(std::move(phrases))
+    , patternLengths_(this->phrases_.size(), 0)
+{
+    std::vector<size_t> regexPhrases;
+
+    for (size_t i = 0; i < this->phrases_.size(); i++)
+    {
+        const auto &phrase = this->phrases_[i];
+
+        // invalid phrases never match
+        if (!phrase.isValid())
+        {
+            continue;
+        }
+
+        if (phrase.isRegex())
+        {
+            regexPhrases.push_back(i);
+        }
+        else
+        {
+            this->addToAutomaton(i);
+        }
+    }
+
+    this->caseSensitive_.build();
+    this->caseInsensitive_.build();
+
+    this->combineRegexes(regexPhrases);
+}
+
+std::vector<size_t> HighlightMatcher::match(const QString &subject) const
+{
+    std::vector<size_t> matches;
+
+    auto onMatch = [&](int end, size_t phrase) {
+        if (this->isBoundedMatch(subject, end, phrase))
+        {
+            matches.push_back(phrase);
+        }
+    };
+
+    this->caseSensitive_.search(subject, onMatch);
+
+    if (!this->caseInsensitive_.empty())
+    {
+        auto folded = subject.toCaseFolded();
+
+        if (folded.size() == subject.size())
+        {
+            this->caseInsensitive_.search(folded, onMatch);
+        }
+        else
+        {
+            // positions in the folded text don't line up with the subject
+            for (auto phrase : this->caseInsensitivePhrases_)
+            {
+                if (this->phrases_[phrase].isMatch(subject))
+                {
+                    matches.push_back(phrase);
+                }
+            }
+        }
+    }
+
+    if (!this->combinedPhrases_.empty() &&
+        this->combinedRegex_.match(subject).hasMatch())
+    {
+        for (auto phrase : this->combinedPhrases_)
+        {
+            if (this->phrases_[phrase].isMatch(subject))
+            {
+                matches.push_back(phrase);
+            }
+        }
+    }
+
+    for (auto phrase : this->separatePhrases_)
+    {
+        if (this->phrases_[phrase].isMatch(subject))
+        {
+            matches.push_back(phrase);
+        }
+    }
+
+    std::sort(matches.begin(), matches.end());
+    matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+
+    return matches;
+}
+
+bool HighlightMatcher::isMatch(const QString &subject) const
+{
+    return !this->match(subject).empty();
+}
+
+const std::vector<HighlightPhrase> &HighlightMatcher::phrases() const
+{
+    return this->phrases_;
+}
+
+void HighlightMatcher::addToAutomaton(size_t index)
+{
+    const auto &phrase = this->phrases_[index];
+
+    if (phrase.isCaseSensitive())
+    {
+        this->patternLengths_[index] = phrase.getPattern().size();
+        this->caseSensitive_.add(phrase.getPattern(), index);
+    }
+    else
+    {
+        auto folded = phrase.getPattern().toCaseFolded();
+        this->patternLengths_[index] = folded.size();
+        this->caseInsensitive_.add(folded, index);
+        this->caseInsensitivePhrases_.push_back(index);
+    }
+}
+
+void HighlightMatcher::combineRegexes(const std::vector<size_t> &candidates)
+{
+    QStringList alternatives;
+
+    for (auto index : candidates)
+    {
+        const auto &phrase = this->phrases_[index];
+
+        if (UNCOMBINABLE_REGEX.match(phrase.getPattern()).hasMatch())
+        {
+            this->separatePhrases_.push_back(index);
+            continue;
+        }
+
+        alternatives.append((phrase.isCaseSensitive() ? "(?:" : "(?i:") +
+                            phrase.getPattern() + ")");
+        this->combinedPhrases_.push_back(index);
+    }
+
+    if (this->combinedPhrases_.empty())
+    {
+        return;
+    }
+
+    this->combinedRegex_ =
+        QRegularExpression(alternatives.join('|'),
+                           QRegularExpression::UseUnicodePropertiesOption);
+
+    if (!this->combinedRegex_.isValid())
+    {
+        // fall back to checking every regex on its own
+        this->separatePhrases_.insert(this->separatePhrases_.end(),
+                                      this->combinedPhrases_.begin(),
+                                      this->combinedPhrases_.end());
+        this->combinedPhrases_.clear();
+        return;
+    }
+
+    this->combinedRegex_.optimize();
+}
+
+bool HighlightMatcher::isBoundedMatch(const QString &subject, int end,
+                                      size_t phrase) const
+{
+    auto start = end - this->patternLengths_[phrase] + 1;
+
+    return isStartBoundary(subject, start) && isEndBoundary(subject, end);
+}
+
+HighlightMatcherCache::HighlightMatcherCache(
+    SignalVector<HighlightPhrase> &phrases)
+    : phrases_(phrases)
+{
+}
+
+std::shared_ptr<const HighlightMatcher> HighlightMatcherCache::get()
+{
+    auto source = this->phrases_.readOnly();
+
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    // SignalVector creates a new read-only copy on every change
+    if (source != this->source_ || !this->matcher_)
+    {
+        this->matcher_ = std::make_shared<const HighlightMatcher>(*source);
+        this->source_ = std::move(source);
+    }
+
+    return this->matcher_;
+}
+
+}  // namespace chatterino
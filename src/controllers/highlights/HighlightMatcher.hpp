@@ -0,0 +1,81 @@
+#pragma once
+
+#include "controllers/highlights/HighlightPhrase.hpp"
+#include "util/AhoCorasick.hpp"
+
+#include <QRegularExpression>
+#include <QString>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace chatterino {
+
+template <typename T>
+class SignalVector;
+
+/// HighlightMatcher checks a message against a whole list of highlight
+/// phrases at once.
+///
+/// Plain phrases are compiled into two Aho-Corasick automata (one for case
+/// sensitive and one for case insensitive phrases), so the message is only
+/// scanned once no matter how many phrases there are. Regex phrases are
+/// joined into a single alternation which is used to skip checking them
+/// one by one when none of them can match.
+///
+/// The results are the same as calling HighlightPhrase::isMatch on every
+/// phrase. A matcher is immutable once built and can be used from any
+/// thread.
+class HighlightMatcher
+{
+public:
+    explicit HighlightMatcher(std::vector<HighlightPhrase> phrases);
+
+    /// Returns the indices of all phrases matching subject in ascending order
+    std::vector<size_t> match(const QString &subject) const;
+
+    /// Returns true if any phrase matches subject
+    bool isMatch(const QString &subject) const;
+
+    const std::vector<HighlightPhrase> &phrases() const;
+
+private:
+    void addToAutomaton(size_t index);
+    void combineRegexes(const std::vector<size_t> &candidates);
+    bool isBoundedMatch(const QString &subject, int end, size_t phrase) const;
+
+    std::vector<HighlightPhrase> phrases_;
+    // length of the pattern each plain phrase was added to an automaton with
+    std::vector<int> patternLengths_;
+
+    AhoCorasick caseSensitive_;
+    AhoCorasick caseInsensitive_;
+    std::vector<size_t> caseInsensitivePhrases_;
+
+    // regex phrases which are prefiltered by combinedRegex_
+    QRegularExpression combinedRegex_;
+    std::vector<size_t> combinedPhrases_;
+    // regex phrases which have to be checked one by one, e.g. because they
+    // use back references
+    std::vector<size_t> separatePhrases_;
+};
+
+/// Keeps a HighlightMatcher in sync with a list of highlight phrases. The
+/// matcher is only rebuilt after the list changed.
+class HighlightMatcherCache
+{
+public:
+    explicit HighlightMatcherCache(SignalVector<HighlightPhrase> &phrases);
+
+    std::shared_ptr<const HighlightMatcher> get();
+
+private:
+    SignalVector<HighlightPhrase> &phrases_;
+
+    std::mutex mutex_;
+    std::shared_ptr<const std::vector<HighlightPhrase>> source_;
+    std::shared_ptr<const HighlightMatcher> matcher_;
+};
+
+}  // namespace chatterino
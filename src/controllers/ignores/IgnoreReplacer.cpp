@@ -0,0 +1,220 @@
+#include "controllers/ignores/IgnoreReplacer.hpp"
+
+#include "common/SignalVector.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <tuple>
+
+namespace chatterino {
+
+IgnoreReplacer::IgnoreReplacer(std::vector<IgnorePhrase> phrases)
+    : phrases_(std::move(phrases))
+    , patternLengths_(this->phrases_.size(), 0)
+{
+    for (size_t i = 0; i < this->phrases_.size(); i++)
+    {
+        const auto &phrase = this->phrases_[i];
+
+        if (phrase.isBlock() || phrase.getPattern().isEmpty())
+        {
+            continue;
+        }
+
+        if (phrase.isRegex())
+        {
+            if (!phrase.isRegexValid())
+            {
+                continue;
+            }
+
+            auto regex = phrase.getRegex();
+            regex.optimize();
+            this->regexes_.emplace_back(i, std::move(regex));
+        }
+        else if (phrase.isCaseSensitive())
+        {
+            this->patternLengths_[i] = phrase.getPattern().size();
+            this->caseSensitive_.add(phrase.getPattern(), i);
+        }
+        else
+        {
+            auto folded = phrase.getPattern().toCaseFolded();
+            this->patternLengths_[i] = folded.size();
+            this->caseInsensitive_.add(folded, i);
+        }
+    }
+
+    this->caseSensitive_.build();
+    this->caseInsensitive_.build();
+}
+
+std::vector<IgnoreReplacement> IgnoreReplacer::findReplacements(
+    const QString &message) const
+{
+    std::vector<Span> spans;
+
+    this->findPlain(message, spans);
+    this->findRegex(message, spans);
+
+    if (spans.empty())
+    {
+        return {};
+    }
+
+    // earlier phrases win, then earlier spans
+    std::sort(spans.begin(), spans.end(), [](const Span &a, const Span &b) {
+        return std::tie(a.phrase, a.start) < std::tie(b.phrase, b.start);
+    });
+
+    // start -> end of the accepted spans
+    std::map<int, int> accepted;
+    std::vector<IgnoreReplacement> replacements;
+
+    for (const auto &span : spans)
+    {
+        auto end = span.start + span.length;
+
+        auto next = accepted.lower_bound(span.start);
+        if (next != accepted.end() && next->first < end)
+        {
+            continue;
+        }
+        if (next != accepted.begin() && std::prev(next)->second > span.start)
+        {
+            continue;
+        }
+
+        accepted.emplace(span.start, end);
+
+        const auto &phrase = this->phrases_[span.phrase];
+        if (phrase.isRegex())
+        {
+            // expands captures like \1 in the replacement
+            auto replacement = message.mid(span.start, span.length);
+            replacement.replace(phrase.getRegex(), phrase.getReplace());
+            replacements.push_back(
+                {span.start, span.length, replacement, span.phrase});
+        }
+        else
+        {
+            replacements.push_back(
+                {span.start, span.length, phrase.getReplace(), span.phrase});
+        }
+    }
+
+    std::sort(replacements.begin(), replacements.end(),
+              [](const IgnoreReplacement &a, const IgnoreReplacement &b) {
+                  return a.start < b.start;
+              });
+
+    return replacements;
+}
+
+const std::vector<IgnorePhrase> &IgnoreReplacer::phrases() const
+{
+    return this->phrases_;
+}
+
+void IgnoreReplacer::findPlain(const QString &message,
+                               std::vector<Span> &spans) const
+{
+    auto onMatch = [&](int end, size_t phrase) {
+        auto length = this->patternLengths_[phrase];
+        spans.push_back({end - length + 1, length, phrase});
+    };
+
+    this->caseSensitive_.search(message, onMatch);
+
+    if (this->caseInsensitive_.empty())
+    {
+        return;
+    }
+
+    auto folded = message.toCaseFolded();
+    if (folded.size() == message.size())
+    {
+        this->caseInsensitive_.search(folded, onMatch);
+        return;
+    }
+
+    // Folding changed the length of the message, e.g. "ß" became "ss". Fold
+    // it character by character to map positions in the folded text back
+    // to the message. origins has an extra entry for the end.
+    folded.clear();
+    std::vector<int> origins;
+    origins.reserve(size_t(message.size()) + 1);
+
+    for (int i = 0; i < message.size();)
+    {
+        int length = message[i].isHighSurrogate() && i + 1 < message.size() &&
+                             message[i + 1].isLowSurrogate()
+                         ? 2
+                         : 1;
+        auto part = message.mid(i, length).toCaseFolded();
+        folded.append(part);
+        origins.insert(origins.end(), size_t(part.size()), i);
+        i += length;
+    }
+    origins.push_back(message.size());
+
+    this->caseInsensitive_.search(folded, [&](int end, size_t phrase) {
+        auto start = end - this->patternLengths_[phrase] + 1;
+
+        // only matches which cover whole characters of the message
+        if ((start > 0 && origins[start - 1] == origins[start]) ||
+            origins[end + 1] == origins[end])
+        {
+            return;
+        }
+
+        spans.push_back(
+            {origins[start], origins[end + 1] - origins[start], phrase});
+    });
+}
+
+void IgnoreReplacer::findRegex(const QString &message,
+                               std::vector<Span> &spans) const
+{
+    for (const auto &entry : this->regexes_)
+    {
+        auto it = entry.second.globalMatch(message);
+        while (it.hasNext())
+        {
+            auto match = it.next();
+
+            // empty matches have nothing to replace
+            if (match.capturedLength() == 0)
+            {
+                continue;
+            }
+
+            spans.push_back(
+                {match.capturedStart(), match.capturedLength(), entry.first});
+        }
+    }
+}
+
+IgnoreReplacerCache::IgnoreReplacerCache(SignalVector<IgnorePhrase> &phrases)
+    : phrases_(phrases)
+{
+}
+
+std::shared_ptr<const IgnoreReplacer> IgnoreReplacerCache::get()
+{
+    auto source = this->phrases_.readOnly();
+
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    // SignalVector creates a new read-only copy on every change
+    if (source != this->source_ || !this->replacer_)
+    {
+        this->replacer_ = std::make_shared<const IgnoreReplacer>(*source);
+        this->source_ = std::move(source);
+    }
+
+    return this->replacer_;
+}
+
+}  // namespace chatterino
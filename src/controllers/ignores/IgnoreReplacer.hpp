@@ -0,0 +1,86 @@
+#pragma once
+
+#include "controllers/ignores/IgnorePhrase.hpp"
+#include "util/AhoCorasick.hpp"
+
+#include <QRegularExpression>
+#include <QString>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace chatterino {
+
+template <typename T>
+class SignalVector;
+
+struct IgnoreReplacement {
+    /// Span in the original message which gets replaced
+    int start;
+    int length;
+    QString replacement;
+    /// Index of the phrase which caused the replacement
+    size_t phrase;
+};
+
+/// IgnoreReplacer finds the spans of a message which are replaced by the
+/// non-blocking ignore phrases.
+///
+/// Plain phrases are compiled into Aho-Corasick automata, so they are found
+/// in a single scan of the message. Regex phrases are optimized once and run
+/// over the original message. Overlapping spans are resolved in favor of the
+/// phrase which comes first in the list, then the leftmost span.
+///
+/// A replacer is immutable once built and can be used from any thread.
+class IgnoreReplacer
+{
+public:
+    explicit IgnoreReplacer(std::vector<IgnorePhrase> phrases);
+
+    /// Returns the non-overlapping spans to replace, sorted by start
+    std::vector<IgnoreReplacement> findReplacements(
+        const QString &message) const;
+
+    const std::vector<IgnorePhrase> &phrases() const;
+
+private:
+    struct Span {
+        int start;
+        int length;
+        size_t phrase;
+    };
+
+    void findPlain(const QString &message, std::vector<Span> &spans) const;
+    void findRegex(const QString &message, std::vector<Span> &spans) const;
+
+    std::vector<IgnorePhrase> phrases_;
+
+    AhoCorasick caseSensitive_;
+    AhoCorasick caseInsensitive_;
+    // length of each plain phrase in the automaton, case folded for case
+    // insensitive phrases
+    std::vector<int> patternLengths_;
+
+    // phrase index and its optimized regex
+    std::vector<std::pair<size_t, QRegularExpression>> regexes_;
+};
+
+/// Keeps an IgnoreReplacer in sync with the list of ignore phrases. The
+/// replacer is only rebuilt after the list changed.
+class IgnoreReplacerCache
+{
+public:
+    explicit IgnoreReplacerCache(SignalVector<IgnorePhrase> &phrases);
+
+    std::shared_ptr<const IgnoreReplacer> get();
+
+private:
+    SignalVector<IgnorePhrase> &phrases_;
+
+    std::mutex mutex_;
+    std::shared_ptr<const std::vector<IgnorePhrase>> source_;
+    std::shared_ptr<const IgnoreReplacer> replacer_;
+};
+
+}  // namespace chatterino
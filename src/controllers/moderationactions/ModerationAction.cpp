@@ -134,18 +134,23 @@ bool ModerationAction::isImage() const
     return bool(this->image_);
 }
 
-const boost::optional<ImagePtr> &ModerationAction::getImage() const
+void ModerationAction::loadImage() const
 {
     assertInGuiThread();
 
-    if (this->imageToLoad_ != 0)
+    if (this->image_)
     {
-        if (this->imageToLoad_ == 1)
-            this->image_ = Image::fromPixmap(getResources().buttons.ban);
-        else if (this->imageToLoad_ == 2)
-            this->image_ = Image::fromPixmap(getResources().buttons.trashCan);
+        return;
     }
 
+    if (this->imageToLoad_ == 1)
+        this->image_ = Image::fromPixmap(getResources().buttons.ban);
+    else if (this->imageToLoad_ == 2)
+        this->image_ = Image::fromPixmap(getResources().buttons.trashCan);
+}
+
+const boost::optional<ImagePtr> &ModerationAction::getImage() const
+{
     return this->image_;
 }
 
@@ -21,6 +21,9 @@ public:
     bool operator==(const ModerationAction &other) const;
 
     bool isImage() const;
+    // creates the image of ban and delete buttons, only on the gui thread
+    void loadImage() const;
+    // can be used on any thread, empty until loadImage has been called
     const boost::optional<ImagePtr> &getImage() const;
     const QString &getLine1() const;
     const QString &getLine2() const;
@@ -5,7 +5,9 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QPainter>
 #include <QTimer>
+#include <cmath>
 #include <functional>
 #include <thread>
 
@@ -15,6 +17,9 @@
 #include "common/QLogging.hpp"
 #include "debug/AssertInGuiThread.hpp"
 #include "debug/Benchmark.hpp"
+#include "messages/ImageDecoder.hpp"
+#include "messages/ImageMemoryBudget.hpp"
+#include "messages/layouts/MessageLayoutCache.hpp"
 #ifndef CHATTERINO_TEST
 #    include "singletons/Emotes.hpp"
 #endif
@@ -23,10 +28,93 @@
 #include "util/DebugCount.hpp"
 #include "util/PostToThread.hpp"
 
+#include <algorithm>
 #include <queue>
 
 namespace chatterino {
 namespace detail {
+    namespace {
+        // Atlases larger than this are not built, the frames are scaled
+        // while painting instead
+        constexpr int maxAtlasBytes = 16 * 1024 * 1024;
+        // Number of sizes an image keeps atlases for
+        constexpr size_t maxAtlasCount = 4;
+
+        long unsigned gifClockPosition()
+        {
+#ifndef CHATTERINO_TEST
+            return getApp()->emotes->gifTimer.position();
+#else
+            return 0;
+#endif
+        }
+    }  // namespace
+
+    // FrameAtlas
+    FrameAtlas::FrameAtlas(const QVector<Frame<QPixmap>> &frames,
+                           QSize frameSize, qreal devicePixelRatio)
+        : frameSize_(frameSize)
+        , columns_(int(std::ceil(std::sqrt(double(frames.size())))))
+        , devicePixelRatio_(devicePixelRatio)
+    {
+        assertInGuiThread();
+
+        auto rows = (frames.size() + this->columns_ - 1) / this->columns_;
+
+        this->pixmap_ = QPixmap(this->columns_ * frameSize.width(),
+                                rows * frameSize.height());
+        this->pixmap_.fill(Qt::transparent);
+
+        QPainter painter(&this->pixmap_);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+
+        for (int i = 0; i < frames.size(); i++)
+        {
+            painter.drawPixmap(this->source(i), frames[i].image);
+        }
+
+        this->pixmap_.setDevicePixelRatio(devicePixelRatio);
+
+        DebugCount::increase("animation atlases");
+        DebugCount::increase("animation atlas KiB", this->byteCount() / 1024);
+    }
+
+    FrameAtlas::~FrameAtlas()
+    {
+        DebugCount::decrease("animation atlases");
+        DebugCount::decrease("animation atlas KiB", this->byteCount() / 1024);
+    }
+
+    bool FrameAtlas::fits(int frameCount, QSize frameSize)
+    {
+        return double(frameCount) * frameSize.width() * frameSize.height() *
+                   4.0 <=
+               maxAtlasBytes;
+    }
+
+    bool FrameAtlas::matches(QSize frameSize, qreal devicePixelRatio) const
+    {
+        return this->frameSize_ == frameSize &&
+               this->devicePixelRatio_ == devicePixelRatio;
+    }
+
+    QRect FrameAtlas::source(int index) const
+    {
+        return QRect((index % this->columns_) * this->frameSize_.width(),
+                     (index / this->columns_) * this->frameSize_.height(),
+                     this->frameSize_.width(), this->frameSize_.height());
+    }
+
+    const QPixmap &FrameAtlas::pixmap() const
+    {
+        return this->pixmap_;
+    }
+
+    int FrameAtlas::byteCount() const
+    {
+        return this->pixmap_.width() * this->pixmap_.height() * 4;
+    }
+
     // Frames
     Frames::Frames()
     {
@@ -42,76 +130,77 @@ namespace detail {
         if (this->animated())
         {
             DebugCount::increase("animated images");
-
-#ifndef CHATTERINO_TEST
-            this->gifTimerConnection_ =
-                getApp()->emotes->gifTimer.signal.connect([this] {
-                    this->advance();
-                });
-#endif
         }
 
-        auto totalLength =
-            std::accumulate(this->items_.begin(), this->items_.end(), 0UL,
-                            [](auto init, auto &&frame) {
-                                return init + frame.duration;
-                            });
-
-        if (totalLength == 0)
+        this->frameEnds_.reserve(this->items_.size());
+        for (const auto &frame : this->items_)
         {
-            this->durationOffset_ = 0;
+            this->totalDuration_ += frame.duration;
+            this->frameEnds_.push_back(this->totalDuration_);
+            this->byteCount_ += int64_t(frame.image.width()) *
+                                frame.image.height() * frame.image.depth() /
+                                8;
         }
-        else
-        {
-#ifndef CHATTERINO_TEST
-            this->durationOffset_ = std::min<int>(
-                int(getApp()->emotes->gifTimer.position() % totalLength),
-                60000);
-#endif
-        }
-        this->processOffset();
+
+        DebugCount::increase("image KiB", this->byteCount_ / 1024);
     }
 
     Frames::~Frames()
     {
         assertInGuiThread();
         DebugCount::decrease("images");
+        DebugCount::decrease("image KiB", this->byteCount_ / 1024);
 
         if (this->animated())
         {
             DebugCount::decrease("animated images");
         }
-
-        this->gifTimerConnection_.disconnect();
     }
 
-    void Frames::advance()
+    int Frames::indexAt(long unsigned position) const
     {
-        this->durationOffset_ += gifFrameLength;
-        this->processOffset();
+        if (this->totalDuration_ == 0)
+        {
+            return 0;
+        }
+
+        // frames are shown for [previous end, end)
+        auto offset = int(position % long unsigned(this->totalDuration_));
+
+        return int(std::upper_bound(this->frameEnds_.begin(),
+                                    this->frameEnds_.end(), offset) -
+                   this->frameEnds_.begin());
     }
 
-    void Frames::processOffset()
+    int Frames::currentIndex() const
     {
-        if (this->items_.isEmpty())
+        if (!this->animated())
         {
-            return;
+            return 0;
         }
 
-        while (true)
+        // the index is computed at most once per tick of the GIF clock
+        auto position = gifClockPosition();
+        if (position != this->indexPosition_)
         {
-            this->index_ %= this->items_.size();
+            this->indexPosition_ = position;
+            this->index_ = this->indexAt(position);
+        }
 
-            if (this->durationOffset_ > this->items_[this->index_].duration)
-            {
-                this->durationOffset_ -= this->items_[this->index_].duration;
-                this->index_ = (this->index_ + 1) % this->items_.size();
-            }
-            else
-            {
-                break;
-            }
+        return this->index_;
+    }
+
+    bool Frames::frameChanged() const
+    {
+        if (!this->animated())
+        {
+            return false;
         }
+
+        auto position = gifClockPosition();
+
+        return position >= gifFrameLength &&
+               this->currentIndex() != this->indexAt(position - gifFrameLength);
     }
 
     bool Frames::animated() const
@@ -123,7 +212,7 @@ namespace detail {
     {
         if (this->items_.size() == 0)
             return boost::none;
-        return this->items_[this->index_].image;
+        return this->items_[this->currentIndex()].image;
     }
 
     boost::optional<QPixmap> Frames::first() const
@@ -133,6 +222,58 @@ namespace detail {
         return this->items_.front().image;
     }
 
+    int64_t Frames::byteCount() const
+    {
+        return this->byteCount_ + this->atlasByteCount_;
+    }
+
+    bool Frames::paintCurrent(QPainter &painter, const QRect &rect)
+    {
+        if (this->items_.isEmpty() || rect.isEmpty())
+        {
+            return false;
+        }
+
+        auto ratio = painter.device()->devicePixelRatioF();
+        auto frameSize = rect.size() * ratio;
+
+        if (!FrameAtlas::fits(this->items_.size(), frameSize))
+        {
+            painter.drawPixmap(QRectF(rect),
+                               this->items_[this->currentIndex()].image,
+                               QRectF());
+            return false;
+        }
+
+        auto it = std::find_if(this->atlases_.begin(), this->atlases_.end(),
+                               [&](const auto &atlas) {
+                                   return atlas->matches(frameSize, ratio);
+                               });
+
+        bool changed = false;
+
+        if (it == this->atlases_.end())
+        {
+            if (this->atlases_.size() >= maxAtlasCount)
+            {
+                this->atlasByteCount_ -= this->atlases_.front()->byteCount();
+                this->atlases_.erase(this->atlases_.begin());
+            }
+
+            this->atlases_.push_back(
+                std::make_unique<FrameAtlas>(this->items_, frameSize, ratio));
+            it = std::prev(this->atlases_.end());
+            this->atlasByteCount_ += (*it)->byteCount();
+            changed = true;
+        }
+
+        const auto &atlas = **it;
+        painter.drawPixmap(QRectF(rect), atlas.pixmap(),
+                           QRectF(atlas.source(this->currentIndex())));
+
+        return changed;
+    }
+
     // functions
     QVector<Frame<QImage>> readFrames(QImageReader &reader, const Url &url)
     {
@@ -199,7 +340,11 @@ namespace detail {
         }
 
 #ifndef CHATTERINO_TEST
-        getApp()->windows->forceLayoutChannelViews();
+        // only messages showing one of the loaded images are laid out again
+        if (MessageLayoutCache::instance().takeImageUpdates())
+        {
+            getApp()->windows->layoutChannelViews();
+        }
 #endif
         loadedEventQueued = false;
     }
@@ -250,6 +395,8 @@ Image::~Image()
         return;
     }
 
+    ImageMemoryBudget::instance().remove(this);
+
     // run destructor of Frames in gui thread
     if (!isGuiThread())
     {
@@ -264,6 +411,9 @@ ImagePtr Image::fromUrl(const Url &url, qreal scale)
     static std::unordered_map<Url, std::weak_ptr<Image>> cache;
     static std::mutex mutex;
 
+    // cache only grows on misses, so sweep it whenever it doubled in size
+    static size_t sweepSize = 1024;
+
     std::lock_guard<std::mutex> lock(mutex);
 
     auto shared = cache[url].lock();
@@ -271,6 +421,23 @@ ImagePtr Image::fromUrl(const Url &url, qreal scale)
     if (!shared)
     {
         cache[url] = shared = ImagePtr(new Image(url, scale));
+
+        if (cache.size() >= sweepSize)
+        {
+            for (auto it = cache.begin(); it != cache.end();)
+            {
+                if (it->second.expired())
+                {
+                    it = cache.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+
+            sweepSize = std::max<size_t>(1024, cache.size() * 2);
+        }
     }
 
     return shared;
@@ -313,8 +480,9 @@ Image::Image(qreal scale)
 void Image::setPixmap(const QPixmap &pixmap)
 {
     auto setFrames = [shared = this->shared_from_this(), pixmap]() {
-        shared->frames_ = std::make_unique<detail::Frames>(
-            QVector<detail::Frame<QPixmap>>{detail::Frame<QPixmap>{pixmap, 1}});
+        shared->setFrames(std::make_unique<detail::Frames>(
+            QVector<detail::Frame<QPixmap>>{
+                detail::Frame<QPixmap>{pixmap, 1}}));
     };
 
     if (isGuiThread())
@@ -327,6 +495,96 @@ void Image::setPixmap(const QPixmap &pixmap)
     }
 }
 
+void Image::setFrames(std::unique_ptr<detail::Frames> frames)
+{
+    assertInGuiThread();
+
+    this->frames_ = std::move(frames);
+
+    auto previousSize = this->size_.load();
+
+    if (auto pixmap = this->frames_->first())
+    {
+        this->size_ = QSize(int(pixmap->width() * this->scale_),
+                            int(pixmap->height() * this->scale_));
+        this->loaded_ = true;
+    }
+    else
+    {
+        this->size_ = QSize(16, 16);
+        this->loaded_ = false;
+    }
+
+    // images created from a pixmap can't be loaded again
+    if (this->loaded_ && !this->url_.string.isEmpty())
+    {
+        ImageMemoryBudget::instance().add(this->shared_from_this(),
+                                          this->frames_->byteCount());
+    }
+    else
+    {
+        ImageMemoryBudget::instance().remove(this);
+    }
+
+    if (this->loaded_ && !this->layoutDependents_.empty())
+    {
+        MessageLayoutCache::instance().imageLoaded(
+            this->layoutDependents_, this->size_.load() != previousSize);
+        this->layoutDependents_.clear();
+    }
+}
+
+int64_t Image::expireFrames()
+{
+    assertInGuiThread();
+
+    if (!this->loaded_)
+    {
+        return 0;
+    }
+
+    auto bytes = this->frames_->byteCount();
+
+    // size_ is kept, so messages don't change their layout once the image
+    // is loaded again
+    this->frames_ = std::make_unique<detail::Frames>();
+    this->loaded_ = false;
+    this->shouldLoad_ = true;
+
+    ImageMemoryBudget::instance().remove(this);
+
+    return bytes;
+}
+
+void Image::addLayoutDependent(std::weak_ptr<SharedMessageLayout> layout)
+{
+    assertInGuiThread();
+
+    // a buffer is painted several times before the image is loaded again
+    auto registered = layout.lock();
+    if (std::any_of(this->layoutDependents_.begin(),
+                    this->layoutDependents_.end(), [&](const auto &weak) {
+                        return weak.lock() == registered;
+                    }))
+    {
+        return;
+    }
+
+    // drop layouts which are gone before growing
+    if (this->layoutDependents_.size() == this->layoutDependents_.capacity())
+    {
+        this->layoutDependents_.erase(
+            std::remove_if(this->layoutDependents_.begin(),
+                           this->layoutDependents_.end(),
+                           [](const auto &weak) {
+                               return weak.expired();
+                           }),
+            this->layoutDependents_.end());
+    }
+
+    this->layoutDependents_.push_back(std::move(layout));
+}
+
 const Url &Image::url() const
 {
     return this->url_;
@@ -334,29 +592,49 @@ const Url &Image::url() const
 
 bool Image::loaded() const
 {
-    assertInGuiThread();
-
-    return bool(this->frames_->current());
+    return this->loaded_;
 }
 
 boost::optional<QPixmap> Image::pixmapOrLoad() const
 {
     assertInGuiThread();
 
+    this->markUsed();
     this->load();
 
     return this->frames_->current();
 }
 
+void Image::markUsed() const
+{
+    this->lastUsed_ =
+        std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+std::chrono::steady_clock::time_point Image::lastUsed() const
+{
+    return std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(this->lastUsed_.load()));
+}
+
 void Image::load() const
 {
-    assertInGuiThread();
+    if (!const_cast<Image *>(this)->shouldLoad_.exchange(false))
+    {
+        return;
+    }
 
-    if (this->shouldLoad_)
+    if (isGuiThread())
     {
-        const_cast<Image *>(this)->shouldLoad_ = false;
         const_cast<Image *>(this)->actuallyLoad();
     }
+    else
+    {
+        postToThread(
+            [shared = std::const_pointer_cast<Image>(this->shared_from_this())] {
+                shared->actuallyLoad();
+            });
+    }
 }
 
 qreal Image::scale() const
@@ -376,24 +654,37 @@ bool Image::animated() const
     return this->frames_->animated();
 }
 
-int Image::width() const
+bool Image::frameChanged() const
 {
     assertInGuiThread();
 
-    if (auto pixmap = this->frames_->first())
-        return int(pixmap->width() * this->scale_);
-    else
-        return 16;
+    return this->frames_->frameChanged();
 }
 
-int Image::height() const
+void Image::paintAnimated(QPainter &painter, const QRect &rect) const
 {
     assertInGuiThread();
 
-    if (auto pixmap = this->frames_->first())
-        return int(pixmap->height() * this->scale_);
-    else
-        return 16;
+    this->markUsed();
+
+    // the atlases count against the budget as well
+    if (this->frames_->paintCurrent(painter, rect) && this->loaded_ &&
+        !this->url_.string.isEmpty())
+    {
+        ImageMemoryBudget::instance().add(
+            std::const_pointer_cast<Image>(this->shared_from_this()),
+            this->frames_->byteCount());
+    }
+}
+
+int Image::width() const
+{
+    return this->size_.load().width();
+}
+
+int Image::height() const
+{
+    return this->size_.load().height();
 }
 
 void Image::actuallyLoad()
@@ -402,33 +693,39 @@ void Image::actuallyLoad()
         .concurrent()
         .cache()
         .onSuccess([weak = weakOf(this)](auto result) -> Outcome {
-            auto shared = weak.lock();
-            if (!shared)
+            if (weak.expired())
                 return Failure;
 
-            auto data = result.getData();
-
-            // const cast since we are only reading from it
-            QBuffer buffer(const_cast<QByteArray *>(&data));
-            buffer.open(QIODevice::ReadOnly);
-            QImageReader reader(&buffer);
-
-            // use "double" to prevent int overflows
-            if (double(reader.size().width()) * double(reader.size().height()) *
-                    double(reader.imageCount()) * 4.0 >
-                double(Image::maxBytesRam))
-            {
-                qCDebug(chatterinoImage) << "image too large in RAM";
-
-                return Failure;
-            }
-
-            auto parsed = detail::readFrames(reader, shared->url());
-
-            postToThread(makeConvertCallback(parsed, [weak](auto frames) {
-                if (auto shared = weak.lock())
-                    shared->frames_ = std::make_unique<detail::Frames>(frames);
-            }));
+            ImageDecoder::instance().schedule(weak, [weak,
+                                                     data = result.getData()] {
+                auto shared = weak.lock();
+                if (!shared)
+                    return;
+
+                // const cast since we are only reading from it
+                QBuffer buffer(const_cast<QByteArray *>(&data));
+                buffer.open(QIODevice::ReadOnly);
+                QImageReader reader(&buffer);
+
+                // use "double" to prevent int overflows
+                if (double(reader.size().width()) *
+                        double(reader.size().height()) *
+                        double(reader.imageCount()) * 4.0 >
+                    double(Image::maxBytesRam))
+                {
+                    qCDebug(chatterinoImage) << "image too large in RAM";
+
+                    return;
+                }
+
+                auto parsed = detail::readFrames(reader, shared->url());
+
+                postToThread(makeConvertCallback(parsed, [weak](auto frames) {
+                    if (auto shared = weak.lock())
+                        shared->setFrames(
+                            std::make_unique<detail::Frames>(frames));
+                }));
+            });
 
             return Success;
         })
@@ -5,16 +5,20 @@
 #include <QThread>
 #include <QVector>
 #include <atomic>
+#include <chrono>
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
 #include <boost/variant.hpp>
 #include <memory>
 #include <mutex>
 #include <pajlada/signals/signal.hpp>
+#include <vector>
 
 #include "common/Aliases.hpp"
 #include "common/Common.hpp"
 
+class QPainter;
+
 namespace chatterino {
 namespace detail {
     template <typename Image>
@@ -22,6 +26,32 @@ namespace detail {
         Image image;
         int duration;
     };
+    /// All frames of an animated image scaled to one size and packed into a
+    /// single pixmap, so painting the image at that size doesn't scale.
+    class FrameAtlas : boost::noncopyable
+    {
+    public:
+        FrameAtlas(const QVector<Frame<QPixmap>> &frames, QSize frameSize,
+                   qreal devicePixelRatio);
+        ~FrameAtlas();
+
+        // false if an atlas for these frames would use too much memory
+        static bool fits(int frameCount, QSize frameSize);
+
+        bool matches(QSize frameSize, qreal devicePixelRatio) const;
+        // where frame index is stored in pixmap, in device pixels
+        QRect source(int index) const;
+        const QPixmap &pixmap() const;
+        int byteCount() const;
+
+    private:
+
+        QSize frameSize_;
+        int columns_;
+        qreal devicePixelRatio_;
+        QPixmap pixmap_;
+    };
+
     class Frames : boost::noncopyable
     {
     public:
@@ -30,21 +60,42 @@ namespace detail {
         ~Frames();
 
         bool animated() const;
-        void advance();
+        // true if the animation moved to another frame on the last tick of
+        // the GIF timer
+        bool frameChanged() const;
         boost::optional<QPixmap> current() const;
         boost::optional<QPixmap> first() const;
+        // memory used by the decoded frames and their atlases
+        int64_t byteCount() const;
+        // paints the current frame from an atlas for the size of rect,
+        // returns true if an atlas was built or dropped
+        bool paintCurrent(QPainter &painter, const QRect &rect);
 
     private:
-        void processOffset();
+        // The current frame follows the global GIF clock, so all instances
+        // of an animation are in sync without advancing every Frames on
+        // each tick
+        int currentIndex() const;
+        int indexAt(long unsigned position) const;
+
         QVector<Frame<QPixmap>> items_;
-        int index_{0};
-        int durationOffset_{0};
-        pajlada::Signals::Connection gifTimerConnection_;
+        // the time at which each frame ends, relative to the first frame
+        std::vector<int> frameEnds_;
+        int totalDuration_{0};
+        int64_t byteCount_{0};
+        int64_t atlasByteCount_{0};
+
+        mutable long unsigned indexPosition_{0};
+        mutable int index_{0};
+
+        // oldest first
+        std::vector<std::unique_ptr<FrameAtlas>> atlases_;
     };
 }  // namespace detail
 
 class Image;
 using ImagePtr = std::shared_ptr<Image>;
+struct SharedMessageLayout;
 
 /// This class is thread safe.
 class Image : public std::enable_shared_from_this<Image>, boost::noncopyable
@@ -60,6 +111,8 @@ public:
     static ImagePtr getEmpty();
 
     const Url &url() const;
+    // loaded, load, width and height can be called from any thread, the
+    // message layout workers need them
     bool loaded() const;
     // either returns the current pixmap, or triggers loading it (lazy loading)
     boost::optional<QPixmap> pixmapOrLoad() const;
@@ -69,6 +122,22 @@ public:
     int width() const;
     int height() const;
     bool animated() const;
+    // The last time the image was painted or requested to be painted
+    std::chrono::steady_clock::time_point lastUsed() const;
+    // Can be called from any thread. Keeps ImageMemoryBudget from dropping
+    // the frames of an image which is on screen but painted from a buffer.
+    void markUsed() const;
+    // Gui thread only. Returns true if the animation moved to another frame
+    // on the last tick of the GIF timer.
+    bool frameChanged() const;
+    // Gui thread only. Paints the current frame of an animated image, all
+    // frames are scaled to the size of rect once and reused afterwards.
+    void paintAnimated(QPainter &painter, const QRect &rect) const;
+
+    // Gui thread only. Registers a layout which has been built or painted
+    // while the image wasn't loaded, see MessageLayoutCache::imageLoaded.
+    // Registering a layout again does nothing.
+    void addLayoutDependent(std::weak_ptr<SharedMessageLayout> layout);
 
     bool operator==(const Image &image) const;
     bool operator!=(const Image &image) const;
@@ -79,14 +148,28 @@ private:
     Image(qreal scale);
 
     void setPixmap(const QPixmap &pixmap);
+    void setFrames(std::unique_ptr<detail::Frames> frames);
     void actuallyLoad();
+    // Drops the decoded frames, they are loaded again from the disk cache
+    // the next time the image is painted. Returns the number of bytes freed.
+    int64_t expireFrames();
 
     const Url url_{};
     const qreal scale_{1};
     std::atomic_bool empty_{false};
+    std::atomic_bool shouldLoad_{false};
+
+    // mirror frames_ for other threads
+    std::atomic_bool loaded_{false};
+    std::atomic<QSize> size_{QSize(16, 16)};
+    std::atomic<std::chrono::steady_clock::rep> lastUsed_{0};
 
     // gui thread only
-    bool shouldLoad_{false};
     std::unique_ptr<detail::Frames> frames_{};
+    std::vector<std::weak_ptr<SharedMessageLayout>> layoutDependents_;
+
+    friend class ImageMemoryBudget;
+    // drops and sets frames without going through the network
+    friend class ImageTest;
 };
 }  // namespace chatterino
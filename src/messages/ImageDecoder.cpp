@@ -0,0 +1,97 @@
+#include "messages/ImageDecoder.hpp"
+
+#include "messages/Image.hpp"
+#include "util/DebugCount.hpp"
+#include "util/PostToThread.hpp"
+
+#include <QThread>
+
+#include <algorithm>
+#include <chrono>
+
+namespace chatterino {
+
+namespace {
+
+    // Images painted within this time are treated as visible
+    constexpr auto visibleTimeout = std::chrono::seconds(2);
+
+}  // namespace
+
+ImageDecoder &ImageDecoder::instance()
+{
+    static ImageDecoder instance;
+
+    return instance;
+}
+
+ImageDecoder::ImageDecoder()
+{
+    // decoding at startup shouldn't starve the network and layout threads
+    this->pool_.setMaxThreadCount(
+        std::clamp(QThread::idealThreadCount() / 2, 1, 4));
+}
+
+void ImageDecoder::schedule(std::weak_ptr<const Image> image,
+                            std::function<void()> decode)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        this->jobs_.push_back({std::move(image), std::move(decode)});
+        DebugCount::increase("image decodes queued");
+    }
+
+    // every runnable takes the most important job once it runs
+    this->pool_.start(new LambdaRunnable([this] {
+        Job job;
+        if (this->takeNext(job))
+        {
+            job.decode();
+        }
+    }));
+}
+
+bool ImageDecoder::takeNext(Job &job)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    // cancel decodes of images nobody uses anymore
+    auto size = this->jobs_.size();
+    this->jobs_.erase(std::remove_if(this->jobs_.begin(), this->jobs_.end(),
+                                     [](const Job &queued) {
+                                         return queued.image.expired();
+                                     }),
+                      this->jobs_.end());
+    if (auto cancelled = int64_t(size - this->jobs_.size()))
+    {
+        DebugCount::decrease("image decodes queued", cancelled);
+        DebugCount::increase("image decodes cancelled", cancelled);
+    }
+
+    if (this->jobs_.empty())
+    {
+        return false;
+    }
+
+    // visible images first, otherwise the oldest job
+    auto visibleSince = std::chrono::steady_clock::now() - visibleTimeout;
+    auto next = std::find_if(this->jobs_.begin(), this->jobs_.end(),
+                             [&](const Job &queued) {
+                                 auto image = queued.image.lock();
+                                 return image &&
+                                        image->lastUsed() >= visibleSince;
+                             });
+    if (next == this->jobs_.end())
+    {
+        next = this->jobs_.begin();
+    }
+
+    job = std::move(*next);
+    this->jobs_.erase(next);
+    DebugCount::decrease("image decodes queued");
+
+    return true;
+}
+
+}  // namespace chatterino
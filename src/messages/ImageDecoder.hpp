@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QThreadPool>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace chatterino {
+
+class Image;
+
+/// ImageDecoder decodes downloaded images on a small dedicated thread pool
+/// instead of the global one.
+///
+/// Images which have been painted recently, e.g. emotes in messages which
+/// are on screen, are decoded before all others. Images which have been
+/// deleted while waiting aren't decoded at all.
+class ImageDecoder
+{
+public:
+    static ImageDecoder &instance();
+
+    /// Runs decode on a worker thread unless image is gone by then
+    void schedule(std::weak_ptr<const Image> image,
+                  std::function<void()> decode);
+
+private:
+    struct Job {
+        std::weak_ptr<const Image> image;
+        std::function<void()> decode;
+    };
+
+    ImageDecoder();
+
+    // Takes the job to run next. Returns false if there are only jobs left
+    // whose image has been deleted.
+    bool takeNext(Job &job);
+
+    QThreadPool pool_;
+
+    std::mutex mutex_;
+    std::deque<Job> jobs_;
+};
+
+}  // namespace chatterino
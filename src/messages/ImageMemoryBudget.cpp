@@ -0,0 +1,115 @@
+#include "messages/ImageMemoryBudget.hpp"
+
+#include "debug/AssertInGuiThread.hpp"
+#include "messages/Image.hpp"
+#include "util/DebugCount.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace chatterino {
+
+namespace {
+
+    // Images painted within this time are never evicted, they are most
+    // likely on screen
+    constexpr auto minimumAge = std::chrono::minutes(1);
+
+}  // namespace
+
+ImageMemoryBudget &ImageMemoryBudget::instance()
+{
+    // never destroyed since images can outlive static objects
+    static auto *instance = new ImageMemoryBudget;
+
+    return *instance;
+}
+
+void ImageMemoryBudget::add(const std::shared_ptr<Image> &image, int64_t bytes)
+{
+    assertInGuiThread();
+
+    bool overBudget = false;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        auto &entry = this->entries_[image.get()];
+        this->bytes_ += bytes - entry.bytes;
+        entry = Entry{image, bytes};
+
+        overBudget = this->bytes_ > maxBytes;
+    }
+
+    if (overBudget)
+    {
+        this->evict();
+    }
+}
+
+void ImageMemoryBudget::remove(const Image *image)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    auto it = this->entries_.find(image);
+    if (it != this->entries_.end())
+    {
+        this->bytes_ -= it->second.bytes;
+        this->entries_.erase(it);
+    }
+}
+
+void ImageMemoryBudget::evict()
+{
+    std::vector<std::weak_ptr<Image>> images;
+    int64_t bytes = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        images.reserve(this->entries_.size());
+        for (const auto &entry : this->entries_)
+        {
+            images.push_back(entry.second.image);
+        }
+
+        bytes = this->bytes_;
+    }
+
+    // Locked outside of the mutex, releasing the last reference to an image
+    // removes it from the budget
+    auto usedSince = std::chrono::steady_clock::now() - minimumAge;
+    std::vector<std::pair<std::chrono::steady_clock::time_point,
+                          std::shared_ptr<Image>>>
+        candidates;
+
+    for (const auto &weak : images)
+    {
+        auto image = weak.lock();
+        if (image && image->lastUsed() < usedSince)
+        {
+            candidates.emplace_back(image->lastUsed(), std::move(image));
+        }
+    }
+
+    // least recently used first
+    std::sort(candidates.begin(), candidates.end(),
+              [](const auto &a, const auto &b) {
+                  return a.first < b.first;
+              });
+
+    for (auto &candidate : candidates)
+    {
+        if (bytes <= targetBytes)
+        {
+            break;
+        }
+
+        // expiring removes the image from the budget
+        bytes -= candidate.second->expireFrames();
+        DebugCount::increase("image evictions");
+    }
+}
+
+}  // namespace chatterino
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace chatterino {
+
+class Image;
+
+/// ImageMemoryBudget keeps the decoded frames of all images loaded from a url,
+/// including the frame atlases of animated images, within a memory budget.
+///
+/// Once the budget is exceeded, the frames of the images which haven't been
+/// painted for the longest time are dropped. Images in a message layout which
+/// is painted from its buffer count as painted, see Image::markUsed. The
+/// frames are decoded again from the disk cache the next time they are
+/// painted.
+class ImageMemoryBudget : boost::noncopyable
+{
+public:
+    // Frames are dropped once all images use more than this
+    static constexpr int64_t maxBytes = 512 * 1024 * 1024;
+    // and until they use less than this
+    static constexpr int64_t targetBytes = maxBytes / 4 * 3;
+
+    static ImageMemoryBudget &instance();
+
+    /// Gui thread only. Accounts the frames of image, which just loaded or
+    /// built a frame atlas. bytes replaces what was accounted before.
+    void add(const std::shared_ptr<Image> &image, int64_t bytes);
+    /// Can be called from any thread, e.g. when image is destroyed
+    void remove(const Image *image);
+
+private:
+    ImageMemoryBudget() = default;
+
+    void evict();
+
+    struct Entry {
+        std::weak_ptr<Image> image;
+        int64_t bytes;
+    };
+
+    std::mutex mutex_;
+    std::unordered_map<const Image *, Entry> entries_;
+    int64_t bytes_ = 0;
+};
+
+}  // namespace chatterino
@@ -2,17 +2,16 @@
 
 #include "messages/LimitedQueueSnapshot.hpp"
 
-#include <QDebug>
-
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 namespace chatterino {
 
-//
-// Warning:
-// - this class is so overengineered it's not even funny anymore
 //
 // Explanation:
 // - messages can be appended until 'limit' is reached
@@ -23,114 +22,94 @@ namespace chatterino {
 // - you are able to get a "Snapshot" which captures the state of this object
 // - adding items to this class does not change the "items" of the snapshot
 //
+// Implementation:
+// - items live in a fixed-capacity buffer that is a bit larger than 'limit'.
+//   The live items are the range [head, tail) of that buffer
+// - appending writes into the slot at 'tail', which no snapshot can see yet,
+//   and evicting only moves 'head' forward. Slots that were visible to a
+//   snapshot are never written to again
+// - once 'tail' reaches the end of the buffer, the live items are copied into
+//   a fresh buffer ("rebase"). Old snapshots keep the old buffer alive
+// - pushFront and replaceItem would have to write to visible slots, so they
+//   copy the buffer instead. Both are rare compared to pushBack
+// - the current (buffer, head, tail) triple is published through a sequence
+//   lock, so getSnapshot is O(1) and never waits for a writer to release a
+//   lock. Writers are serialized by writeMutex_, which readers never take
+//
 
 template <typename T>
 class LimitedQueue
 {
 protected:
-    using Chunk = std::vector<T>;
-    using ChunkVector = std::vector<std::shared_ptr<Chunk>>;
+    using Buffer = std::vector<T>;
 
 public:
     LimitedQueue(size_t limit = 1000)
         : limit_(limit)
+        , capacity_(limit + std::max<size_t>(limit / 4, 32))
     {
         this->clear();
     }
 
     void clear()
     {
-        std::lock_guard<std::mutex> lock(this->mutex_);
-
-        this->chunks_ = std::make_shared<ChunkVector>();
-        auto chunk = std::make_shared<Chunk>();
-        chunk->resize(this->chunkSize_);
-        this->chunks_->push_back(chunk);
-        this->firstChunkOffset_ = 0;
-        this->lastChunkEnd_ = 0;
+        std::lock_guard<std::mutex> lock(this->writeMutex_);
+
+        this->publish(std::make_shared<Buffer>(this->capacity_), 0, 0);
     }
 
     // return true if an item was deleted
     // deleted will be set if the item was deleted
     bool pushBack(const T &item, T &deleted)
     {
-        std::lock_guard<std::mutex> lock(this->mutex_);
+        std::lock_guard<std::mutex> lock(this->writeMutex_);
 
-        auto lastChunk = this->chunks_->back();
+        auto head = this->head_.load(std::memory_order_relaxed);
+        auto tail = this->tail_.load(std::memory_order_relaxed);
+        bool didDelete = false;
 
-        if (lastChunk->size() <= this->lastChunkEnd_)
+        if (tail - head >= this->limit_)
         {
-            // Last chunk is full, create a new one and rebuild our chunk vector
-            auto newVector = std::make_shared<ChunkVector>();
-
-            // copy chunks
-            for (auto &chunk : *this->chunks_)
-            {
-                newVector->push_back(chunk);
-            }
-
-            // push back new chunk
-            auto newChunk = std::make_shared<Chunk>();
-            newChunk->resize(this->chunkSize_);
-            newVector->push_back(newChunk);
-
-            // replace current chunk vector
-            this->chunks_ = newVector;
-            this->lastChunkEnd_ = 0;
-            lastChunk = this->chunks_->back();
+            deleted = (*this->buffer_)[head];
+            head++;
+            didDelete = true;
         }
 
-        lastChunk->at(this->lastChunkEnd_++) = item;
+        if (tail < this->capacity_)
+        {
+            // the slot at tail is not part of any snapshot yet
+            (*this->buffer_)[tail] = item;
+            this->publish(this->buffer_, head, tail + 1);
+        }
+        else
+        {
+            auto buffer = this->copyLiveItems(head, tail, 0);
+            (*buffer)[tail - head] = item;
+            this->publish(std::move(buffer), 0, tail - head + 1);
+        }
 
-        return this->deleteFirstItem(deleted);
+        return didDelete;
     }
 
     // returns a vector with all the accepted items
     std::vector<T> pushFront(const std::vector<T> &items)
     {
-        std::vector<T> acceptedItems;
-
-        if (this->space() > 0)
-        {
-            std::lock_guard<std::mutex> lock(this->mutex_);
-
-            // create new vector to clone chunks into
-            auto newChunks = std::make_shared<ChunkVector>();
+        std::lock_guard<std::mutex> lock(this->writeMutex_);
 
-            newChunks->resize(this->chunks_->size());
+        auto head = this->head_.load(std::memory_order_relaxed);
+        auto tail = this->tail_.load(std::memory_order_relaxed);
 
-            // copy chunks except for first one
-            for (size_t i = 1; i < this->chunks_->size(); i++)
-            {
-                newChunks->at(i) = this->chunks_->at(i);
-            }
-
-            // create new chunk for the first one
-            size_t offset =
-                std::min(this->space(), static_cast<qsizetype>(items.size()));
-            auto newFirstChunk = std::make_shared<Chunk>();
-            newFirstChunk->resize(this->chunks_->front()->size() + offset);
-
-            for (size_t i = 0; i < offset; i++)
-            {
-                newFirstChunk->at(i) = items[items.size() - offset + i];
-                acceptedItems.push_back(items[items.size() - offset + i]);
-            }
-
-            for (size_t i = 0; i < this->chunks_->at(0)->size(); i++)
-            {
-                newFirstChunk->at(i + offset) = this->chunks_->at(0)->at(i);
-            }
-
-            newChunks->at(0) = newFirstChunk;
+        size_t offset = std::min(this->limit_ - (tail - head), items.size());
+        if (offset == 0)
+        {
+            return {};
+        }
 
-            this->chunks_ = newChunks;
+        std::vector<T> acceptedItems(items.end() - offset, items.end());
 
-            if (this->chunks_->size() == 1)
-            {
-                this->lastChunkEnd_ += offset;
-            }
-        }
+        auto buffer = this->copyLiveItems(head, tail, offset);
+        std::copy(acceptedItems.begin(), acceptedItems.end(), buffer->begin());
+        this->publish(std::move(buffer), 0, tail - head + offset);
 
         return acceptedItems;
     }
@@ -138,36 +117,17 @@ public:
     // replace an single item, return index if successful, -1 if unsuccessful
     int replaceItem(const T &item, const T &replacement)
     {
-        std::lock_guard<std::mutex> lock(this->mutex_);
+        std::lock_guard<std::mutex> lock(this->writeMutex_);
 
-        int x = 0;
+        auto head = this->head_.load(std::memory_order_relaxed);
+        auto tail = this->tail_.load(std::memory_order_relaxed);
 
-        for (size_t i = 0; i < this->chunks_->size(); i++)
+        for (size_t i = head; i < tail; i++)
         {
-            auto &chunk = this->chunks_->at(i);
-
-            size_t start = i == 0 ? this->firstChunkOffset_ : 0;
-            size_t end =
-                i == chunk->size() - 1 ? this->lastChunkEnd_ : chunk->size();
-
-            for (size_t j = start; j < end; j++)
+            if ((*this->buffer_)[i] == item)
             {
-                if (chunk->at(j) == item)
-                {
-                    auto newChunk = std::make_shared<Chunk>();
-                    newChunk->resize(chunk->size());
-
-                    for (size_t k = 0; k < chunk->size(); k++)
-                    {
-                        newChunk->at(k) = chunk->at(k);
-                    }
-
-                    newChunk->at(j) = replacement;
-                    this->chunks_->at(i) = newChunk;
-
-                    return x;
-                }
-                x++;
+                this->replaceAt(head, tail, i - head, replacement);
+                return int(i - head);
             }
         }
 
@@ -177,121 +137,103 @@ public:
     // replace an item at index, return true if worked
     bool replaceItem(size_t index, const T &replacement)
     {
-        std::lock_guard<std::mutex> lock(this->mutex_);
+        std::lock_guard<std::mutex> lock(this->writeMutex_);
 
-        size_t x = 0;
+        auto head = this->head_.load(std::memory_order_relaxed);
+        auto tail = this->tail_.load(std::memory_order_relaxed);
 
-        for (size_t i = 0; i < this->chunks_->size(); i++)
+        if (index >= tail - head)
         {
-            auto &chunk = this->chunks_->at(i);
+            return false;
+        }
 
-            size_t start = i == 0 ? this->firstChunkOffset_ : 0;
-            size_t end =
-                i == chunk->size() - 1 ? this->lastChunkEnd_ : chunk->size();
+        this->replaceAt(head, tail, index, replacement);
+        return true;
+    }
 
-            for (size_t j = start; j < end; j++)
+    LimitedQueueSnapshot<T> getSnapshot() const
+    {
+        while (true)
+        {
+            auto version = this->version_.load(std::memory_order_acquire);
+            if (version & 1)
             {
-                if (x == index)
-                {
-                    auto newChunk = std::make_shared<Chunk>();
-                    newChunk->resize(chunk->size());
-
-                    for (size_t k = 0; k < chunk->size(); k++)
-                    {
-                        newChunk->at(k) = chunk->at(k);
-                    }
-
-                    newChunk->at(j) = replacement;
-                    this->chunks_->at(i) = newChunk;
-
-                    return true;
-                }
-                x++;
+                // a writer is currently publishing a new state
+                std::this_thread::yield();
+                continue;
             }
-        }
-        return false;
-    }
 
-    //    void insertAfter(const std::vector<T> &items, const T &index)
+            auto buffer = std::atomic_load(&this->publishedBuffer_);
+            auto head = this->head_.load(std::memory_order_relaxed);
+            auto tail = this->tail_.load(std::memory_order_relaxed);
 
-    LimitedQueueSnapshot<T> getSnapshot()
-    {
-        std::lock_guard<std::mutex> lock(this->mutex_);
-
-        return LimitedQueueSnapshot<T>(
-            this->chunks_, this->limit_ - this->space(),
-            this->firstChunkOffset_, this->lastChunkEnd_);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (this->version_.load(std::memory_order_relaxed) == version)
+            {
+                return LimitedQueueSnapshot<T>(std::move(buffer), head,
+                                               tail - head);
+            }
+        }
     }
 
     bool empty() const
     {
-        return this->limit_ - this->space() == 0;
+        return this->tail_.load(std::memory_order_relaxed) ==
+               this->head_.load(std::memory_order_relaxed);
     }
 
 private:
-    qsizetype space() const
+    // Copies the live items into a new buffer, leaving 'gap' empty slots in
+    // front of them
+    std::shared_ptr<Buffer> copyLiveItems(size_t head, size_t tail,
+                                          size_t gap) const
     {
-        size_t totalSize = 0;
-        for (auto &chunk : *this->chunks_)
-        {
-            totalSize += chunk->size();
-        }
+        auto buffer = std::make_shared<Buffer>(this->capacity_);
+        std::copy(this->buffer_->begin() + head, this->buffer_->begin() + tail,
+                  buffer->begin() + gap);
 
-        totalSize -= this->chunks_->back()->size() - this->lastChunkEnd_;
-        if (this->chunks_->size() != 1)
-        {
-            totalSize -= this->firstChunkOffset_;
-        }
-
-        return this->limit_ - totalSize;
+        return buffer;
     }
 
-    bool deleteFirstItem(T &deleted)
+    void replaceAt(size_t head, size_t tail, size_t index,
+                   const T &replacement)
     {
-        // determine if the first chunk should be deleted
-        if (space() > 0)
-        {
-            return false;
-        }
-
-        deleted = this->chunks_->front()->at(this->firstChunkOffset_);
-
-        // need to delete the first chunk
-        if (this->firstChunkOffset_ == this->chunks_->front()->size() - 1)
-        {
-            // copy the chunk vector
-            auto newVector = std::make_shared<ChunkVector>();
+        auto buffer = this->copyLiveItems(head, tail, 0);
+        (*buffer)[index] = replacement;
+        this->publish(std::move(buffer), 0, tail - head);
+    }
 
-            // delete first chunk
-            bool first = true;
-            for (auto &chunk : *this->chunks_)
-            {
-                if (!first)
-                {
-                    newVector->push_back(chunk);
-                }
-                first = false;
-            }
+    // Must be called with writeMutex_ held
+    void publish(std::shared_ptr<Buffer> buffer, size_t head, size_t tail)
+    {
+        auto version = this->version_.load(std::memory_order_relaxed);
+        this->version_.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
 
-            this->chunks_ = newVector;
-            this->firstChunkOffset_ = 0;
-        }
-        else
+        if (buffer != this->buffer_)
         {
-            this->firstChunkOffset_++;
+            this->buffer_ = buffer;
+            std::atomic_store(&this->publishedBuffer_,
+                              std::shared_ptr<const Buffer>(std::move(buffer)));
         }
+        this->head_.store(head, std::memory_order_relaxed);
+        this->tail_.store(tail, std::memory_order_relaxed);
 
-        return true;
+        this->version_.store(version + 2, std::memory_order_release);
     }
 
-    std::shared_ptr<ChunkVector> chunks_;
-    std::mutex mutex_;
+    // writer side of the buffer, only touched with writeMutex_ held
+    std::shared_ptr<Buffer> buffer_;
+    std::mutex writeMutex_;
 
-    size_t firstChunkOffset_;
-    size_t lastChunkEnd_;
-    const size_t limit_;
+    // reader side, see getSnapshot
+    std::shared_ptr<const Buffer> publishedBuffer_;
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+    std::atomic<uint64_t> version_{0};
 
-    const size_t chunkSize_ = 100;
+    const size_t limit_;
+    const size_t capacity_;
 };
 
 }  // namespace chatterino
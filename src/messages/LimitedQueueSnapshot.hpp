@@ -12,13 +12,11 @@ class LimitedQueueSnapshot
 public:
     LimitedQueueSnapshot() = default;
 
-    LimitedQueueSnapshot(
-        std::shared_ptr<std::vector<std::shared_ptr<std::vector<T>>>> chunks,
-        size_t length, size_t firstChunkOffset, size_t lastChunkEnd)
-        : chunks_(chunks)
+    LimitedQueueSnapshot(std::shared_ptr<const std::vector<T>> buffer,
+                         size_t offset, size_t length)
+        : buffer_(std::move(buffer))
+        , offset_(offset)
         , length_(length)
-        , firstChunkOffset_(firstChunkOffset)
-        , lastChunkEnd_(lastChunkEnd)
     {
     }
 
@@ -29,32 +27,19 @@ public:
 
     T const &operator[](std::size_t index) const
     {
-        index += this->firstChunkOffset_;
+        assert(index < this->length_ && "out of range");
 
-        size_t x = 0;
-
-        for (size_t i = 0; i < this->chunks_->size(); i++)
-        {
-            auto &chunk = this->chunks_->at(i);
-
-            if (x <= index && x + chunk->size() > index)
-            {
-                return chunk->at(index - x);
-            }
-            x += chunk->size();
-        }
-
-        assert(false && "out of range");
-
-        return this->chunks_->at(0)->at(0);
+        return (*this->buffer_)[this->offset_ + index];
     }
 
 private:
-    std::shared_ptr<std::vector<std::shared_ptr<std::vector<T>>>> chunks_;
+    // The buffer is shared with the queue that created this snapshot. The
+    // queue never writes to a slot that is visible to a snapshot, so the
+    // range [offset_, offset_ + length_) is immutable.
+    std::shared_ptr<const std::vector<T>> buffer_;
 
+    size_t offset_ = 0;
     size_t length_ = 0;
-    size_t firstChunkOffset_ = 0;
-    size_t lastChunkEnd_ = 0;
 };
 
 }  // namespace chatterino
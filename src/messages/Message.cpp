@@ -2,6 +2,7 @@
 
 #include "Application.hpp"
 #include "MessageElement.hpp"
+#include "messages/MessageSimilarity.hpp"
 #include "providers/twitch/PubSubActions.hpp"
 #include "singletons/Theme.hpp"
 #include "util/DebugCount.hpp"
@@ -6,12 +6,16 @@
 
 #include <QTime>
 #include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+
+#include <array>
 #include <cinttypes>
 #include <memory>
 #include <vector>
 
 namespace chatterino {
 class MessageElement;
+class MessageSimilarity;
 
 enum class MessageFlag : uint32_t {
     None = 0,
@@ -42,6 +46,49 @@ enum class MessageFlag : uint32_t {
 };
 using MessageFlags = FlagsEnum<MessageFlag>;
 
+/// Remembers the results of the last few filters which ran on a message, so
+/// a filter used by multiple views only runs once per message.
+/// Filters are identified by FilterRecord::cacheKey, which changes whenever a
+/// filter is reloaded.
+class FilterResultMemo
+{
+public:
+    boost::optional<bool> get(uint64_t key) const
+    {
+        for (size_t i = 0; i < this->keys_.size(); i++)
+        {
+            if (this->keys_[i] == key)
+            {
+                return bool(this->results_ & (1 << i));
+            }
+        }
+        return boost::none;
+    }
+
+    void set(uint64_t key, bool result)
+    {
+        // replace the oldest entry
+        auto i = this->next_;
+        this->next_ = (this->next_ + 1) % this->keys_.size();
+
+        this->keys_[i] = key;
+        if (result)
+        {
+            this->results_ |= uint8_t(1 << i);
+        }
+        else
+        {
+            this->results_ &= uint8_t(~(1 << i));
+        }
+    }
+
+private:
+    // 0 marks an empty entry
+    std::array<uint64_t, 8> keys_{};
+    uint8_t results_ = 0;
+    uint8_t next_ = 0;
+};
+
 struct Message : boost::noncopyable {
     Message();
     ~Message();
@@ -65,9 +112,15 @@ struct Message : boost::noncopyable {
     QColor usernameColor;
     std::vector<Badge> badges;
     std::map<QString, QString> badgeInfos;
+    // the IRC line the message was parsed from, only kept for structured logs
+    QByteArray ircLine;
     std::shared_ptr<QColor> highlightColor;
     uint32_t count = 1;
     std::vector<std::unique_ptr<MessageElement>> elements;
+    // Only used from the GUI thread, see FilterSet::filter
+    mutable FilterResultMemo filterResults;
+    // Only used from the GUI thread, see MessageSimilarity::of
+    mutable std::unique_ptr<const MessageSimilarity> similarity;
 
     ScrollbarHighlight getScrollBarHighlight() const;
 };
@@ -5,10 +5,13 @@
 #include "messages/Emote.hpp"
 #include "messages/layouts/MessageLayoutContainer.hpp"
 #include "messages/layouts/MessageLayoutElement.hpp"
+#include "messages/layouts/TextWidthCache.hpp"
 #include "singletons/Settings.hpp"
 #include "singletons/Theme.hpp"
 #include "util/DebugCount.hpp"
 
+#include <cstring>
+
 namespace chatterino {
 
 MessageElement::MessageElement(MessageElementFlags flags)
@@ -127,8 +130,10 @@ void ImageElement::addToContainer(MessageLayoutContainer &container,
         auto size = QSize(this->image_->width() * container.getScale(),
                           this->image_->height() * container.getScale());
 
-        container.addElement((new ImageLayoutElement(*this, this->image_, size))
-                                 ->setLink(this->getLink()));
+        container.addElement(
+            container
+                .createElement<ImageLayoutElement>(*this, this->image_, size)
+                ->setLink(this->getLink()));
     }
 }
 
@@ -167,8 +172,9 @@ void EmoteElement::addToContainer(MessageLayoutContainer &container,
                 QSize(int(container.getScale() * image->width() * emoteScale),
                       int(container.getScale() * image->height() * emoteScale));
 
-            container.addElement(this->makeImageLayoutElement(image, size)
-                                     ->setLink(this->getLink()));
+            container.addElement(
+                this->makeImageLayoutElement(container, image, size)
+                    ->setLink(this->getLink()));
         }
         else
         {
@@ -182,9 +188,9 @@ void EmoteElement::addToContainer(MessageLayoutContainer &container,
 }
 
 MessageLayoutElement *EmoteElement::makeImageLayoutElement(
-    const ImagePtr &image, const QSize &size)
+    MessageLayoutContainer &container, const ImagePtr &image, const QSize &size)
 {
-    return new ImageLayoutElement(*this, image, size);
+    return container.createElement<ImageLayoutElement>(*this, image, size);
 }
 
 // BADGE
@@ -208,7 +214,8 @@ void BadgeElement::addToContainer(MessageLayoutContainer &container,
         auto size = QSize(int(container.getScale() * image->width()),
                           int(container.getScale() * image->height()));
 
-        container.addElement(this->makeImageLayoutElement(image, size));
+        container.addElement(
+            this->makeImageLayoutElement(container, image, size));
     }
 }
 
@@ -218,10 +225,11 @@ EmotePtr BadgeElement::getEmote() const
 }
 
 MessageLayoutElement *BadgeElement::makeImageLayoutElement(
-    const ImagePtr &image, const QSize &size)
+    MessageLayoutContainer &container, const ImagePtr &image, const QSize &size)
 {
     auto element =
-        (new ImageLayoutElement(*this, image, size))->setLink(this->getLink());
+        container.createElement<ImageLayoutElement>(*this, image, size)
+            ->setLink(this->getLink());
 
     return element;
 }
@@ -234,12 +242,13 @@ ModBadgeElement::ModBadgeElement(const EmotePtr &data,
 }
 
 MessageLayoutElement *ModBadgeElement::makeImageLayoutElement(
-    const ImagePtr &image, const QSize &size)
+    MessageLayoutContainer &container, const ImagePtr &image, const QSize &size)
 {
     static const QColor modBadgeBackgroundColor("#34AE0A");
 
-    auto element = (new ImageWithBackgroundLayoutElement(
-                        *this, image, size, modBadgeBackgroundColor))
+    auto element = container
+                       .createElement<ImageWithBackgroundLayoutElement>(
+                           *this, image, size, modBadgeBackgroundColor)
                        ->setLink(this->getLink());
 
     return element;
@@ -253,10 +262,11 @@ VipBadgeElement::VipBadgeElement(const EmotePtr &data,
 }
 
 MessageLayoutElement *VipBadgeElement::makeImageLayoutElement(
-    const ImagePtr &image, const QSize &size)
+    MessageLayoutContainer &container, const ImagePtr &image, const QSize &size)
 {
     auto element =
-        (new ImageLayoutElement(*this, image, size))->setLink(this->getLink());
+        container.createElement<ImageLayoutElement>(*this, image, size)
+            ->setLink(this->getLink());
 
     return element;
 }
@@ -270,16 +280,68 @@ FfzBadgeElement::FfzBadgeElement(const EmotePtr &data,
 }
 
 MessageLayoutElement *FfzBadgeElement::makeImageLayoutElement(
-    const ImagePtr &image, const QSize &size)
+    MessageLayoutContainer &container, const ImagePtr &image, const QSize &size)
 {
-    auto element =
-        (new ImageWithBackgroundLayoutElement(*this, image, size, this->color))
-            ->setLink(this->getLink());
+    auto element = container
+                       .createElement<ImageWithBackgroundLayoutElement>(
+                           *this, image, size, this->color)
+                       ->setLink(this->getLink());
 
     return element;
 }
 
 // TEXT
+namespace {
+
+    // The scale, the TextWidthCache generation and the width of a word in one
+    // value, so it can be updated atomically. 0 means there's no width yet.
+    uint64_t packWordWidth(float scale, uint32_t generation, int width)
+    {
+        uint32_t scaleBits;
+        std::memcpy(&scaleBits, &scale, sizeof(scaleBits));
+
+        return (uint64_t(scaleBits) << 32) |
+               (uint64_t(generation & 0xffff) << 16) | uint64_t(width);
+    }
+
+}  // namespace
+
+TextElement::Word::Word(QString text_)
+    : text(std::move(text_))
+{
+}
+
+TextElement::Word::Word(const Word &other)
+    : text(other.text)
+    , width_(other.width_.load())
+{
+}
+
+int TextElement::Word::width(FontStyle style, float scale,
+                             const QFontMetrics &metrics) const
+{
+    auto generation = TextWidthCache::instance().generation();
+
+    auto packed = this->width_.load(std::memory_order_relaxed);
+    if (packed != 0 &&
+        (packed & ~uint64_t(0xffff)) == packWordWidth(scale, generation, 0))
+    {
+        return int(packed & 0xffff);
+    }
+
+    auto width =
+        TextWidthCache::instance().width(style, scale, metrics, this->text);
+
+    // wider words are rare, they are still cached in TextWidthCache
+    if (width >= 0 && width <= 0xffff)
+    {
+        this->width_.store(packWordWidth(scale, generation, width),
+                           std::memory_order_relaxed);
+    }
+
+    return width;
+}
+
 TextElement::TextElement(const QString &text, MessageElementFlags flags,
                          const MessageColor &color, FontStyle style)
     : MessageElement(flags)
@@ -288,7 +350,7 @@ TextElement::TextElement(const QString &text, MessageElementFlags flags,
 {
     for (const auto &word : text.split(' '))
     {
-        this->words_.push_back({word, -1});
+        this->words_.emplace_back(word);
         // fourtf: add logic to store multiple spaces after message
     }
 }
@@ -296,46 +358,42 @@ TextElement::TextElement(const QString &text, MessageElementFlags flags,
 void TextElement::addToContainer(MessageLayoutContainer &container,
                                  MessageElementFlags flags)
 {
-    auto app = getApp();
+    // this may run on a layout worker thread, so don't use getApp()
+    auto theme = getTheme();
 
     if (flags.hasAny(this->getFlags()))
     {
         QFontMetrics metrics =
-            app->fonts->getFontMetrics(this->style_, container.getScale());
+            getFonts()->getFontMetrics(this->style_, container.getScale());
 
-        for (Word &word : this->words_)
+        for (const Word &word : this->words_)
         {
             auto getTextLayoutElement = [&](QString text, int width,
                                             bool hasTrailingSpace) {
-                auto color = this->color_.getColor(*app->themes);
-                app->themes->normalizeColor(color);
+                auto color = this->color_.getColor(*theme);
+                theme->normalizeColor(color);
 
-                auto e = (new TextLayoutElement(
-                              *this, text, QSize(width, metrics.height()),
-                              color, this->style_, container.getScale()))
+                auto e = container
+                             .createElement<TextLayoutElement>(
+                                 *this, text, QSize(width, metrics.height()),
+                                 color, this->style_, container.getScale())
                              ->setLink(this->getLink());
                 e->setTrailingSpace(hasTrailingSpace);
-                e->setText(text);
 
-                // If URL link was changed,
-                // Should update it in MessageLayoutElement too!
-                if (this->getLink().type == Link::Url)
-                {
-                    static_cast<TextLayoutElement *>(e)->listenToLinkChanges();
-                }
+                // URL links can still change, the layout element starts
+                // listening to them in MessageLayoutContainer::
+                // listenToLinkChanges once the layout is installed
                 return e;
             };
 
-            // fourtf: add again
-            //            if (word.width == -1) {
-            word.width = metrics.horizontalAdvance(word.text);
-            //            }
+            auto wordWidth =
+                word.width(this->style_, container.getScale(), metrics);
 
             // see if the text fits in the current line
-            if (container.fitsInLine(word.width))
+            if (container.fitsInLine(wordWidth))
             {
                 container.addElementNoLineBreak(getTextLayoutElement(
-                    word.text, word.width, this->hasTrailingSpace()));
+                    word.text, wordWidth, this->hasTrailingSpace()));
                 continue;
             }
 
@@ -344,10 +402,10 @@ void TextElement::addToContainer(MessageLayoutContainer &container,
             {
                 container.breakLine();
 
-                if (container.fitsInLine(word.width))
+                if (container.fitsInLine(wordWidth))
                 {
                     container.addElementNoLineBreak(getTextLayoutElement(
-                        word.text, word.width, this->hasTrailingSpace()));
+                        word.text, wordWidth, this->hasTrailingSpace()));
                     continue;
                 }
             }
@@ -409,6 +467,9 @@ void TimestampElement::addToContainer(MessageLayoutContainer &container,
 {
     if (flags.hasAny(this->getFlags()))
     {
+        // layouts of the same message may be built on several threads
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
         if (getSettings()->timestampFormat != this->format_)
         {
             this->format_ = getSettings()->timestampFormat.getValue();
@@ -438,25 +499,31 @@ TwitchModerationElement::TwitchModerationElement()
 void TwitchModerationElement::addToContainer(MessageLayoutContainer &container,
                                              MessageElementFlags flags)
 {
-    if (flags.has(MessageElementFlag::ModeratorTools))
+    // the actions are taken from the request since this may run on a layout
+    // worker thread
+    const auto &actions = container.getModerationActions();
+
+    if (flags.has(MessageElementFlag::ModeratorTools) && actions)
     {
         QSize size(int(container.getScale() * 16),
                    int(container.getScale() * 16));
-        auto actions = getCSettings().moderationActions.readOnly();
         for (const auto &action : *actions)
         {
             if (auto image = action.getImage())
             {
                 container.addElement(
-                    (new ImageLayoutElement(*this, image.get(), size))
+                    container
+                        .createElement<ImageLayoutElement>(*this, image.get(),
+                                                           size)
                         ->setLink(Link(Link::UserAction, action.getAction())));
             }
             else
             {
                 container.addElement(
-                    (new TextIconLayoutElement(*this, action.getLine1(),
-                                               action.getLine2(),
-                                               container.getScale(), size))
+                    container
+                        .createElement<TextIconLayoutElement>(
+                            *this, action.getLine1(), action.getLine2(),
+                            container.getScale(), size)
                         ->setLink(Link(Link::UserAction, action.getAction())));
             }
         }
@@ -497,8 +564,9 @@ void ScalingImageElement::addToContainer(MessageLayoutContainer &container,
         auto size = QSize(image->width() * container.getScale(),
                           image->height() * container.getScale());
 
-        container.addElement((new ImageLayoutElement(*this, image, size))
-                                 ->setLink(this->getLink()));
+        container.addElement(
+            container.createElement<ImageLayoutElement>(*this, image, size)
+                ->setLink(this->getLink()));
     }
 }
 
@@ -10,8 +10,10 @@
 #include <QString>
 #include <QTime>
 #include <boost/noncopyable.hpp>
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <pajlada/signals/signalholder.hpp>
 #include <vector>
 
@@ -163,6 +165,9 @@ public:
     MessageElementFlags getFlags() const;
     MessageElement *updateLink();
 
+    // May be called from a layout worker thread and for several containers
+    // at once, so implementations must not modify the element without
+    // synchronization or use gui thread only singletons like getApp()
     virtual void addToContainer(MessageLayoutContainer &container,
                                 MessageElementFlags flags) = 0;
 
@@ -226,8 +231,20 @@ private:
     FontStyle style_;
 
     struct Word {
+        explicit Word(QString text_);
+        Word(const Word &other);
+
+        // Returns the width of the word and caches it for the scale of the
+        // last layout
+        int width(FontStyle style, float scale,
+                  const QFontMetrics &metrics) const;
+
         QString text;
-        int width = -1;
+
+    private:
+        // layouts of the same message may be built on several threads, see
+        // packWordWidth for the layout
+        mutable std::atomic<uint64_t> width_{0};
     };
     std::vector<Word> words_;
 };
@@ -246,8 +263,9 @@ public:
     EmotePtr getEmote() const;
 
 protected:
-    virtual MessageLayoutElement *makeImageLayoutElement(const ImagePtr &image,
-                                                         const QSize &size);
+    virtual MessageLayoutElement *makeImageLayoutElement(
+        MessageLayoutContainer &container, const ImagePtr &image,
+        const QSize &size);
 
 private:
     std::unique_ptr<TextElement> textElement_;
@@ -265,8 +283,9 @@ public:
     EmotePtr getEmote() const;
 
 protected:
-    virtual MessageLayoutElement *makeImageLayoutElement(const ImagePtr &image,
-                                                         const QSize &size);
+    virtual MessageLayoutElement *makeImageLayoutElement(
+        MessageLayoutContainer &container, const ImagePtr &image,
+        const QSize &size);
 
 private:
     EmotePtr emote_;
@@ -278,8 +297,9 @@ public:
     ModBadgeElement(const EmotePtr &data, MessageElementFlags flags_);
 
 protected:
-    MessageLayoutElement *makeImageLayoutElement(const ImagePtr &image,
-                                                 const QSize &size) override;
+    MessageLayoutElement *makeImageLayoutElement(
+        MessageLayoutContainer &container, const ImagePtr &image,
+        const QSize &size) override;
 };
 
 class VipBadgeElement : public BadgeElement
@@ -288,8 +308,9 @@ public:
     VipBadgeElement(const EmotePtr &data, MessageElementFlags flags_);
 
 protected:
-    MessageLayoutElement *makeImageLayoutElement(const ImagePtr &image,
-                                                 const QSize &size) override;
+    MessageLayoutElement *makeImageLayoutElement(
+        MessageLayoutContainer &container, const ImagePtr &image,
+        const QSize &size) override;
 };
 
 class FfzBadgeElement : public BadgeElement
@@ -299,8 +320,9 @@ public:
                     QColor &color);
 
 protected:
-    MessageLayoutElement *makeImageLayoutElement(const ImagePtr &image,
-                                                 const QSize &size) override;
+    MessageLayoutElement *makeImageLayoutElement(
+        MessageLayoutContainer &container, const ImagePtr &image,
+        const QSize &size) override;
     QColor color;
 };
 
@@ -318,6 +340,8 @@ public:
 
 private:
     QTime time_;
+    // guards element_ and format_
+    std::mutex mutex_;
     std::unique_ptr<TextElement> element_;
     QString format_;
 };
@@ -0,0 +1,268 @@
+#include "messages/MessageIndex.hpp"
+
+#include "messages/Message.hpp"
+
+#include <algorithm>
+
+namespace chatterino {
+
+namespace {
+
+    bool isTimeoutMessage(const Message &message)
+    {
+        return !message.timeoutUser.isEmpty() &&
+               message.flags.hasAny(
+                   {MessageFlag::Timeout, MessageFlag::Untimeout});
+    }
+
+    // Returns the lower case user names a message should be listed under
+    std::vector<QString> userKeys(const Message &message)
+    {
+        std::vector<QString> keys;
+        auto addKey = [&keys](const QString &userName) {
+            auto key = userName.toLower();
+            if (!key.isEmpty() &&
+                std::find(keys.begin(), keys.end(), key) == keys.end())
+            {
+                keys.push_back(std::move(key));
+            }
+        };
+
+        addKey(message.loginName);
+        addKey(message.timeoutUser);
+
+        // subscription messages without a sender start with the user name
+        if (message.loginName.isEmpty() &&
+            message.flags.has(MessageFlag::Subscription))
+        {
+            addKey(message.messageText.section(' ', 0, 0));
+        }
+
+        return keys;
+    }
+
+}  // namespace
+
+void MessageIndex::clear()
+{
+    this->byId_.clear();
+    this->lastTimeoutByUser_.clear();
+    this->byUser_.clear();
+    this->firstSequence_ = 0;
+    this->nextSequence_ = 0;
+    this->disabledUntilSequence_ = 0;
+}
+
+void MessageIndex::append(const MessagePtr &message)
+{
+    this->add(message, this->nextSequence_++);
+}
+
+void MessageIndex::prepend(const std::vector<MessagePtr> &messages)
+{
+    this->firstSequence_ -= int64_t(messages.size());
+
+    for (size_t i = 0; i < messages.size(); i++)
+    {
+        this->add(messages[i], this->firstSequence_ + int64_t(i));
+    }
+
+    // the new messages haven't been disabled yet
+    this->disabledUntilSequence_ = this->firstSequence_;
+}
+
+void MessageIndex::removeFirst(const MessagePtr &message)
+{
+    this->remove(message, this->firstSequence_++);
+}
+
+void MessageIndex::replace(size_t index, const MessagePtr &previous,
+                           const MessagePtr &replacement)
+{
+    auto sequence = this->firstSequence_ + int64_t(index);
+
+    this->remove(previous, sequence);
+    this->add(replacement, sequence);
+
+    this->disabledUntilSequence_ =
+        std::min(this->disabledUntilSequence_, sequence);
+}
+
+boost::optional<size_t> MessageIndex::findById(const QString &id) const
+{
+    return this->position(this->byId_, id);
+}
+
+boost::optional<size_t> MessageIndex::findLastTimeout(
+    const QString &user) const
+{
+    return this->position(this->lastTimeoutByUser_, user);
+}
+
+boost::optional<size_t> MessageIndex::find(const MessagePtr &message) const
+{
+    auto check = [&](const EntryMap &map,
+                     const QString &key) -> boost::optional<size_t> {
+        auto it = map.find(key);
+        if (it == map.end() || it->second.message != message.get())
+        {
+            return boost::none;
+        }
+        return size_t(it->second.sequence - this->firstSequence_);
+    };
+
+    if (!message->id.isEmpty())
+    {
+        if (auto index = check(this->byId_, message->id))
+        {
+            return index;
+        }
+    }
+
+    if (isTimeoutMessage(*message))
+    {
+        return check(this->lastTimeoutByUser_, message->timeoutUser);
+    }
+
+    return boost::none;
+}
+
+std::vector<size_t> MessageIndex::findByUser(const QString &userName) const
+{
+    auto it = this->byUser_.find(userName.toLower());
+    if (it == this->byUser_.end())
+    {
+        return {};
+    }
+
+    std::vector<size_t> positions;
+    positions.reserve(it->second.size());
+    for (auto sequence : it->second)
+    {
+        positions.push_back(size_t(sequence - this->firstSequence_));
+    }
+
+    return positions;
+}
+
+size_t MessageIndex::disabledUntil() const
+{
+    auto position = this->disabledUntilSequence_ - this->firstSequence_;
+
+    return size_t(std::max<int64_t>(0, position));
+}
+
+void MessageIndex::setDisabledUntil(size_t position)
+{
+    this->disabledUntilSequence_ = this->firstSequence_ + int64_t(position);
+}
+
+void MessageIndex::add(const MessagePtr &message, int64_t sequence)
+{
+    // Older messages never shadow newer ones. This matters for duplicates,
+    // e.g. recent messages overlapping with messages received live.
+    auto insert = [&](EntryMap &map, const QString &key) {
+        auto it = map.find(key);
+        if (it == map.end())
+        {
+            map.emplace(key, Entry{sequence, message.get()});
+        }
+        else if (it->second.sequence <= sequence)
+        {
+            it->second = Entry{sequence, message.get()};
+        }
+    };
+
+    if (!message->id.isEmpty())
+    {
+        insert(this->byId_, message->id);
+    }
+
+    if (isTimeoutMessage(*message))
+    {
+        insert(this->lastTimeoutByUser_, message->timeoutUser);
+    }
+
+    for (auto &key : userKeys(*message))
+    {
+        auto &sequences = this->byUser_[key];
+
+        // messages are usually appended, so check the back first
+        if (sequences.empty() || sequences.back() < sequence)
+        {
+            sequences.push_back(sequence);
+        }
+        else
+        {
+            sequences.insert(std::upper_bound(sequences.begin(),
+                                              sequences.end(), sequence),
+                             sequence);
+        }
+    }
+}
+
+void MessageIndex::remove(const MessagePtr &message, int64_t sequence)
+{
+    auto erase = [&](EntryMap &map, const QString &key) {
+        auto it = map.find(key);
+        if (it != map.end() && it->second.sequence == sequence)
+        {
+            map.erase(it);
+        }
+    };
+
+    if (!message->id.isEmpty())
+    {
+        erase(this->byId_, message->id);
+    }
+
+    if (isTimeoutMessage(*message))
+    {
+        erase(this->lastTimeoutByUser_, message->timeoutUser);
+    }
+
+    for (auto &key : userKeys(*message))
+    {
+        auto it = this->byUser_.find(key);
+        if (it == this->byUser_.end())
+        {
+            continue;
+        }
+
+        auto &sequences = it->second;
+
+        // evicted messages are always at the front
+        if (sequences.front() == sequence)
+        {
+            sequences.pop_front();
+        }
+        else
+        {
+            auto pos = std::lower_bound(sequences.begin(), sequences.end(),
+                                        sequence);
+            if (pos != sequences.end() && *pos == sequence)
+            {
+                sequences.erase(pos);
+            }
+        }
+
+        if (sequences.empty())
+        {
+            this->byUser_.erase(it);
+        }
+    }
+}
+
+boost::optional<size_t> MessageIndex::position(const EntryMap &map,
+                                               const QString &key) const
+{
+    auto it = map.find(key);
+    if (it == map.end())
+    {
+        return boost::none;
+    }
+
+    return size_t(it->second.sequence - this->firstSequence_);
+}
+
+}  // namespace chatterino
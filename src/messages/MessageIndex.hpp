@@ -0,0 +1,94 @@
+#pragma once
+
+#include "util/QStringHash.hpp"
+
+#include <QString>
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace chatterino {
+
+struct Message;
+using MessagePtr = std::shared_ptr<const Message>;
+
+/// MessageIndex maps message ids, timed out users and users to positions in
+/// a channel's LimitedQueue.
+///
+/// Positions are stored as sequence numbers, so evicting messages from the
+/// start of the queue doesn't require touching the rest of the index. The
+/// index must be updated together with the queue it mirrors and is not
+/// thread safe on its own.
+class MessageIndex
+{
+public:
+    void clear();
+
+    /// Call after a message was pushed to the back of the queue
+    void append(const MessagePtr &message);
+
+    /// Call with the messages that were accepted by LimitedQueue::pushFront
+    void prepend(const std::vector<MessagePtr> &messages);
+
+    /// Call with the message that was evicted from the start of the queue
+    void removeFirst(const MessagePtr &message);
+
+    /// Call after the message at index was replaced
+    void replace(size_t index, const MessagePtr &previous,
+                 const MessagePtr &replacement);
+
+    /// Returns the position of the newest message with the given id
+    boost::optional<size_t> findById(const QString &id) const;
+
+    /// Returns the position of the newest timeout or untimeout message for
+    /// the given user
+    boost::optional<size_t> findLastTimeout(const QString &user) const;
+
+    /// Returns the position of the given message if it can be found through
+    /// its id or timeout user
+    boost::optional<size_t> find(const MessagePtr &message) const;
+
+    /// Returns the positions of all messages sent by, or targeting (e.g.
+    /// timeouts and subscriptions), the given user in ascending order.
+    /// The user name is matched case insensitively.
+    std::vector<size_t> findByUser(const QString &userName) const;
+
+    /// Returns the position up to which Channel::disableAllMessages has
+    /// already disabled all messages
+    size_t disabledUntil() const;
+
+    /// Marks all messages before position as handled by
+    /// Channel::disableAllMessages
+    void setDisabledUntil(size_t position);
+
+private:
+    struct Entry {
+        int64_t sequence;
+        const Message *message;
+    };
+    using EntryMap = std::unordered_map<QString, Entry>;
+
+    void add(const MessagePtr &message, int64_t sequence);
+    void remove(const MessagePtr &message, int64_t sequence);
+    boost::optional<size_t> position(const EntryMap &map,
+                                     const QString &key) const;
+
+    EntryMap byId_;
+    EntryMap lastTimeoutByUser_;
+    // lower case user name -> sorted sequence numbers
+    std::unordered_map<QString, std::deque<int64_t>> byUser_;
+
+    // sequence number of the message at position 0
+    int64_t firstSequence_ = 0;
+    // sequence number the next appended message will get
+    int64_t nextSequence_ = 0;
+    // messages before this sequence number were disabled by
+    // Channel::disableAllMessages
+    int64_t disabledUntilSequence_ = 0;
+};
+
+}  // namespace chatterino
@@ -0,0 +1,192 @@
+#include "messages/MessageSimilarity.hpp"
+
+#include "messages/Message.hpp"
+
+#include <algorithm>
+
+namespace chatterino {
+
+namespace {
+
+    // FNV-1a
+    uint32_t hashShingle(const QChar *begin)
+    {
+        uint32_t hash = 2166136261U;
+        for (int i = 0; i < MessageSimilarity::shingleLength; i++)
+        {
+            hash = (hash ^ begin[i].unicode()) * 16777619U;
+        }
+        return hash;
+    }
+
+}  // namespace
+
+MessageSimilarity::MessageSimilarity(QString text)
+    : text_(std::move(text))
+{
+    auto count = this->text_.size() - shingleLength + 1;
+    if (count <= 0)
+    {
+        return;
+    }
+
+    this->shingles_.reserve(size_t(count));
+    for (int i = 0; i < count; i++)
+    {
+        this->shingles_.push_back(hashShingle(this->text_.constData() + i));
+    }
+
+    std::sort(this->shingles_.begin(), this->shingles_.end());
+    this->shingles_.erase(
+        std::unique(this->shingles_.begin(), this->shingles_.end()),
+        this->shingles_.end());
+}
+
+const MessageSimilarity &MessageSimilarity::of(const Message &message)
+{
+    if (!message.similarity)
+    {
+        message.similarity =
+            std::make_unique<MessageSimilarity>(message.messageText);
+    }
+
+    return *message.similarity;
+}
+
+bool MessageSimilarity::isSimilarTo(const MessageSimilarity &other,
+                                    float threshold) const
+{
+    auto shorter = std::min(this->text_.size(), other.text_.size());
+    auto longer = std::max(this->text_.size(), other.text_.size());
+
+    if (longer == 0)
+    {
+        return 0.f > threshold;
+    }
+
+    // the shortest common substring which exceeds the threshold, computed
+    // like relativeSimilarity so rounding doesn't change the outcome
+    auto needed = std::max(0, int(threshold * float(longer)) - 1);
+    while (needed <= longer && float(needed) / float(longer) <= threshold)
+    {
+        needed++;
+    }
+
+    if (needed == 0)
+    {
+        return true;
+    }
+
+    // a common substring can't be longer than the shorter text
+    if (needed > shorter)
+    {
+        return false;
+    }
+
+    if (this->text_ == other.text_)
+    {
+        return true;
+    }
+
+    // a long enough common substring starts with a common shingle
+    if (needed >= shingleLength && !this->sharesShingle(other))
+    {
+        return false;
+    }
+
+    return longestCommonSubstring(this->text_, other.text_, needed) >= needed;
+}
+
+const QString &MessageSimilarity::text() const
+{
+    return this->text_;
+}
+
+float MessageSimilarity::relativeSimilarity(const QString &a,
+                                            const QString &b)
+{
+    auto length = longestCommonSubstring(a, b);
+
+    return length == 0
+               ? 0.f
+               : float(length) / float(std::max(1, std::max(a.size(), b.size())));
+}
+
+int MessageSimilarity::longestCommonSubstring(const QString &a,
+                                              const QString &b, int limit)
+{
+    // iterate over the longer text and keep a row for the shorter one
+    const auto &rows = a.size() >= b.size() ? a : b;
+    const auto &columns = a.size() >= b.size() ? b : a;
+    auto rowCount = rows.size();
+    auto columnCount = columns.size();
+
+    // reused, so comparing doesn't allocate
+    thread_local std::vector<int> row;
+    row.assign(size_t(columnCount) + 1, 0);
+
+    const auto *rowText = rows.constData();
+    const auto *columnText = columns.constData();
+    int best = 0;
+
+    for (int i = 0; i < rowCount; i++)
+    {
+        // row[j + 1] is the length of the common substring ending at
+        // rowText[i] and columnText[j]
+        int diagonal = 0;
+        int rowBest = 0;
+
+        for (int j = 0; j < columnCount; j++)
+        {
+            auto above = row[j + 1];
+            row[j + 1] = rowText[i] == columnText[j] ? diagonal + 1 : 0;
+            rowBest = std::max(rowBest, row[j + 1]);
+            diagonal = above;
+        }
+
+        best = std::max(best, rowBest);
+
+        if (limit > 0)
+        {
+            if (best >= limit)
+            {
+                return best;
+            }
+
+            // substrings can only grow by one character per remaining row
+            if (rowBest + (rowCount - 1 - i) < limit)
+            {
+                return best;
+            }
+        }
+    }
+
+    return best;
+}
+
+bool MessageSimilarity::sharesShingle(const MessageSimilarity &other) const
+{
+    auto a = this->shingles_.begin();
+    auto b = other.shingles_.begin();
+
+    while (a != this->shingles_.end() && b != other.shingles_.end())
+    {
+        if (*a == *b)
+        {
+            return true;
+        }
+
+        if (*a < *b)
+        {
+            a++;
+        }
+        else
+        {
+            b++;
+        }
+    }
+
+    return false;
+}
+
+}  // namespace chatterino
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QString>
+
+#include <cstdint>
+#include <vector>
+
+namespace chatterino {
+
+struct Message;
+
+/// MessageSimilarity is the preprocessed form of a message text which is
+/// used to find similar messages, see IrcMessageHandler::setSimilarityFlags.
+///
+/// Two texts are compared by the length of their longest common substring
+/// relative to the longer text. Most comparisons are decided without looking
+/// at the texts character by character: by their lengths, or by a sorted
+/// list of hashed shingles (substrings of shingleLength characters).
+class MessageSimilarity
+{
+public:
+    static constexpr int shingleLength = 3;
+
+    explicit MessageSimilarity(QString text);
+
+    /// Returns the preprocessed form of message, which is computed once and
+    /// kept with the message. Only used from the GUI thread.
+    static const MessageSimilarity &of(const Message &message);
+
+    /// Returns true if relativeSimilarity(text(), other.text()) > threshold
+    bool isSimilarTo(const MessageSimilarity &other, float threshold) const;
+
+    const QString &text() const;
+
+    /// Returns the length of the longest common substring of a and b
+    /// divided by the length of the longer one
+    static float relativeSimilarity(const QString &a, const QString &b);
+
+    /// Returns the length of the longest common substring of a and b.
+    ///
+    /// If limit is positive, the search stops once the result is known to be
+    /// at least limit or known to stay below it. Only the comparison of the
+    /// result with limit is meaningful then.
+    static int longestCommonSubstring(const QString &a, const QString &b,
+                                      int limit = 0);
+
+private:
+    bool sharesShingle(const MessageSimilarity &other) const;
+
+    QString text_;
+    // sorted and unique
+    std::vector<uint32_t> shingles_;
+};
+
+}  // namespace chatterino
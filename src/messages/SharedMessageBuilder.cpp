@@ -13,6 +13,7 @@
 
 #include <QFileInfo>
 #include <QMediaPlayer>
+#include <boost/optional.hpp>
 
 namespace chatterino {
 
@@ -170,13 +171,12 @@ void SharedMessageBuilder::parseHighlights()
     }
 
     // Highlight because of sender
-    auto userHighlights = getCSettings().highlightedUsers.readOnly();
-    for (const HighlightPhrase &userHighlight : *userHighlights)
+    auto userHighlights = getCSettings().highlightedUsersMatcher.get();
+    for (auto index : userHighlights->match(this->ircMessage->nick()))
     {
-        if (!userHighlight.isMatch(this->ircMessage->nick()))
-        {
-            continue;
-        }
+        const HighlightPhrase &userHighlight =
+            userHighlights->phrases()[index];
+
         qCDebug(chatterinoMessage)
             << "Highlight because user" << this->ircMessage->nick()
             << "sent a message";
@@ -262,58 +262,61 @@ void SharedMessageBuilder::parseHighlights()
             ColorProvider::instance().color(ColorType::Subscription);
     }
 
-    // TODO: This vector should only be rebuilt upon highlights being changed
-    // fourtf: should be implemented in the HighlightsController
-    std::vector<HighlightPhrase> activeHighlights =
-        getSettings()->highlightedMessages.cloneVector();
+    auto messageHighlights = getCSettings().highlightedMessagesMatcher.get();
+
+    std::vector<const HighlightPhrase *> activeHighlights;
+    for (auto index : messageHighlights->match(this->originalMessage_))
+    {
+        activeHighlights.push_back(&messageHighlights->phrases()[index]);
+    }
 
+    boost::optional<HighlightPhrase> selfHighlight;
     if (!currentUser->isAnon() && getSettings()->enableSelfHighlight &&
         currentUsername.size() > 0)
     {
-        HighlightPhrase selfHighlight(
+        selfHighlight.emplace(
             currentUsername, getSettings()->showSelfHighlightInMentions,
             getSettings()->enableSelfHighlightTaskbar,
             getSettings()->enableSelfHighlightSound, false, false,
             getSettings()->selfHighlightSoundUrl.getValue(),
             ColorProvider::instance().color(ColorType::SelfHighlight));
-        activeHighlights.emplace_back(std::move(selfHighlight));
-    }
 
-    // Highlight because of message
-    for (const HighlightPhrase &highlight : activeHighlights)
-    {
-        if (!highlight.isMatch(this->originalMessage_))
+        if (selfHighlight->isMatch(this->originalMessage_))
         {
-            continue;
+            activeHighlights.push_back(&*selfHighlight);
         }
+    }
 
+    // Highlight because of message
+    for (const HighlightPhrase *highlight : activeHighlights)
+    {
         this->message().flags.set(MessageFlag::Highlighted);
         if (!(this->message().flags.has(MessageFlag::Subscription) &&
               getSettings()->enableSubHighlight))
         {
-            this->message().highlightColor = highlight.getColor();
+            this->message().highlightColor = highlight->getColor();
         }
 
-        if (highlight.showInMentions())
+        if (highlight->showInMentions())
         {
             this->message().flags.set(MessageFlag::ShowInMentions);
         }
 
-        if (highlight.hasAlert())
+        if (highlight->hasAlert())
         {
             this->highlightAlert_ = true;
         }
 
         // Only set highlightSound_ if it hasn't been set by username
         // highlights already.
-        if (highlight.hasSound() && !this->highlightSound_)
+        if (highlight->hasSound() && !this->highlightSound_)
         {
             this->highlightSound_ = true;
 
             // Use custom sound if set, otherwise use fallback sound
-            if (highlight.hasCustomSound())
+            if (highlight->hasCustomSound())
             {
-                this->highlightSoundUrl_ = highlight.getSoundUrl();
+                this->highlightSoundUrl_ = highlight->getSoundUrl();
             }
             else
             {
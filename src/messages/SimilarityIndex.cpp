@@ -0,0 +1,154 @@
+#include "messages/SimilarityIndex.hpp"
+
+#include "messages/Message.hpp"
+
+#include <algorithm>
+
+namespace chatterino {
+
+namespace {
+
+    // Seconds since message was received, this keeps working across
+    // midnight
+    int ageOf(const Message &message, const QTime &now)
+    {
+        constexpr int secondsPerDay = 24 * 60 * 60;
+
+        return (message.parseTime.secsTo(now) + secondsPerDay) % secondsPerDay;
+    }
+
+}  // namespace
+
+void SimilarityIndex::append(const MessagePtr &message, const Window &window,
+                             const QTime &now)
+{
+    this->timeline_.push_back(message);
+
+    auto &messages = this->byUser_[message->loginName];
+    messages.push_back(message);
+    while (messages.size() > size_t(std::max(1, window.maxMessages)))
+    {
+        messages.pop_front();
+    }
+
+    this->expire(window, now);
+}
+
+void SimilarityIndex::prepend(const std::vector<MessagePtr> &messages,
+                              const Window &window, const QTime &now)
+{
+    // newest first, so a user's newer messages take their places in the
+    // window before older ones
+    for (auto it = messages.rbegin(); it != messages.rend(); ++it)
+    {
+        const auto &message = *it;
+        if (ageOf(*message, now) >= window.maxDelaySeconds)
+        {
+            continue;
+        }
+
+        this->timeline_.push_front(message);
+
+        auto &userMessages = this->byUser_[message->loginName];
+        if (userMessages.size() < size_t(std::max(1, window.maxMessages)))
+        {
+            userMessages.push_front(message);
+        }
+    }
+
+    this->expire(window, now);
+}
+
+void SimilarityIndex::replace(const MessagePtr &previous,
+                              const MessagePtr &replacement)
+{
+    // replaced messages are usually recent ones
+    auto it =
+        std::find(this->timeline_.rbegin(), this->timeline_.rend(), previous);
+    if (it == this->timeline_.rend())
+    {
+        return;
+    }
+    *it = replacement;
+
+    auto user = this->byUser_.find(previous->loginName);
+    if (user == this->byUser_.end())
+    {
+        return;
+    }
+
+    auto &messages = user->second;
+    auto message = std::find(messages.begin(), messages.end(), previous);
+    if (message == messages.end())
+    {
+        return;
+    }
+
+    if (replacement->loginName == previous->loginName)
+    {
+        *message = replacement;
+    }
+    else
+    {
+        messages.erase(message);
+        if (messages.empty())
+        {
+            this->byUser_.erase(user);
+        }
+    }
+}
+
+std::vector<MessagePtr> SimilarityIndex::find(
+    const boost::optional<QString> &loginName, const Window &window,
+    const QTime &now) const
+{
+    const Messages *messages = &this->timeline_;
+    if (loginName)
+    {
+        auto it = this->byUser_.find(*loginName);
+        if (it == this->byUser_.end())
+        {
+            return {};
+        }
+        messages = &it->second;
+    }
+
+    std::vector<MessagePtr> found;
+    for (auto it = messages->rbegin();
+         it != messages->rend() && int(found.size()) < window.maxMessages;
+         ++it)
+    {
+        if (ageOf(**it, now) >= window.maxDelaySeconds)
+        {
+            break;
+        }
+        found.push_back(*it);
+    }
+
+    return found;
+}
+
+void SimilarityIndex::expire(const Window &window, const QTime &now)
+{
+    while (!this->timeline_.empty() &&
+           ageOf(*this->timeline_.front(), now) >= window.maxDelaySeconds)
+    {
+        const auto &oldest = this->timeline_.front();
+
+        // the user's oldest message might already be gone because they sent
+        // more than maxMessages messages since
+        auto user = this->byUser_.find(oldest->loginName);
+        if (user != this->byUser_.end() && user->second.front() == oldest)
+        {
+            user->second.pop_front();
+            if (user->second.empty())
+            {
+                this->byUser_.erase(user);
+            }
+        }
+
+        this->timeline_.pop_front();
+    }
+}
+
+}  // namespace chatterino
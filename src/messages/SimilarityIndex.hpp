@@ -0,0 +1,69 @@
+#pragma once
+
+#include "util/QStringHash.hpp"
+
+#include <QString>
+#include <QTime>
+#include <boost/optional.hpp>
+
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace chatterino {
+
+struct Message;
+using MessagePtr = std::shared_ptr<const Message>;
+
+/// SimilarityIndex keeps the recent messages of a channel which a new
+/// message is compared with to find similar messages, see
+/// IrcMessageHandler::isSimilar.
+///
+/// Messages are kept in a sliding window per channel and per user. They are
+/// dropped once they are older than the maximum delay, or once a user sent
+/// more newer messages than are checked. Finding the messages to compare
+/// with takes at most maxMessages steps, even if only the messages of the
+/// same user are checked in a busy channel.
+///
+/// The index must be updated together with the channel it mirrors and is not
+/// thread safe on its own.
+class SimilarityIndex
+{
+public:
+    /// See the hideSimilarMaxMessagesToCheck and hideSimilarMaxDelay settings
+    struct Window {
+        int maxMessages = 3;
+        int maxDelaySeconds = 5;
+    };
+
+    /// Call after a message was added to the end of the channel
+    void append(const MessagePtr &message, const Window &window,
+                const QTime &now);
+
+    /// Call after messages were added to the start of the channel, e.g. the
+    /// recent messages. They are older than the messages in the index.
+    void prepend(const std::vector<MessagePtr> &messages, const Window &window,
+                 const QTime &now);
+
+    /// Call after a message was replaced
+    void replace(const MessagePtr &previous, const MessagePtr &replacement);
+
+    /// Returns the messages a new message is compared with, newest first. If
+    /// loginName is set, only messages of that user are returned.
+    std::vector<MessagePtr> find(const boost::optional<QString> &loginName,
+                                 const Window &window, const QTime &now) const;
+
+private:
+    // oldest first
+    using Messages = std::deque<MessagePtr>;
+
+    void expire(const Window &window, const QTime &now);
+
+    // all messages within the maximum delay
+    Messages timeline_;
+    // the last maxMessages messages of each user within the maximum delay
+    std::unordered_map<QString, Messages> byUser_;
+};
+
+}  // namespace chatterino
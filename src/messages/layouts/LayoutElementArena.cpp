@@ -0,0 +1,147 @@
+#include "messages/layouts/LayoutElementArena.hpp"
+
+#include "messages/layouts/MessageLayoutElement.hpp"
+
+#include <algorithm>
+
+namespace chatterino {
+
+namespace {
+
+    // enough for a short message, a long one takes a few more blocks
+    constexpr size_t minBlockBytes = 1024;
+
+}  // namespace
+
+LayoutElementArena::~LayoutElementArena()
+{
+    this->clear();
+}
+
+void LayoutElementArena::destroy(MessageLayoutElement *element)
+{
+    if (element == nullptr)
+    {
+        return;
+    }
+
+    element->~MessageLayoutElement();
+
+    if (this->last_ != nullptr && this->last_->element == element)
+    {
+        // the last allocation always lives in the last block
+        this->blocks_.back().used -= this->last_->units;
+        this->last_ = nullptr;
+        return;
+    }
+
+    for (auto &block : this->blocks_)
+    {
+        for (size_t i = 0; i < block.used; i += block.data[i].units)
+        {
+            if (block.data[i].element == element)
+            {
+                block.data[i].element = nullptr;
+                return;
+            }
+        }
+    }
+}
+
+void LayoutElementArena::clear()
+{
+    for (auto &block : this->blocks_)
+    {
+        for (size_t i = 0; i < block.used; i += block.data[i].units)
+        {
+            if (auto *element = block.data[i].element)
+            {
+                element->~MessageLayoutElement();
+            }
+        }
+        block.used = 0;
+    }
+
+    // blocks grow, so the last one is the largest
+    if (this->blocks_.size() > 1)
+    {
+        std::swap(this->blocks_.front(), this->blocks_.back());
+        this->blocks_.resize(1);
+    }
+
+    this->last_ = nullptr;
+}
+
+void LayoutElementArena::reserve(size_t bytes)
+{
+    auto units = unitsFor(bytes);
+
+    if (this->blocks_.empty() ||
+        this->blocks_.back().units - this->blocks_.back().used < units)
+    {
+        this->addBlock(units);
+    }
+}
+
+size_t LayoutElementArena::usedBytes() const
+{
+    size_t units = 0;
+    for (const auto &block : this->blocks_)
+    {
+        units += block.used;
+    }
+
+    return units * sizeof(Header);
+}
+
+size_t LayoutElementArena::capacity() const
+{
+    size_t units = 0;
+    for (const auto &block : this->blocks_)
+    {
+        units += block.units;
+    }
+
+    return units * sizeof(Header);
+}
+
+LayoutElementArena::Header *LayoutElementArena::allocate(size_t size)
+{
+    auto units = 1 + unitsFor(size);
+
+    if (this->blocks_.empty() ||
+        this->blocks_.back().units - this->blocks_.back().used < units)
+    {
+        this->addBlock(units);
+    }
+
+    auto &block = this->blocks_.back();
+    auto *header = &block.data[block.used];
+    block.used += units;
+
+    header->element = nullptr;
+    header->units = units;
+    this->last_ = header;
+
+    return header;
+}
+
+void LayoutElementArena::addBlock(size_t minUnits)
+{
+    auto units = std::max(minUnits, unitsFor(minBlockBytes));
+    if (!this->blocks_.empty())
+    {
+        units = std::max(units, this->blocks_.back().units * 2);
+    }
+
+    // Header is trivial, so the units are left uninitialized
+    this->blocks_.push_back(
+        Block{std::unique_ptr<Header[]>(new Header[units]), units, 0});
+}
+
+size_t LayoutElementArena::unitsFor(size_t bytes)
+{
+    return (bytes + sizeof(Header) - 1) / sizeof(Header);
+}
+
+}  // namespace chatterino
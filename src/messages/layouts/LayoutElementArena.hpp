@@ -0,0 +1,82 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace chatterino {
+
+class MessageLayoutElement;
+
+/// Storage for the layout elements of one MessageLayoutContainer.
+///
+/// Elements are placed next to each other in a few large blocks instead of
+/// being allocated one by one. Blocks grow geometrically, so laying out a
+/// message takes a handful of allocations at most, and only one if the
+/// expected size was reserved up front. All elements are destroyed together
+/// by clear() or when the arena is destroyed.
+class LayoutElementArena : boost::noncopyable
+{
+public:
+    LayoutElementArena() = default;
+    ~LayoutElementArena();
+
+    template <typename T, typename... Args>
+    T *create(Args &&... args)
+    {
+        static_assert(std::is_base_of<MessageLayoutElement, T>::value,
+                      "the arena only holds layout elements");
+        static_assert(alignof(T) <= alignof(Header),
+                      "layout elements can't be over-aligned");
+
+        auto *header = this->allocate(sizeof(T));
+        auto *element = new (header + 1) T(std::forward<Args>(args)...);
+        header->element = element;
+
+        return element;
+    }
+
+    /// Destroys element before the rest of the arena. Its memory is only
+    /// reused if it was the last element created.
+    void destroy(MessageLayoutElement *element);
+
+    /// Destroys all elements. The largest block is kept for reuse.
+    void clear();
+
+    /// Makes sure bytes worth of elements can be created without another
+    /// allocation
+    void reserve(size_t bytes);
+
+    /// Bytes taken up by the elements created since the last clear
+    size_t usedBytes() const;
+    /// Bytes allocated for blocks
+    size_t capacity() const;
+
+private:
+    struct alignas(std::max_align_t) Header {
+        // nullptr once the element was destroyed
+        MessageLayoutElement *element;
+        // number of Header sized units taken up, including this header
+        size_t units;
+    };
+
+    struct Block {
+        std::unique_ptr<Header[]> data;
+        size_t units;
+        size_t used;
+    };
+
+    Header *allocate(size_t size);
+    void addBlock(size_t minUnits);
+    static size_t unitsFor(size_t bytes);
+
+    std::vector<Block> blocks_;
+    Header *last_ = nullptr;
+};
+
+}  // namespace chatterino
@@ -0,0 +1,243 @@
+#include "messages/layouts/MessageBufferPool.hpp"
+
+#include "debug/AssertInGuiThread.hpp"
+#include "singletons/Settings.hpp"
+#include "util/DebugCount.hpp"
+
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace chatterino {
+
+namespace {
+
+    // buffers painted this recently are never evicted, even if that means
+    // going over the budget. Otherwise a budget that is smaller than what's
+    // on screen would redraw every message on every paint.
+    constexpr auto minimumBufferAge = std::chrono::seconds(1);
+
+    // Released buffers are only reused for messages of the exact same size,
+    // so only a few are kept and not for long
+    constexpr int64_t maxReleasedBytes = 8 * 1024 * 1024;
+    constexpr auto maxReleasedAge = std::chrono::seconds(5);
+
+    uint64_t sizeKey(QSize size)
+    {
+        return (uint64_t(uint32_t(size.width())) << 32) |
+               uint32_t(size.height());
+    }
+
+    int64_t budget()
+    {
+        auto megabytes = getSettings()->messageBufferBudget.getValue();
+
+        return int64_t(std::max(0, megabytes)) * 1024 * 1024;
+    }
+
+}  // namespace
+
+MessageBufferPool &MessageBufferPool::instance()
+{
+    static MessageBufferPool instance;
+
+    return instance;
+}
+
+MessageBufferPool::MessageBufferPool()
+{
+    this->releasedTimer_.setSingleShot(true);
+    QObject::connect(&this->releasedTimer_, &QTimer::timeout, [this] {
+        this->evictReleased();
+    });
+}
+
+std::shared_ptr<QPixmap> MessageBufferPool::acquire(QSize size,
+                                                    qreal devicePixelRatio)
+{
+    assertInGuiThread();
+
+    if (size.isEmpty())
+    {
+        // nothing to draw into, don't bother tracking it
+        return std::make_shared<QPixmap>();
+    }
+
+    auto released = this->released_.find(sizeKey(size));
+    if (released != this->released_.end())
+    {
+        auto it = released->second.back();
+        released->second.pop_back();
+        if (released->second.empty())
+        {
+            this->released_.erase(released);
+        }
+
+        it->inUse = true;
+        it->lastUsed = Clock::now();
+        this->releasedBytes_ -= it->bytes;
+        it->buffer->setDevicePixelRatio(devicePixelRatio);
+        this->entries_.splice(this->entries_.begin(), this->entries_, it);
+
+        DebugCount::increase("message drawing buffer hits");
+
+        return it->buffer;
+    }
+
+    auto buffer = std::make_shared<QPixmap>(size);
+    buffer->setDevicePixelRatio(devicePixelRatio);
+
+    auto bytes = int64_t(size.width()) * size.height() * 4;
+    this->bytes_ += bytes;
+    this->entries_.push_front({buffer, bytes, true, Clock::now()});
+    this->byBuffer_[buffer.get()] = this->entries_.begin();
+
+    DebugCount::increase("message drawing buffers");
+    DebugCount::increase("message drawing buffer misses");
+    DebugCount::increase("message drawing buffer KiB", bytes / 1024);
+
+    this->evict();
+
+    return buffer;
+}
+
+void MessageBufferPool::release(std::shared_ptr<QPixmap> buffer)
+{
+    assertInGuiThread();
+
+    if (!buffer)
+    {
+        return;
+    }
+
+    auto found = this->byBuffer_.find(buffer.get());
+    if (found == this->byBuffer_.end())
+    {
+        // empty or already evicted
+        return;
+    }
+
+    auto it = found->second;
+    it->inUse = false;
+    it->released = Clock::now();
+    this->released_[sizeKey(it->buffer->size())].push_back(it);
+    this->releasedBytes_ += it->bytes;
+
+    this->evict();
+}
+
+void MessageBufferPool::touch(const std::shared_ptr<QPixmap> &buffer)
+{
+    auto found = this->byBuffer_.find(buffer.get());
+    if (found == this->byBuffer_.end())
+    {
+        return;
+    }
+
+    auto it = found->second;
+    it->lastUsed = Clock::now();
+    this->entries_.splice(this->entries_.begin(), this->entries_, it);
+}
+
+void MessageBufferPool::evict()
+{
+    this->evictReleased();
+
+    auto limit = budget();
+    auto now = Clock::now();
+
+    // released buffers go first, then the ones in use that haven't been
+    // painted for a while
+    for (auto inUse : {false, true})
+    {
+        auto it = this->entries_.end();
+
+        while (this->bytes_ > limit && it != this->entries_.begin())
+        {
+            auto current = std::prev(it);
+
+            if (current->inUse != inUse)
+            {
+                it = current;
+                continue;
+            }
+
+            // entries are ordered by when they were last painted
+            if (inUse && now - current->lastUsed < minimumBufferAge)
+            {
+                break;
+            }
+
+            this->erase(current);
+        }
+    }
+}
+
+void MessageBufferPool::evictReleased()
+{
+    auto now = Clock::now();
+
+    // there are only a few released buffers
+    while (!this->released_.empty())
+    {
+        boost::optional<EntryList::iterator> oldest;
+        for (const auto &sized : this->released_)
+        {
+            for (auto it : sized.second)
+            {
+                if (!oldest || it->released < (*oldest)->released)
+                {
+                    oldest = it;
+                }
+            }
+        }
+
+        if (this->releasedBytes_ <= maxReleasedBytes &&
+            now - (*oldest)->released < maxReleasedAge)
+        {
+            // check again once the oldest one is too old
+            this->releasedTimer_.start(
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    maxReleasedAge - (now - (*oldest)->released)));
+            return;
+        }
+
+        this->erase(*oldest);
+    }
+
+    this->releasedTimer_.stop();
+}
+
+void MessageBufferPool::erase(EntryList::iterator it)
+{
+    if (!it->inUse)
+    {
+        this->releasedBytes_ -= it->bytes;
+
+        auto released = this->released_.find(sizeKey(it->buffer->size()));
+        assert(released != this->released_.end());
+
+        auto &list = released->second;
+        list.erase(std::find(list.begin(), list.end(), it));
+        if (list.empty())
+        {
+            this->released_.erase(released);
+        }
+    }
+
+    this->bytes_ -= it->bytes;
+    this->byBuffer_.erase(it->buffer.get());
+
+    DebugCount::decrease("message drawing buffers");
+    DebugCount::decrease("message drawing buffer KiB", it->bytes / 1024);
+    DebugCount::increase("message drawing buffer evictions");
+
+    // frees the memory even if the buffer is still in use, the owner
+    // acquires a new one once it notices
+    *it->buffer = QPixmap();
+
+    this->entries_.erase(it);
+}
+
+}  // namespace chatterino
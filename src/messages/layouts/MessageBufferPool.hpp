@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QPixmap>
+#include <QSize>
+#include <QTimer>
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace chatterino {
+
+/// MessageBufferPool hands out the pixmaps messages are drawn into.
+///
+/// All buffers count towards the byte budget set by the
+/// messageBufferBudget setting. Released buffers are kept around for a few
+/// seconds to be reused for messages of the same size, e.g. while scrolling
+/// back and forth. Only a few megabytes of them are kept, they are freed
+/// first. Once the budget is exceeded the least recently painted buffers
+/// get evicted. Buffers that are still in use are evicted by resetting them
+/// to a null pixmap, their owner has to acquire a new buffer before
+/// painting again.
+///
+/// Hits, misses and evictions are tracked in DebugCount. Gui thread only.
+class MessageBufferPool
+{
+public:
+    static MessageBufferPool &instance();
+
+    /// Returns a buffer of the given size in device pixels
+    std::shared_ptr<QPixmap> acquire(QSize size, qreal devicePixelRatio);
+
+    /// Gives a buffer back to the pool
+    void release(std::shared_ptr<QPixmap> buffer);
+
+    /// Marks the buffer as recently painted
+    void touch(const std::shared_ptr<QPixmap> &buffer);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::shared_ptr<QPixmap> buffer;
+        int64_t bytes;
+        bool inUse;
+        Clock::time_point lastUsed;
+        // when the buffer was released, if it isn't in use
+        Clock::time_point released;
+    };
+    using EntryList = std::list<Entry>;
+
+    MessageBufferPool();
+
+    void evict();
+    void evictReleased();
+    void erase(EntryList::iterator it);
+
+    // most recently used first
+    EntryList entries_;
+    std::unordered_map<const QPixmap *, EntryList::iterator> byBuffer_;
+    // released buffers by their size
+    std::unordered_map<uint64_t, std::vector<EntryList::iterator>> released_;
+    int64_t bytes_ = 0;
+    int64_t releasedBytes_ = 0;
+    // frees the released buffers once they are too old, also while nothing
+    // is painted
+    QTimer releasedTimer_;
+};
+
+}  // namespace chatterino
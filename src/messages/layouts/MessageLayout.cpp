@@ -1,9 +1,12 @@
 #include "messages/layouts/MessageLayout.hpp"
 
 #include "Application.hpp"
+#include "debug/AssertInGuiThread.hpp"
 #include "debug/Benchmark.hpp"
 #include "messages/Message.hpp"
 #include "messages/MessageElement.hpp"
+#include "messages/layouts/MessageBufferPool.hpp"
+#include "messages/layouts/MessageLayoutCache.hpp"
 #include "messages/layouts/MessageLayoutContainer.hpp"
 #include "singletons/Emotes.hpp"
 #include "singletons/Settings.hpp"
@@ -40,13 +43,18 @@ namespace {
 
 MessageLayout::MessageLayout(MessagePtr message)
     : message_(std::move(message))
-    , container_(std::make_shared<MessageLayoutContainer>())
+    , shared_(std::make_shared<SharedMessageLayout>())
 {
+    this->shared_->container = std::make_shared<MessageLayoutContainer>();
+    this->container_ = this->shared_->container;
+
     DebugCount::increase("message layout");
 }
 
 MessageLayout::~MessageLayout()
 {
+    this->deleteBuffer();
+
     DebugCount::decrease("message layout");
 }
 
@@ -63,17 +71,47 @@ int MessageLayout::getHeight() const
 
 // Layout
 // return true if redraw is required
-bool MessageLayout::layout(int width, float scale, MessageElementFlags flags)
+bool MessageLayout::layout(int width, float scale, qreal devicePixelRatio,
+                           MessageElementFlags flags)
 {
     //    BenchmarkGuard benchmark("MessageLayout::layout()");
 
+    if (!this->prepareLayout(width, scale, devicePixelRatio, flags))
+    {
+        return false;
+    }
+
+    auto request = this->makeRequest();
+    if (!this->applyCachedLayout(request))
+    {
+        this->applyLayout(request, MessageLayout::buildLayout(request));
+    }
+
+    return true;
+}
+
+boost::optional<MessageLayoutRequest> MessageLayout::requestLayout(
+    int width, float scale, qreal devicePixelRatio, MessageElementFlags flags)
+{
+    if (!this->prepareLayout(width, scale, devicePixelRatio, flags))
+    {
+        return boost::none;
+    }
+
+    return this->makeRequest();
+}
+
+// returns true if the layout needs to be rebuilt
+bool MessageLayout::prepareLayout(int width, float scale,
+                                  qreal devicePixelRatio,
+                                  MessageElementFlags flags)
+{
     auto app = getApp();
 
     bool layoutRequired = false;
 
     // check if width changed
-    bool widthChanged = width != this->currentLayoutWidth_;
-    layoutRequired |= widthChanged;
+    layoutRequired |= width != this->currentLayoutWidth_;
     this->currentLayoutWidth_ = width;
 
     // check if layout state changed
@@ -88,6 +126,10 @@ bool MessageLayout::layout(int width, float scale, MessageElementFlags flags)
     layoutRequired |= this->currentWordFlags_ != flags;
     this->currentWordFlags_ = flags;  // getSettings()->getWordTypeMask();
 
+    // check if an image changed the size of the layout, see
+    // MessageLayoutCache::imageLoaded
+    layoutRequired |= this->shared_->stale;
+
     // check if layout was requested manually
     layoutRequired |= this->flags.has(MessageLayoutFlag::RequiresLayout);
     this->flags.unset(MessageLayoutFlag::RequiresLayout);
@@ -96,66 +138,182 @@ bool MessageLayout::layout(int width, float scale, MessageElementFlags flags)
     layoutRequired |= this->scale_ != scale;
     this->scale_ = scale;
 
-    if (!layoutRequired)
-    {
-        return false;
-    }
+#if !defined(Q_OS_MACOS) && !defined(Q_OS_LINUX)
+    // buffers are always drawn at a ratio of 1 here, see paint
+    devicePixelRatio = 1;
+#endif
+
+    // check if the view moved to a screen with another device pixel ratio,
+    // the layout is the same but it needs another buffer
+    layoutRequired |= this->devicePixelRatio_ != devicePixelRatio;
+    this->devicePixelRatio_ = devicePixelRatio;
 
-    int oldHeight = this->container_->getHeight();
-    this->actuallyLayout(width, flags);
-    if (widthChanged || this->container_->getHeight() != oldHeight)
+    if (layoutRequired)
     {
-        this->deleteBuffer();
+        // outdates layouts that are still being built
+        this->layoutSerial_++;
     }
-    this->invalidateBuffer();
 
-    return true;
+    return layoutRequired;
 }
 
-void MessageLayout::actuallyLayout(int width, MessageElementFlags flags)
+MessageLayoutRequest MessageLayout::makeRequest() const
 {
-    this->layoutCount_++;
     auto messageFlags = this->message_->flags;
 
     if (this->flags.has(MessageLayoutFlag::Expanded) ||
-        (flags.has(MessageElementFlag::ModeratorTools) &&
-         !this->message_->flags.has(MessageFlag::Disabled)))
+        (this->currentWordFlags_.has(MessageElementFlag::ModeratorTools) &&
+         !messageFlags.has(MessageFlag::Disabled)))
     {
         messageFlags.unset(MessageFlag::Collapsed);
     }
 
-    this->container_->begin(width, this->scale_, messageFlags);
+    MessageLayoutRequest request;
+    request.message = this->message_;
+    request.width = this->currentLayoutWidth_;
+    request.scale = this->scale_;
+    request.devicePixelRatio = this->devicePixelRatio_;
+    request.flags = this->currentWordFlags_;
+    request.messageFlags = messageFlags;
+    if (this->currentWordFlags_.has(MessageElementFlag::ModeratorTools))
+    {
+        request.moderationActions =
+            getCSettings().moderationActions.readOnly();
+        for (const auto &action : *request.moderationActions)
+        {
+            action.loadImage();
+        }
+    }
+    request.elementCountHint = this->container_->getElementCount();
+    request.elementBytesHint = this->container_->getElementBytes();
+    request.serial = this->layoutSerial_;
+
+    return request;
+}
+
+std::shared_ptr<MessageLayoutContainer> MessageLayout::buildLayout(
+    const MessageLayoutRequest &request)
+{
+    auto container = std::make_shared<MessageLayoutContainer>();
+    auto messageFlags = request.messageFlags;
 
-    for (const auto &element : this->message_->elements)
+    container->begin(request.width, request.scale, messageFlags);
+    container->reserve(request.elementCountHint, request.elementBytesHint);
+    container->setModerationActions(request.moderationActions);
+
+    for (const auto &element : request.message->elements)
     {
         if (getSettings()->hideModerated &&
-            this->message_->flags.has(MessageFlag::Disabled))
+            messageFlags.has(MessageFlag::Disabled))
         {
             continue;
         }
 
         if (getSettings()->hideModerationActions &&
-            (this->message_->flags.has(MessageFlag::Timeout) ||
-             this->message_->flags.has(MessageFlag::Untimeout)))
+            (messageFlags.has(MessageFlag::Timeout) ||
+             messageFlags.has(MessageFlag::Untimeout)))
         {
             continue;
         }
 
         if (getSettings()->hideSimilar &&
-            this->message_->flags.has(MessageFlag::Similar))
+            messageFlags.has(MessageFlag::Similar))
         {
             continue;
         }
 
-        element->addToContainer(*this->container_, flags);
+        element->addToContainer(*container, request.flags);
+    }
+
+    container->end();
+
+    return container;
+}
+
+bool MessageLayout::applyLayout(
+    const MessageLayoutRequest &request,
+    std::shared_ptr<MessageLayoutContainer> container)
+{
+    assertInGuiThread();
+
+    if (request.serial != this->layoutSerial_)
+    {
+        return false;
+    }
+
+    this->setShared(MessageLayoutCache::instance().insert(
+        this->cacheKey(request), request.message, std::move(container)));
+
+    return true;
+}
+
+bool MessageLayout::applyCachedLayout(const MessageLayoutRequest &request)
+{
+    if (request.serial != this->layoutSerial_)
+    {
+        return false;
     }
 
-    if (this->height_ != this->container_->getHeight())
+    auto shared = MessageLayoutCache::instance().find(this->cacheKey(request));
+    if (!shared)
     {
-        this->deleteBuffer();
+        return false;
+    }
+
+    this->setShared(std::move(shared));
+
+    return true;
+}
+
+MessageLayoutKey MessageLayout::cacheKey(
+    const MessageLayoutRequest &request) const
+{
+    MessageLayoutKey key;
+    key.message = request.message.get();
+    key.width = request.width;
+    key.scale = request.scale;
+    key.devicePixelRatio = request.devicePixelRatio;
+    key.flags = request.flags;
+    key.messageFlags = request.messageFlags;
+    key.layoutFlags.set(
+        MessageLayoutFlag::AlternateBackground,
+        this->flags.has(MessageLayoutFlag::AlternateBackground));
+    key.layoutFlags.set(MessageLayoutFlag::IgnoreHighlights,
+                        this->flags.has(MessageLayoutFlag::IgnoreHighlights));
+    key.generation = this->layoutState_;
+
+    return key;
+}
+
+void MessageLayout::setShared(std::shared_ptr<SharedMessageLayout> shared)
+{
+    this->layoutCount_++;
+
+    if (shared != this->shared_)
+    {
+        auto &previous = *this->shared_;
+
+        // keep using our buffer if nobody else paints from it and it has the
+        // right size
+        if (this->holdsBuffer_ && previous.bufferUsers == 1 &&
+            !shared->buffer &&
+            previous.container->getWidth() == shared->container->getWidth() &&
+            previous.container->getHeight() == shared->container->getHeight())
+        {
+            shared->buffer = std::move(previous.buffer);
+            shared->bufferValid = false;
+            shared->bufferUsers++;
+            previous.bufferUsers--;
+        }
+        else
+        {
+            this->deleteBuffer();
+        }
+
+        this->shared_ = std::move(shared);
+        this->container_ = this->shared_->container;
     }
 
-    this->container_->end();
     this->height_ = this->container_->getHeight();
 
     // collapsed state
@@ -166,33 +324,59 @@ void MessageLayout::actuallyLayout(int width, MessageElementFlags flags)
     }
 }
 
+bool MessageLayout::hasLayout() const
+{
+    return this->layoutCount_ != 0;
+}
+
 // Painting
 void MessageLayout::paint(QPainter &painter, int width, int y, int messageIndex,
                           Selection &selection, bool isLastReadMessage,
                           bool isWindowFocused, bool isMentions)
 {
     auto app = getApp();
-    QPixmap *pixmap = this->buffer_.get();
+    auto &shared = *this->shared_;
+    QPixmap *pixmap = shared.buffer.get();
 
-    // create new buffer if required
-    if (!pixmap)
+    if (!this->holdsBuffer_)
     {
+        this->holdsBuffer_ = true;
+        shared.bufferUsers++;
+    }
+
+    auto &pool = MessageBufferPool::instance();
+
 #if defined(Q_OS_MACOS) || defined(Q_OS_LINUX)
-        pixmap = new QPixmap(int(width * painter.device()->devicePixelRatioF()),
-                             int(container_->getHeight() *
-                                 painter.device()->devicePixelRatioF()));
-        pixmap->setDevicePixelRatio(painter.device()->devicePixelRatioF());
+    auto ratio = painter.device()->devicePixelRatioF();
+    QSize bufferSize(int(width * ratio),
+                     int(this->container_->getHeight() * ratio));
 #else
-        pixmap =
-            new QPixmap(width, std::max(16, this->container_->getHeight()));
+    qreal ratio = 1;
+    QSize bufferSize(width, std::max(16, this->container_->getHeight()));
 #endif
 
-        this->buffer_ = std::shared_ptr<QPixmap>(pixmap);
-        this->bufferValid_ = false;
-        DebugCount::increase("message drawing buffers");
+    // The views sharing the layout can differ in the width they paint,
+    // e.g. if only one of them shows a scrollbar, or the screen changed
+    // before the message was laid out again
+    if (pixmap && !pixmap->isNull() &&
+        (pixmap->size() != bufferSize || pixmap->devicePixelRatioF() != ratio))
+    {
+        pool.release(std::move(shared.buffer));
+        pixmap = nullptr;
     }
 
-    if (!this->bufferValid_ || !selection.isEmpty())
+    // create new buffer if required, the pool also resets buffers it evicted
+    if (!pixmap || pixmap->isNull())
+    {
+        shared.buffer = pool.acquire(bufferSize, ratio);
+
+        pixmap = shared.buffer.get();
+        shared.bufferValid = false;
+    }
+
+    pool.touch(shared.buffer);
+
+    if (!shared.bufferValid || !selection.isEmpty())
     {
         this->updateBuffer(pixmap, messageIndex, selection);
     }
@@ -204,6 +388,7 @@ void MessageLayout::paint(QPainter &painter, int width, int y, int messageIndex,
 
     // draw gif emotes
     this->container_->paintAnimatedElements(painter, y);
+    this->container_->markImagesUsed();
 
     // draw disabled
     if (this->message_->flags.has(MessageFlag::Disabled))
@@ -266,7 +451,7 @@ void MessageLayout::paint(QPainter &painter, int width, int y, int messageIndex,
                          pixmap->width(), 1, brush);
     }
 
-    this->bufferValid_ = true;
+    shared.bufferValid = true;
 }
 
 void MessageLayout::updateBuffer(QPixmap *buffer, int /*messageIndex*/,
@@ -340,6 +525,7 @@ void MessageLayout::updateBuffer(QPixmap *buffer, int /*messageIndex*/,
 
     // draw message
     this->container_->paintElements(painter);
+    MessageLayoutCache::instance().bufferPainted(this->shared_);
 
 #ifdef FOURTF
     // debug
@@ -357,18 +543,32 @@ void MessageLayout::updateBuffer(QPixmap *buffer, int /*messageIndex*/,
 #endif
 }
 
+void MessageLayout::addAnimatedImages(
+    std::vector<std::pair<ImagePtr, QRect>> &out, int y) const
+{
+    this->container_->addAnimatedImages(out, y);
+}
+
 void MessageLayout::invalidateBuffer()
 {
-    this->bufferValid_ = false;
+    this->shared_->bufferValid = false;
 }
 
+// the buffer is only deleted once no view paints from it anymore
 void MessageLayout::deleteBuffer()
 {
-    if (this->buffer_ != nullptr)
+    if (!this->holdsBuffer_)
     {
-        DebugCount::decrease("message drawing buffers");
+        return;
+    }
 
-        this->buffer_ = nullptr;
+    this->holdsBuffer_ = false;
+
+    auto &shared = *this->shared_;
+    if (--shared.bufferUsers == 0)
+    {
+        MessageBufferPool::instance().release(std::move(shared.buffer));
+        shared.buffer = nullptr;
     }
 }
 
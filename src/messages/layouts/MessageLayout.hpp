@@ -5,20 +5,30 @@
 
 #include <QPixmap>
 #include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
 #include <cinttypes>
 #include <memory>
+#include <vector>
 
 namespace chatterino {
 
 struct Message;
 using MessagePtr = std::shared_ptr<const Message>;
 
+class Image;
+using ImagePtr = std::shared_ptr<Image>;
+
 struct Selection;
 struct MessageLayoutContainer;
 class MessageLayoutElement;
+struct MessageLayoutKey;
+struct SharedMessageLayout;
+class ModerationAction;
 
 enum class MessageElementFlag : int64_t;
 using MessageElementFlags = FlagsEnum<MessageElementFlag>;
+enum class MessageFlag : uint32_t;
+using MessageFlags = FlagsEnum<MessageFlag>;
 
 enum class MessageLayoutFlag : uint8_t {
     RequiresBufferUpdate = 1 << 1,
@@ -30,6 +40,27 @@ enum class MessageLayoutFlag : uint8_t {
 };
 using MessageLayoutFlags = FlagsEnum<MessageLayoutFlag>;
 
+/// Everything needed to build a MessageLayoutContainer for a message.
+/// Requests are created on the gui thread by MessageLayout::requestLayout and
+/// can be built on any thread.
+struct MessageLayoutRequest {
+    MessagePtr message;
+    int width;
+    float scale;
+    // of the screen the buffer is drawn for, only part of the cache key
+    qreal devicePixelRatio;
+    MessageElementFlags flags;
+    MessageFlags messageFlags;
+    // set if the flags include moderation buttons, the images of the actions
+    // are loaded on the gui thread when the request is made
+    std::shared_ptr<const std::vector<ModerationAction>> moderationActions;
+    // size of the previous layout, a new layout usually needs about as much
+    size_t elementCountHint = 0;
+    size_t elementBytesHint = 0;
+    // the layout is only installed if no newer request has been made since
+    unsigned int serial;
+};
+
 class MessageLayout : boost::noncopyable
 {
 public:
@@ -42,12 +73,34 @@ public:
 
     MessageLayoutFlags flags;
 
-    bool layout(int width, float scale_, MessageElementFlags flags);
+    bool layout(int width, float scale_, qreal devicePixelRatio,
+                MessageElementFlags flags);
+
+    // Asynchronous layout, see MessageLayoutWorker
+    // Returns a request if the layout is outdated and no request for the
+    // same parameters is pending
+    boost::optional<MessageLayoutRequest> requestLayout(
+        int width, float scale_, qreal devicePixelRatio,
+        MessageElementFlags flags);
+    // Can be called from any thread
+    static std::shared_ptr<MessageLayoutContainer> buildLayout(
+        const MessageLayoutRequest &request);
+    // Returns false if the request has been superseded by a newer one
+    bool applyLayout(const MessageLayoutRequest &request,
+                     std::shared_ptr<MessageLayoutContainer> container);
+    // Uses the layout another view has built for the same parameters, see
+    // MessageLayoutCache. Returns false if there is none.
+    bool applyCachedLayout(const MessageLayoutRequest &request);
+    // Returns true if the message has been laid out at least once
+    bool hasLayout() const;
 
     // Painting
     void paint(QPainter &painter, int width, int y, int messageIndex,
                Selection &selection, bool isLastReadMessage,
                bool isWindowFocused, bool isMentions);
+    // adds the animated images of the message painted at y to out
+    void addAnimatedImages(std::vector<std::pair<ImagePtr, QRect>> &out,
+                           int y) const;
     void invalidateBuffer();
     void deleteBuffer();
     void deleteCache();
@@ -66,24 +119,34 @@ public:
 private:
     // variables
     MessagePtr message_;
+    // layout and buffer, possibly shared with other views
+    std::shared_ptr<SharedMessageLayout> shared_;
+    // same as shared_->container
     std::shared_ptr<MessageLayoutContainer> container_;
-    std::shared_ptr<QPixmap> buffer_{};
-    bool bufferValid_ = false;
+    // true if we are counted in shared_->bufferUsers
+    bool holdsBuffer_ = false;
 
     int height_ = 0;
 
     int currentLayoutWidth_ = -1;
     int layoutState_ = -1;
     float scale_ = -1;
+    qreal devicePixelRatio_ = -1;
     unsigned int layoutCount_ = 0;
     unsigned int bufferUpdatedCount_ = 0;
 
+    unsigned int layoutSerial_ = 0;
+
     MessageElementFlags currentWordFlags_;
 
     int collapsedHeight_ = 32;
 
     // methods
-    void actuallyLayout(int width, MessageElementFlags flags);
+    bool prepareLayout(int width, float scale, qreal devicePixelRatio,
+                       MessageElementFlags flags);
+    MessageLayoutRequest makeRequest() const;
+    MessageLayoutKey cacheKey(const MessageLayoutRequest &request) const;
+    void setShared(std::shared_ptr<SharedMessageLayout> shared);
     void updateBuffer(QPixmap *pixmap, int messageIndex, Selection &selection);
 };
 
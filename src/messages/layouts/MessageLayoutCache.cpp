@@ -0,0 +1,205 @@
+#include "messages/layouts/MessageLayoutCache.hpp"
+
+#include "debug/AssertInGuiThread.hpp"
+#include "messages/Image.hpp"
+#include "messages/layouts/MessageBufferPool.hpp"
+#include "messages/layouts/MessageLayoutContainer.hpp"
+#include "util/DebugCount.hpp"
+
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace chatterino {
+
+bool MessageLayoutKey::operator==(const MessageLayoutKey &other) const
+{
+    return this->message == other.message && this->width == other.width &&
+           this->scale == other.scale &&
+           this->devicePixelRatio == other.devicePixelRatio &&
+           this->flags.value() == other.flags.value() &&
+           this->messageFlags.value() == other.messageFlags.value() &&
+           this->layoutFlags.value() == other.layoutFlags.value() &&
+           this->generation == other.generation;
+}
+
+size_t MessageLayoutKeyHash::operator()(const MessageLayoutKey &key) const
+{
+    size_t seed = 0;
+
+    boost::hash_combine(seed, key.message);
+    boost::hash_combine(seed, key.width);
+    boost::hash_combine(seed, key.scale);
+    boost::hash_combine(seed, key.devicePixelRatio);
+    boost::hash_combine(seed, int64_t(key.flags.value()));
+    boost::hash_combine(seed, uint32_t(key.messageFlags.value()));
+    boost::hash_combine(seed, uint8_t(key.layoutFlags.value()));
+    boost::hash_combine(seed, key.generation);
+
+    return seed;
+}
+
+SharedMessageLayout::~SharedMessageLayout()
+{
+    // normally released by the last MessageLayout painting from it
+    MessageBufferPool::instance().release(std::move(this->buffer));
+
+    if (this->key)
+    {
+        MessageLayoutCache::instance().remove(*this->key);
+        DebugCount::decrease("shared message layouts");
+    }
+}
+
+MessageLayoutCache &MessageLayoutCache::instance()
+{
+    static MessageLayoutCache instance;
+
+    return instance;
+}
+
+std::shared_ptr<SharedMessageLayout> MessageLayoutCache::find(
+    const MessageLayoutKey &key)
+{
+    assertInGuiThread();
+
+    auto it = this->entries_.find(key);
+    if (it == this->entries_.end())
+    {
+        return nullptr;
+    }
+
+    return it->second.lock();
+}
+
+std::shared_ptr<SharedMessageLayout> MessageLayoutCache::insert(
+    const MessageLayoutKey &key, MessagePtr message,
+    std::shared_ptr<MessageLayoutContainer> container)
+{
+    assertInGuiThread();
+
+    auto &weak = this->entries_[key];
+    if (auto shared = weak.lock())
+    {
+        // another view laid the message out in the meantime
+        return shared;
+    }
+
+    auto shared = std::make_shared<SharedMessageLayout>();
+    shared->message = std::move(message);
+    shared->container = std::move(container);
+    shared->container->listenToLinkChanges();
+    shared->key = key;
+    DebugCount::increase("shared message layouts");
+
+    weak = shared;
+
+    this->addImageDependencies(shared);
+
+    return shared;
+}
+
+void MessageLayoutCache::imageLoaded(
+    const std::vector<std::weak_ptr<SharedMessageLayout>> &dependents,
+    bool sizeChanged)
+{
+    assertInGuiThread();
+
+    for (const auto &weak : dependents)
+    {
+        auto shared = weak.lock();
+        if (!shared)
+        {
+            continue;
+        }
+
+        if (sizeChanged)
+        {
+            this->invalidate(*shared);
+        }
+        else
+        {
+            shared->bufferValid = false;
+        }
+
+        this->imageUpdates_ = true;
+    }
+}
+
+void MessageLayoutCache::bufferPainted(
+    const std::shared_ptr<SharedMessageLayout> &shared)
+{
+    assertInGuiThread();
+
+    for (const auto *element : shared->container->getImageElements())
+    {
+        const auto &image = element->getImage();
+        if (image && !image->loaded() && !image->isEmpty())
+        {
+            image->addLayoutDependent(shared);
+        }
+    }
+}
+
+bool MessageLayoutCache::takeImageUpdates()
+{
+    assertInGuiThread();
+
+    return std::exchange(this->imageUpdates_, false);
+}
+
+void MessageLayoutCache::addImageDependencies(
+    const std::shared_ptr<SharedMessageLayout> &shared)
+{
+    std::vector<const Image *> added;
+
+    for (const auto &pending : shared->container->getPendingImages())
+    {
+        auto &image = *pending.image;
+
+        if (image.loaded())
+        {
+            // finished loading while the layout was built on a worker
+            if (QSize(image.width(), image.height()) != pending.size)
+            {
+                this->invalidate(*shared);
+                return;
+            }
+        }
+        else if (std::find(added.begin(), added.end(), &image) == added.end())
+        {
+            image.addLayoutDependent(shared);
+            added.push_back(&image);
+        }
+    }
+}
+
+void MessageLayoutCache::invalidate(SharedMessageLayout &shared)
+{
+    shared.stale = true;
+
+    // later lookups build a new layout, the key stays set so the destructor
+    // still cleans up
+    if (shared.key)
+    {
+        auto it = this->entries_.find(*shared.key);
+        if (it != this->entries_.end() && it->second.lock().get() == &shared)
+        {
+            this->entries_.erase(it);
+        }
+    }
+}
+
+void MessageLayoutCache::remove(const MessageLayoutKey &key)
+{
+    auto it = this->entries_.find(key);
+
+    // the key might already belong to a newer entry
+    if (it != this->entries_.end() && it->second.expired())
+    {
+        this->entries_.erase(it);
+    }
+}
+
+}  // namespace chatterino
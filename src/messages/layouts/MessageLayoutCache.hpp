@@ -0,0 +1,107 @@
+#pragma once
+
+#include "messages/layouts/MessageLayout.hpp"
+
+#include <QPixmap>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace chatterino {
+
+/// Everything a laid out and rendered message depends on
+struct MessageLayoutKey {
+    const Message *message;
+    int width;
+    float scale;
+    // views on screens with different ratios can't share a buffer
+    qreal devicePixelRatio;
+    MessageElementFlags flags;
+    MessageFlags messageFlags;
+    // only the flags that change how the buffer is drawn
+    MessageLayoutFlags layoutFlags;
+    int generation;
+
+    bool operator==(const MessageLayoutKey &other) const;
+};
+
+struct MessageLayoutKeyHash {
+    size_t operator()(const MessageLayoutKey &key) const;
+};
+
+/// A layout and its render buffer, shared by all MessageLayouts that show the
+/// same message with the same parameters
+struct SharedMessageLayout : boost::noncopyable {
+    ~SharedMessageLayout();
+
+    // keeps the address of the message in key from being reused
+    MessagePtr message;
+    std::shared_ptr<MessageLayoutContainer> container;
+
+    std::shared_ptr<QPixmap> buffer;
+    bool bufferValid = false;
+    // number of MessageLayouts currently painting from buffer
+    int bufferUsers = 0;
+
+    // set if this is stored in the MessageLayoutCache
+    boost::optional<MessageLayoutKey> key;
+
+    // set once an image used by the layout was loaded with a different size
+    // than the layout was built with, the MessageLayouts using it lay the
+    // message out again
+    bool stale = false;
+};
+
+/// MessageLayoutCache lets all channel views share the layouts and render
+/// buffers of messages they show with the same parameters, e.g. a channel
+/// that is open in several splits.
+///
+/// Entries are reference counted by the MessageLayouts using them and get
+/// removed once the last one lets go. Gui thread only.
+class MessageLayoutCache
+{
+public:
+    static MessageLayoutCache &instance();
+
+    std::shared_ptr<SharedMessageLayout> find(const MessageLayoutKey &key);
+
+    /// Returns the entry for key. A new entry is created from container if
+    /// there isn't one yet.
+    std::shared_ptr<SharedMessageLayout> insert(
+        const MessageLayoutKey &key, MessagePtr message,
+        std::shared_ptr<MessageLayoutContainer> container);
+
+    /// Updates the layouts which were built before an image was loaded.
+    /// They are marked as stale if the image size changed, otherwise only
+    /// their buffers get repainted.
+    void imageLoaded(
+        const std::vector<std::weak_ptr<SharedMessageLayout>> &dependents,
+        bool sizeChanged);
+
+    /// Call after the buffer of shared was painted. Images which weren't
+    /// loaded, e.g. because ImageMemoryBudget dropped their frames, are
+    /// missing from the buffer, it is painted again once they are loaded.
+    void bufferPainted(const std::shared_ptr<SharedMessageLayout> &shared);
+
+    /// Returns true if imageLoaded updated any layout since the last call.
+    /// The channel views need to lay out their messages again in that case.
+    bool takeImageUpdates();
+
+private:
+    void remove(const MessageLayoutKey &key);
+    void invalidate(SharedMessageLayout &shared);
+    void addImageDependencies(
+        const std::shared_ptr<SharedMessageLayout> &shared);
+
+    std::unordered_map<MessageLayoutKey, std::weak_ptr<SharedMessageLayout>,
+                       MessageLayoutKeyHash>
+        entries_;
+    bool imageUpdates_ = false;
+
+    friend struct SharedMessageLayout;
+};
+
+}  // namespace chatterino
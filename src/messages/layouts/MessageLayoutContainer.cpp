@@ -1,6 +1,7 @@
 #include "MessageLayoutContainer.hpp"
 
 #include "Application.hpp"
+#include "messages/Image.hpp"
 #include "messages/Message.hpp"
 #include "messages/MessageElement.hpp"
 #include "messages/Selection.hpp"
@@ -33,6 +34,18 @@ float MessageLayoutContainer::getScale() const
     return this->scale_;
 }
 
+const std::shared_ptr<const std::vector<ModerationAction>> &
+    MessageLayoutContainer::getModerationActions() const
+{
+    return this->moderationActions_;
+}
+
+void MessageLayoutContainer::setModerationActions(
+    std::shared_ptr<const std::vector<ModerationAction>> actions)
+{
+    this->moderationActions_ = std::move(actions);
+}
+
 // methods
 void MessageLayoutContainer::begin(int width, float scale, MessageFlags flags)
 {
@@ -41,7 +54,7 @@ void MessageLayoutContainer::begin(int width, float scale, MessageFlags flags)
     this->scale_ = scale;
     this->flags_ = flags;
     auto mediumFontMetrics =
-        getApp()->fonts->getFontMetrics(FontStyle::ChatMedium, scale);
+        getFonts()->getFontMetrics(FontStyle::ChatMedium, scale);
     this->textLineHeight_ = mediumFontMetrics.height();
     this->spaceWidth_ = mediumFontMetrics.horizontalAdvance(' ');
     this->dotdotdotWidth_ = mediumFontMetrics.horizontalAdvance("...");
@@ -52,7 +65,10 @@ void MessageLayoutContainer::begin(int width, float scale, MessageFlags flags)
 void MessageLayoutContainer::clear()
 {
     this->elements_.clear();
+    this->imageElements_.clear();
+    this->arena_.clear();
     this->lines_.clear();
+    this->pendingImages_.clear();
 
     this->height_ = 0;
     this->line_ = 0;
@@ -82,6 +98,13 @@ void MessageLayoutContainer::addElementNoLineBreak(
     this->_addElement(element);
 }
 
+void MessageLayoutContainer::reserve(size_t elementCount,
+                                     size_t elementBytes)
+{
+    this->elements_.reserve(elementCount);
+    this->arena_.reserve(elementBytes);
+}
+
 bool MessageLayoutContainer::canAddElements()
 {
     return this->canAddMessages_;
@@ -92,7 +115,7 @@ void MessageLayoutContainer::_addElement(MessageLayoutElement *element,
 {
     if (!this->canAddElements() && !forceAdd)
     {
-        delete element;
+        this->arena_.destroy(element);
         return;
     }
 
@@ -184,7 +207,17 @@ void MessageLayoutContainer::_addElement(MessageLayoutElement *element,
     element->setLine(this->line_);
 
     // add element
-    this->elements_.push_back(std::unique_ptr<MessageLayoutElement>(element));
+    this->elements_.push_back(element);
+
+    if (auto *imageElement = dynamic_cast<ImageLayoutElement *>(element))
+    {
+        this->imageElements_.push_back(imageElement);
+
+        if (auto size = imageElement->getPlaceholderSize())
+        {
+            this->pendingImages_.push_back({imageElement->getImage(), *size});
+        }
+    }
 
     // set current x
     if (!isZeroWidthEmote)
@@ -215,7 +248,7 @@ void MessageLayoutContainer::breakLine()
 
     for (size_t i = lineStart_; i < this->elements_.size(); i++)
     {
-        MessageLayoutElement *element = this->elements_.at(i).get();
+        MessageLayoutElement *element = this->elements_.at(i);
 
         bool isCompactEmote =
             getSettings()->compactEmotes &&
@@ -296,7 +329,7 @@ void MessageLayoutContainer::end()
                                      MessageColor::Link);
         static QString dotdotdotText("...");
 
-        auto *element = new TextLayoutElement(
+        auto *element = this->createElement<TextLayoutElement>(
             dotdotdot, dotdotdotText,
             QSize(this->dotdotdotWidth_, this->textLineHeight_),
             QColor("#00D80A"), FontStyle::ChatMediumBold, this->scale_);
@@ -322,6 +355,22 @@ void MessageLayoutContainer::end()
     }
 }
 
+void MessageLayoutContainer::listenToLinkChanges()
+{
+    for (const auto &element : this->elements_)
+    {
+        if (element->getLink().type != Link::Url)
+        {
+            continue;
+        }
+
+        if (auto *text = dynamic_cast<TextLayoutElement *>(element))
+        {
+            text->listenToLinkChanges();
+        }
+    }
+}
+
 bool MessageLayoutContainer::canCollapse()
 {
     return getSettings()->collpseMessagesMinLines.getValue() > 0 &&
@@ -333,13 +382,35 @@ bool MessageLayoutContainer::isCollapsed()
     return this->isCollapsed_;
 }
 
+size_t MessageLayoutContainer::getElementCount() const
+{
+    return this->elements_.size();
+}
+
+size_t MessageLayoutContainer::getElementBytes() const
+{
+    return this->arena_.usedBytes();
+}
+
+const std::vector<MessageLayoutContainer::PendingImage> &
+    MessageLayoutContainer::getPendingImages() const
+{
+    return this->pendingImages_;
+}
+
+const std::vector<ImageLayoutElement *> &
+    MessageLayoutContainer::getImageElements() const
+{
+    return this->imageElements_;
+}
+
 MessageLayoutElement *MessageLayoutContainer::getElementAt(QPoint point)
 {
-    for (std::unique_ptr<MessageLayoutElement> &element : this->elements_)
+    for (auto *element : this->elements_)
     {
         if (element->getRect().contains(point))
         {
-            return element.get();
+            return element;
         }
     }
 
@@ -349,7 +420,7 @@ MessageLayoutElement *MessageLayoutContainer::getElementAt(QPoint point)
 // painting
 void MessageLayoutContainer::paintElements(QPainter &painter)
 {
-    for (const std::unique_ptr<MessageLayoutElement> &element : this->elements_)
+    for (auto *element : this->elements_)
     {
 #ifdef FOURTF
         painter.setPen(QColor(0, 255, 0));
@@ -363,12 +434,40 @@ void MessageLayoutContainer::paintElements(QPainter &painter)
 void MessageLayoutContainer::paintAnimatedElements(QPainter &painter,
                                                    int yOffset)
 {
-    for (const std::unique_ptr<MessageLayoutElement> &element : this->elements_)
+    for (auto *element : this->elements_)
     {
         element->paintAnimated(painter, yOffset);
     }
 }
 
+void MessageLayoutContainer::markImagesUsed() const
+{
+    for (auto *element : this->imageElements_)
+    {
+        if (const auto &image = element->getImage())
+        {
+            image->markUsed();
+        }
+    }
+}
+
+void MessageLayoutContainer::addAnimatedImages(
+    std::vector<std::pair<ImagePtr, QRect>> &out, int yOffset) const
+{
+    for (const auto &element : this->elements_)
+    {
+        auto *imageElement = dynamic_cast<ImageLayoutElement *>(element);
+        if (imageElement == nullptr || !imageElement->getImage() ||
+            !imageElement->getImage()->animated())
+        {
+            continue;
+        }
+
+        out.emplace_back(imageElement->getImage(),
+                         imageElement->getRect().translated(0, yOffset));
+    }
+}
+
 void MessageLayoutContainer::paintSelection(QPainter &painter, int messageIndex,
                                             Selection &selection, int yOffset)
 {
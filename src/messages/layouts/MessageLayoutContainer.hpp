@@ -8,6 +8,7 @@
 #include "common/Common.hpp"
 #include "common/FlagsEnum.hpp"
 #include "messages/Selection.hpp"
+#include "messages/layouts/LayoutElementArena.hpp"
 #include "messages/layouts/MessageLayoutElement.hpp"
 
 class QPainter;
@@ -16,6 +17,7 @@ namespace chatterino {
 
 enum class MessageFlag : uint32_t;
 using MessageFlags = FlagsEnum<MessageFlag>;
+class ModerationAction;
 
 struct Margin {
     int top;
@@ -43,6 +45,13 @@ struct Margin {
 };
 
 struct MessageLayoutContainer {
+    /// An image which wasn't loaded yet when the message was laid out
+    struct PendingImage {
+        ImagePtr image;
+        // the size the layout is based on
+        QSize size;
+    };
+
     MessageLayoutContainer() = default;
 
     Margin margin = {4, 8, 4, 8};
@@ -53,12 +62,36 @@ struct MessageLayoutContainer {
     int getWidth() const;
     float getScale() const;
 
+    // the moderation buttons to add, their images are already loaded, see
+    // MessageLayoutRequest
+    const std::shared_ptr<const std::vector<ModerationAction>> &
+        getModerationActions() const;
+    void setModerationActions(
+        std::shared_ptr<const std::vector<ModerationAction>> actions);
+
     // methods
+    // begin, end and adding elements may happen on a layout worker thread
     void begin(int width_, float scale_, MessageFlags flags_);
     void end();
 
+    // connects text elements to the link changes of their creators, call
+    // on the gui thread once the layout is done
+    void listenToLinkChanges();
+
     void clear();
+    // allocates storage for a layout of the given size up front, see
+    // getElementCount and getElementBytes
+    void reserve(size_t elementCount, size_t elementBytes);
     bool canAddElements();
+
+    // creates a layout element owned by this container, it still has to be
+    // added with addElement or addElementNoLineBreak
+    template <typename T, typename... Args>
+    T *createElement(Args &&... args)
+    {
+        return this->arena_.create<T>(std::forward<Args>(args)...);
+    }
+
     void addElement(MessageLayoutElement *element);
     void addElementNoLineBreak(MessageLayoutElement *element);
     void breakLine();
@@ -69,8 +102,14 @@ struct MessageLayoutContainer {
     // painting
     void paintElements(QPainter &painter);
     void paintAnimatedElements(QPainter &painter, int yOffset);
+    // adds the animated images and where they are painted to out
+    void addAnimatedImages(std::vector<std::pair<ImagePtr, QRect>> &out,
+                           int yOffset) const;
     void paintSelection(QPainter &painter, int messageIndex,
                         Selection &selection, int yOffset);
+    // keeps the images from being dropped by ImageMemoryBudget while the
+    // layout is painted from its buffer
+    void markImagesUsed() const;
 
     // selection
     int getSelectionIndex(QPoint point);
@@ -80,6 +119,12 @@ struct MessageLayoutContainer {
 
     bool isCollapsed();
 
+    size_t getElementCount() const;
+    size_t getElementBytes() const;
+
+    const std::vector<PendingImage> &getPendingImages() const;
+    const std::vector<ImageLayoutElement *> &getImageElements() const;
+
 private:
     struct Line {
         int startIndex;
@@ -109,9 +154,14 @@ private:
     int dotdotdotWidth_ = 0;
     bool canAddMessages_ = true;
     bool isCollapsed_ = false;
+    std::shared_ptr<const std::vector<ModerationAction>> moderationActions_;
 
-    std::vector<std::unique_ptr<MessageLayoutElement>> elements_;
+    // owns the elements, elements_ only references them
+    LayoutElementArena arena_;
+    std::vector<MessageLayoutElement *> elements_;
+    std::vector<ImageLayoutElement *> imageElements_;
     std::vector<Line> lines_;
+    std::vector<PendingImage> pendingImages_;
 };
 
 }  // namespace chatterino
@@ -100,6 +100,23 @@ ImageLayoutElement::ImageLayoutElement(MessageElement &creator, ImagePtr image,
     , image_(std::move(image))
 {
     this->trailingSpace = creator.hasTrailingSpace();
+
+    // check loaded first, the image might finish loading in between
+    if (this->image_ && !this->image_->loaded())
+    {
+        this->placeholderSize_ =
+            QSize(this->image_->width(), this->image_->height());
+    }
+}
+
+const ImagePtr &ImageLayoutElement::getImage() const
+{
+    return this->image_;
+}
+
+const boost::optional<QSize> &ImageLayoutElement::getPlaceholderSize() const
+{
+    return this->placeholderSize_;
 }
 
 void ImageLayoutElement::addCopyTextToString(QString &str, int from,
@@ -147,12 +164,9 @@ void ImageLayoutElement::paintAnimated(QPainter &painter, int yOffset)
 
     if (this->image_->animated())
     {
-        if (auto pixmap = this->image_->pixmapOrLoad())
-        {
-            auto rect = this->getRect();
-            rect.moveTop(rect.y() + yOffset);
-            painter.drawPixmap(QRectF(rect), *pixmap, QRectF());
-        }
+        auto rect = this->getRect();
+        rect.moveTop(rect.y() + yOffset);
+        this->image_->paintAnimated(painter, rect);
     }
 }
 
@@ -222,6 +236,9 @@ TextLayoutElement::TextLayoutElement(MessageElement &_creator, QString &_text,
 
 void TextLayoutElement::listenToLinkChanges()
 {
+    // the link might have changed while the layout was being built
+    this->setLink(this->getCreator().getLink());
+
     this->managedConnections_.managedConnect(
         static_cast<TextElement &>(this->getCreator()).linkChanged, [this]() {
             this->setLink(this->getCreator().getLink());
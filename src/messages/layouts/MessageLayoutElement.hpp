@@ -4,6 +4,7 @@
 #include <QRect>
 #include <QString>
 #include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
 #include <climits>
 
 #include "common/FlagsEnum.hpp"
@@ -68,6 +69,11 @@ public:
     ImageLayoutElement(MessageElement &creator, ImagePtr image,
                        const QSize &size);
 
+    const ImagePtr &getImage() const;
+    // Set if the image wasn't loaded yet when the element was created, in
+    // which case the layout is based on the image's placeholder size
+    const boost::optional<QSize> &getPlaceholderSize() const;
+
 protected:
     void addCopyTextToString(QString &str, int from = 0,
                              int to = INT_MAX) const override;
@@ -78,6 +84,7 @@ protected:
     int getXFromIndex(int index) override;
 
     ImagePtr image_;
+    boost::optional<QSize> placeholderSize_;
 };
 
 class ImageWithBackgroundLayoutElement : public ImageLayoutElement
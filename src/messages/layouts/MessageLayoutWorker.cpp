@@ -0,0 +1,64 @@
+#include "messages/layouts/MessageLayoutWorker.hpp"
+
+#include "messages/layouts/MessageLayoutContainer.hpp"
+#include "util/PostToThread.hpp"
+
+#include <QThread>
+
+#include <algorithm>
+
+namespace chatterino {
+
+MessageLayoutWorker &MessageLayoutWorker::instance()
+{
+    static MessageLayoutWorker instance;
+
+    return instance;
+}
+
+MessageLayoutWorker::MessageLayoutWorker()
+{
+    // leave a core for the gui thread
+    this->pool_.setMaxThreadCount(
+        std::max(1, QThread::idealThreadCount() - 1));
+}
+
+void MessageLayoutWorker::run(std::vector<Job> jobs,
+                              std::function<void()> done)
+{
+    this->pool_.start(new LambdaRunnable(
+        [jobs = std::move(jobs), done = std::move(done)]() mutable {
+            std::vector<std::shared_ptr<MessageLayoutContainer>> containers;
+            containers.reserve(jobs.size());
+
+            for (const auto &job : jobs)
+            {
+                // skip layouts whose view went away
+                if (job.layout.expired())
+                {
+                    containers.push_back(nullptr);
+                    continue;
+                }
+
+                containers.push_back(MessageLayout::buildLayout(job.request));
+            }
+
+            postToThread([jobs = std::move(jobs),
+                          containers = std::move(containers),
+                          done = std::move(done)]() mutable {
+                for (size_t i = 0; i < jobs.size(); i++)
+                {
+                    auto layout = jobs[i].layout.lock();
+                    if (layout && containers[i])
+                    {
+                        layout->applyLayout(jobs[i].request,
+                                            std::move(containers[i]));
+                    }
+                }
+
+                done();
+            });
+        }));
+}
+
+}  // namespace chatterino
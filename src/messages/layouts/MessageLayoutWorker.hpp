@@ -0,0 +1,37 @@
+#pragma once
+
+#include "messages/layouts/MessageLayout.hpp"
+
+#include <QThreadPool>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace chatterino {
+
+/// MessageLayoutWorker builds MessageLayoutContainers on a dedicated thread
+/// pool. The gui thread keeps painting the previous layouts and only swaps
+/// in the finished ones.
+class MessageLayoutWorker
+{
+public:
+    struct Job {
+        std::weak_ptr<MessageLayout> layout;
+        MessageLayoutRequest request;
+    };
+
+    static MessageLayoutWorker &instance();
+
+    /// Builds the layouts on the worker threads, installs them on the gui
+    /// thread and calls done afterwards. done is also called if some of the
+    /// layouts have been superseded or deleted in the meantime.
+    void run(std::vector<Job> jobs, std::function<void()> done);
+
+private:
+    MessageLayoutWorker();
+
+    QThreadPool pool_;
+};
+
+}  // namespace chatterino
@@ -0,0 +1,97 @@
+#include "messages/layouts/TextWidthCache.hpp"
+
+#include "util/DebugCount.hpp"
+
+#include <cstring>
+
+namespace chatterino {
+
+TextWidthCache &TextWidthCache::instance()
+{
+    // used by the layout workers until the very end
+    static auto *cache = new TextWidthCache;
+    return *cache;
+}
+
+int TextWidthCache::width(FontStyle style, float scale,
+                          const QFontMetrics &metrics, const QString &text)
+{
+    auto generation = this->generation();
+    Key key{text, scale, style};
+    auto hash = KeyHash()(key);
+    auto &shard = this->shards_[hash % shardCount];
+
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.current.find(key);
+        if (it != shard.current.end())
+        {
+            return it->second;
+        }
+
+        // keep widths which are still used
+        it = shard.previous.find(key);
+        if (it != shard.previous.end())
+        {
+            auto width = it->second;
+            shard.current.emplace(std::move(key), width);
+            return width;
+        }
+    }
+
+    auto width = metrics.horizontalAdvance(text);
+    DebugCount::increase("text width cache misses");
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // metrics might belong to the fonts from before a clear
+    if (generation != this->generation())
+    {
+        return width;
+    }
+
+    if (shard.current.size() >= maxEntries / shardCount)
+    {
+        shard.previous = std::move(shard.current);
+        shard.current.clear();
+    }
+    shard.current.emplace(std::move(key), width);
+
+    return width;
+}
+
+void TextWidthCache::clear()
+{
+    // first, so widths measured with the old fonts aren't added anymore
+    this->generation_++;
+
+    for (auto &shard : this->shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        shard.current.clear();
+        shard.previous.clear();
+    }
+}
+
+uint32_t TextWidthCache::generation() const
+{
+    return this->generation_;
+}
+
+bool TextWidthCache::Key::operator==(const Key &other) const
+{
+    return this->style == other.style && this->scale == other.scale &&
+           this->text == other.text;
+}
+
+size_t TextWidthCache::KeyHash::operator()(const Key &key) const
+{
+    uint32_t scaleBits;
+    std::memcpy(&scaleBits, &key.scale, sizeof(scaleBits));
+
+    return qHash(key.text, scaleBits * 31U + uint32_t(key.style));
+}
+
+}  // namespace chatterino
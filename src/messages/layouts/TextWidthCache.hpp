@@ -0,0 +1,74 @@
+#pragma once
+
+#include "singletons/Fonts.hpp"
+#include "util/QStringHash.hpp"
+
+#include <QFontMetrics>
+#include <QString>
+#include <boost/noncopyable.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace chatterino {
+
+/// TextWidthCache remembers the widths of words in the chat fonts, so the
+/// layouts of the same words don't measure them again, e.g. when resizing or
+/// zooming many splits.
+///
+/// Widths are kept per font style and scale. The cache is split into shards
+/// which each keep two generations of widths: once the current one is full,
+/// it replaces the previous one and widths which weren't used since are
+/// dropped. This bounds the cache to 2 * maxEntries widths.
+///
+/// Cleared by Fonts whenever the fonts change. This class is thread safe, it
+/// is used by the message layout workers.
+class TextWidthCache : boost::noncopyable
+{
+public:
+    static constexpr size_t maxEntries = 64 * 1024;
+
+    static TextWidthCache &instance();
+
+    /// Returns the width of text, metrics have to belong to style and scale
+    int width(FontStyle style, float scale, const QFontMetrics &metrics,
+              const QString &text);
+
+    /// Drops all widths, call after the fonts changed
+    void clear();
+
+    /// Increases whenever the cache is cleared. Widths cached elsewhere are
+    /// only valid for the generation they were measured in.
+    uint32_t generation() const;
+
+private:
+    struct Key {
+        QString text;
+        float scale;
+        FontStyle style;
+
+        bool operator==(const Key &other) const;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+
+    using Widths = std::unordered_map<Key, int, KeyHash>;
+
+    struct Shard {
+        std::mutex mutex;
+        Widths current;
+        Widths previous;
+    };
+
+    static constexpr size_t shardCount = 16;
+
+    std::array<Shard, shardCount> shards_;
+    std::atomic<uint32_t> generation_{1};
+};
+
+}  // namespace chatterino
@@ -10,6 +10,7 @@
 #include "messages/Image.hpp"
 #include "messages/ImageSet.hpp"
 #include "messages/MessageBuilder.hpp"
+#include "providers/twitch/MergedEmoteMap.hpp"
 #include "providers/twitch/TwitchChannel.hpp"
 
 namespace chatterino {
@@ -147,8 +148,11 @@ void BttvEmotes::loadEmotes()
             auto emotes = this->global_.get();
             auto pair = parseGlobalEmotes(result.parseJsonArray(), *emotes);
             if (pair.first)
+            {
                 this->global_.set(
                     std::make_shared<EmoteMap>(std::move(pair.second)));
+                MergedEmoteMapCache::invalidateGlobal();
+            }
             return pair.first;
         })
         .execute();
@@ -8,6 +8,7 @@
 #include "messages/Emote.hpp"
 #include "messages/Image.hpp"
 #include "messages/MessageBuilder.hpp"
+#include "providers/twitch/MergedEmoteMap.hpp"
 #include "providers/twitch/TwitchChannel.hpp"
 
 namespace chatterino {
@@ -190,8 +191,11 @@ void FfzEmotes::loadEmotes()
             auto emotes = this->emotes();
             auto pair = parseGlobalEmotes(result.parseJson(), *emotes);
             if (pair.first)
+            {
                 this->global_.set(
                     std::make_shared<EmoteMap>(std::move(pair.second)));
+                MergedEmoteMapCache::invalidateGlobal();
+            }
             return pair.first;
         })
         .execute();
@@ -5,6 +5,7 @@
 #include "controllers/accounts/AccountController.hpp"
 #include "messages/LimitedQueue.hpp"
 #include "messages/Message.hpp"
+#include "messages/MessageSimilarity.hpp"
 #include "providers/twitch/TwitchAccountManager.hpp"
 #include "providers/twitch/TwitchChannel.hpp"
 #include "providers/twitch/TwitchHelpers.hpp"
@@ -70,73 +71,29 @@ MessagePtr generateBannedMessage(bool confirmedBan)
 }  // namespace
 namespace chatterino {
 
-static float relativeSimilarity(const QString &str1, const QString &str2)
+bool IrcMessageHandler::isSimilar(const MessagePtr &msg, Channel &channel)
 {
-    // Longest Common Substring Problem
-    std::vector<std::vector<int>> tree(str1.size(),
-                                       std::vector<int>(str2.size(), 0));
-    int z = 0;
-
-    for (int i = 0; i < str1.size(); ++i)
+    const float threshold = getSettings()->similarityPercentage;
+    boost::optional<QString> loginName;
+    if (getSettings()->hideSimilarBySameUser)
     {
-        for (int j = 0; j < str2.size(); ++j)
-        {
-            if (str1[i] == str2[j])
-            {
-                if (i == 0 || j == 0)
-                {
-                    tree[i][j] = 1;
-                }
-                else
-                {
-                    tree[i][j] = tree[i - 1][j - 1] + 1;
-                }
-                if (tree[i][j] > z)
-                {
-                    z = tree[i][j];
-                }
-            }
-            else
-            {
-                tree[i][j] = 0;
-            }
-        }
+        loginName = msg->loginName;
     }
 
-    // ensure that no div by 0
-    return z == 0 ? 0.f
-                  : float(z) /
-                        std::max<int>(1, std::max(str1.size(), str2.size()));
-};
+    const SimilarityIndex::Window window{
+        getSettings()->hideSimilarMaxMessagesToCheck,
+        getSettings()->hideSimilarMaxDelay};
+    const auto &similarity = MessageSimilarity::of(*msg);
 
-float IrcMessageHandler::similarity(
-    MessagePtr msg, const LimitedQueueSnapshot<MessagePtr> &messages)
-{
-    float similarityPercent = 0.0f;
-    int checked = 0;
-    for (int i = 1; i <= messages.size(); ++i)
+    for (const auto &prevMsg :
+         channel.findSimilarityCandidates(loginName, window))
     {
-        if (checked >= getSettings()->hideSimilarMaxMessagesToCheck)
-        {
-            break;
-        }
-        const auto &prevMsg = messages[messages.size() - i];
-        if (prevMsg->parseTime.secsTo(QTime::currentTime()) >=
-            getSettings()->hideSimilarMaxDelay)
+        if (similarity.isSimilarTo(MessageSimilarity::of(*prevMsg), threshold))
         {
-            break;
-        }
-        if (getSettings()->hideSimilarBySameUser &&
-            msg->loginName != prevMsg->loginName)
-        {
-            continue;
+            return true;
         }
-        ++checked;
-        similarityPercent = std::max(
-            similarityPercent,
-            relativeSimilarity(msg->messageText, prevMsg->messageText));
     }
-    return similarityPercent;
+    return false;
 }
 
 void IrcMessageHandler::setSimilarityFlags(MessagePtr msg, ChannelPtr chan)
@@ -152,8 +109,7 @@ void IrcMessageHandler::setSimilarityFlags(MessagePtr msg, ChannelPtr chan)
             return;
         }
 
-        if (IrcMessageHandler::similarity(msg, chan->getMessageSnapshot()) >
-            getSettings()->similarityPercentage)
+        if (IrcMessageHandler::isSimilar(msg, *chan))
         {
             msg->flags.set(MessageFlag::Similar, true);
             if (getSettings()->colorSimilarDisabled)
@@ -51,8 +51,9 @@ public:
     void handleJoinMessage(Communi::IrcMessage *message);
     void handlePartMessage(Communi::IrcMessage *message);
 
-    static float similarity(MessagePtr msg,
-                            const LimitedQueueSnapshot<MessagePtr> &messages);
+    // isSimilar returns true if msg is similar to one of the last messages
+    // in channel according to the similarity settings
+    static bool isSimilar(const MessagePtr &msg, Channel &channel);
     static void setSimilarityFlags(MessagePtr message, ChannelPtr channel);
 
 private:
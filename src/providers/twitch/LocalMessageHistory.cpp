@@ -0,0 +1,197 @@
+#include "providers/twitch/LocalMessageHistory.hpp"
+
+#include "Application.hpp"
+#include "common/Channel.hpp"
+#include "debug/AssertInGuiThread.hpp"
+#include "messages/Message.hpp"
+#include "messages/MessageBuilder.hpp"
+#include "providers/twitch/IrcMessageHandler.hpp"
+#include "providers/twitch/TwitchChannel.hpp"
+#include "singletons/Logging.hpp"
+#include "singletons/helper/LogArchive.hpp"
+#include "util/PostToThread.hpp"
+
+#include <IrcMessage>
+#include <QLocale>
+#include <QThread>
+
+#include <algorithm>
+
+namespace chatterino {
+
+namespace {
+
+    // parsed messages are added to the channel in chunks of this size
+    constexpr size_t chunkSize = 100;
+
+    // Messages which weren't parsed from an IRC line, like timeouts, are
+    // added back as system messages. Connection status messages are left
+    // out, they only make sense at the time they were added.
+    bool isReplayable(const LogRecord &record)
+    {
+        if (!record.ircLine.isEmpty())
+        {
+            return true;
+        }
+
+        MessageFlags flags(static_cast<MessageFlag>(record.flags));
+
+        return flags.has(MessageFlag::System) &&
+               !flags.hasAny({MessageFlag::ConnectedMessage,
+                              MessageFlag::DisconnectedMessage});
+    }
+
+    MessagePtr makeDateMessage(const QDate &date)
+    {
+        auto message = makeSystemMessage(
+            QLocale().toString(date, QLocale::LongFormat), QTime(0, 0));
+        message->flags.set(MessageFlag::RecentMessage);
+
+        return message;
+    }
+
+    // Builds the messages of records[begin, end) in order
+    std::vector<MessagePtr> buildMessages(Channel *channel,
+                                          const std::vector<LogRecord> &records,
+                                          size_t begin, size_t end)
+    {
+        auto &handler = IrcMessageHandler::instance();
+        std::vector<MessagePtr> builtMessages;
+
+        for (auto i = begin; i < end; i++)
+        {
+            const auto &record = records[i];
+            auto time = record.time.toLocalTime();
+
+            if (LocalMessageHistory::startsDay(records, i))
+            {
+                builtMessages.push_back(makeDateMessage(time.date()));
+            }
+
+            if (record.ircLine.isEmpty())
+            {
+                auto message = makeSystemMessage(record.text, time.time());
+                message->flags.set(MessageFlag::RecentMessage);
+                builtMessages.push_back(message);
+                continue;
+            }
+
+            auto content = QString::fromUtf8(record.ircLine);
+            content.replace(COMBINED_FIXER, ZERO_WIDTH_JOINER);
+
+            std::unique_ptr<Communi::IrcMessage> message(
+                Communi::IrcMessage::fromData(content.toUtf8(), nullptr));
+
+            // keeps highlights and notifications from being triggered again
+            auto tags = message->tags();
+            tags.insert("historical", "1");
+            message->setTags(tags);
+
+            for (auto builtMessage :
+                 handler.parseMessage(channel, message.get()))
+            {
+                builtMessage->flags.set(MessageFlag::RecentMessage);
+                builtMessages.push_back(builtMessage);
+            }
+        }
+
+        return builtMessages;
+    }
+
+    // Parses the newest chunk of records[0, end) and adds it to the start
+    // of the channel, then queues the next one. The message builders use
+    // gui-only state, so this runs on the gui thread. One chunk per event
+    // keeps the gui responsive while a long history is parsed.
+    void addNewestChunk(const std::weak_ptr<Channel> &weak,
+                        const std::shared_ptr<std::vector<LogRecord>> &records,
+                        size_t end)
+    {
+        assertInGuiThread();
+
+        auto channel = weak.lock();
+        if (!channel)
+        {
+            return;
+        }
+
+        auto begin = end > chunkSize ? end - chunkSize : 0;
+        auto messages = buildMessages(channel.get(), *records, begin, end);
+
+        if (end == records->size())
+        {
+            channel->lastDate_ = records->back().time.toLocalTime().date();
+        }
+
+        channel->addMessagesAtStart(messages);
+
+        if (begin > 0)
+        {
+            postToThread([weak, records, begin] {
+                addNewestChunk(weak, records, begin);
+            });
+        }
+    }
+
+}  // namespace
+
+LocalMessageHistory &LocalMessageHistory::instance()
+{
+    static LocalMessageHistory instance;
+
+    return instance;
+}
+
+LocalMessageHistory::LocalMessageHistory()
+{
+    // leave a core for the gui thread
+    this->pool_.setMaxThreadCount(
+        std::max(1, QThread::idealThreadCount() - 1));
+}
+
+bool LocalMessageHistory::startsDay(const std::vector<LogRecord> &records,
+                                    size_t index)
+{
+    // an invalid date for the first message, which always starts a day
+    auto previousDate = index == 0
+                            ? QDate()
+                            : records[index - 1].time.toLocalTime().date();
+
+    return records[index].time.toLocalTime().date() != previousDate;
+}
+
+void LocalMessageHistory::load(const ChannelPtr &channel, int limit,
+                               std::function<void()> onEmpty)
+{
+    auto channelName = channel->getName();
+    auto directory = getApp()->logging->channelDirectory(channelName);
+    std::weak_ptr<Channel> weak = channel;
+
+    this->pool_.start(new LambdaRunnable([weak, channelName, directory, limit,
+                                          onEmpty = std::move(onEmpty)] {
+        LogArchiveReader reader(directory, channelName);
+
+        auto records = reader.readLast(size_t(std::max(limit, 0)),
+                                       QDateTime::currentDateTime());
+        records.erase(std::remove_if(records.begin(), records.end(),
+                                     [](const LogRecord &record) {
+                                         return !isReplayable(record);
+                                     }),
+                      records.end());
+
+        if (records.empty())
+        {
+            postToThread(onEmpty);
+            return;
+        }
+
+        auto history =
+            std::make_shared<std::vector<LogRecord>>(std::move(records));
+        auto end = history->size();
+
+        postToThread([weak, history, end] {
+            addNewestChunk(weak, history, end);
+        });
+    }));
+}
+
+}  // namespace chatterino
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QThreadPool>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace chatterino {
+
+class Channel;
+using ChannelPtr = std::shared_ptr<Channel>;
+struct LogRecord;
+
+/// LocalMessageHistory loads the message history of twitch channels from
+/// the structured logs (see LogArchiveWriter) instead of the recent
+/// messages service. The logs are read and decompressed on a dedicated
+/// thread pool, one job per channel. The messages are parsed on the gui
+/// thread since the message builders use gui-only state.
+class LocalMessageHistory
+{
+public:
+    static LocalMessageHistory &instance();
+
+    /// Reads the last limit logged messages of channel and adds them to
+    /// the start of the channel in chunks. The newest chunk comes first,
+    /// so recent messages show up before the rest is parsed. Each chunk is
+    /// parsed in its own event to keep the gui responsive. onEmpty is
+    /// called on the gui thread instead if nothing was logged.
+    void load(const ChannelPtr &channel, int limit,
+              std::function<void()> onEmpty);
+
+    /// Returns true if the message of records[index] is preceded by a date
+    /// separator. Like with the recent messages service, that is the first
+    /// message and every message on another day than the one before.
+    static bool startsDay(const std::vector<LogRecord> &records, size_t index);
+
+private:
+    LocalMessageHistory();
+
+    QThreadPool pool_;
+};
+
+}  // namespace chatterino
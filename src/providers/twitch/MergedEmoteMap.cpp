@@ -0,0 +1,133 @@
+#include "providers/twitch/MergedEmoteMap.hpp"
+
+#include "Application.hpp"
+#include "providers/bttv/BttvEmotes.hpp"
+#include "providers/ffz/FfzEmotes.hpp"
+#include "providers/twitch/TwitchIrcServer.hpp"
+#include "util/DebugCount.hpp"
+
+#include <QSet>
+
+namespace chatterino {
+
+namespace {
+
+    const QSet<QString> zeroWidthEmotes{
+        "SoSnowy",  "IceCold",   "SantaHat", "TopHat",
+        "ReinDeer", "CandyCane", "cvMask",   "cvHazmat",
+    };
+
+    std::atomic<uint64_t> globalGeneration{0};
+
+}  // namespace
+
+MergedEmoteMap::MergedEmoteMap(const Sources &sources)
+{
+    this->items_.reserve(
+        (sources.ffzChannel ? sources.ffzChannel->size() : 0) +
+        (sources.bttvChannel ? sources.bttvChannel->size() : 0) +
+        (sources.ffzGlobal ? sources.ffzGlobal->size() : 0) +
+        (sources.bttvGlobal ? sources.bttvGlobal->size() : 0));
+
+    // emotes added first take precedence
+    this->add(sources.ffzChannel, MessageElementFlag::FfzEmote);
+    this->add(sources.bttvChannel, MessageElementFlag::BttvEmote);
+    this->add(sources.ffzGlobal, MessageElementFlag::FfzEmote);
+    this->add(sources.bttvGlobal, MessageElementFlag::BttvEmote, true);
+}
+
+const MergedEmoteMap::Item *MergedEmoteMap::find(const EmoteName &name) const
+{
+    auto it = this->items_.find(name);
+    if (it == this->items_.end())
+    {
+        return nullptr;
+    }
+
+    return &it->second;
+}
+
+size_t MergedEmoteMap::size() const
+{
+    return this->items_.size();
+}
+
+void MergedEmoteMap::add(const std::shared_ptr<const EmoteMap> &emotes,
+                         MessageElementFlags flags, bool allowZeroWidth)
+{
+    if (!emotes)
+    {
+        return;
+    }
+
+    for (const auto &[name, emote] : *emotes)
+    {
+        auto itemFlags = flags;
+        if (allowZeroWidth && zeroWidthEmotes.contains(name.string))
+        {
+            itemFlags.set(MessageElementFlag::ZeroWidthEmote);
+        }
+
+        this->items_.emplace(name, Item{emote, itemFlags});
+    }
+}
+
+MergedEmoteMapCache::MergedEmoteMapCache(
+    std::function<void(MergedEmoteMap::Sources &)> channelEmotes)
+    : channelEmotes_(std::move(channelEmotes))
+{
+}
+
+std::shared_ptr<const MergedEmoteMap> MergedEmoteMapCache::get()
+{
+    auto isCurrent = [this](const std::shared_ptr<const Snapshot> &snapshot) {
+        return snapshot && snapshot->generation == this->generation_ &&
+               snapshot->globalGeneration == globalGeneration;
+    };
+
+    auto snapshot = std::atomic_load(&this->snapshot_);
+
+    if (!isCurrent(snapshot))
+    {
+        std::lock_guard<std::mutex> lock(this->buildMutex_);
+
+        // another thread might have rebuilt the map in the meantime
+        snapshot = std::atomic_load(&this->snapshot_);
+        if (!isCurrent(snapshot))
+        {
+            // The generations are read before the emotes, a change while
+            // building the map causes another rebuild on the next lookup.
+            uint64_t generation = this->generation_;
+            uint64_t global = globalGeneration;
+
+            MergedEmoteMap::Sources sources;
+            if (this->channelEmotes_)
+            {
+                this->channelEmotes_(sources);
+            }
+            sources.ffzGlobal = getApp()->twitch->getFfzEmotes().emotes();
+            sources.bttvGlobal = getApp()->twitch->getBttvEmotes().emotes();
+
+            snapshot = std::make_shared<const Snapshot>(
+                Snapshot{MergedEmoteMap(sources), generation, global});
+            std::atomic_store(&this->snapshot_, snapshot);
+
+            DebugCount::increase("merged emote map rebuilds");
+        }
+    }
+
+    // shares ownership with the snapshot
+    return std::shared_ptr<const MergedEmoteMap>(snapshot, &snapshot->map);
+}
+
+void MergedEmoteMapCache::invalidate()
+{
+    this->generation_++;
+}
+
+void MergedEmoteMapCache::invalidateGlobal()
+{
+    globalGeneration++;
+}
+
+}  // namespace chatterino
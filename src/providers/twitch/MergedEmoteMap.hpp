@@ -0,0 +1,93 @@
+#pragma once
+
+#include "messages/Emote.hpp"
+#include "messages/MessageElement.hpp"
+#include "util/QStringHash.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace chatterino {
+
+/// MergedEmoteMap combines the third party emotes usable in a Twitch channel
+/// into a single map. When a name is used by multiple providers, the emote
+/// is picked when the map is built, in this order:
+///  - FrankerFaceZ Channel
+///  - BetterTTV Channel
+///  - FrankerFaceZ Global
+///  - BetterTTV Global
+class MergedEmoteMap
+{
+public:
+    struct Sources {
+        std::shared_ptr<const EmoteMap> ffzChannel;
+        std::shared_ptr<const EmoteMap> bttvChannel;
+        std::shared_ptr<const EmoteMap> ffzGlobal;
+        std::shared_ptr<const EmoteMap> bttvGlobal;
+    };
+
+    struct Item {
+        EmotePtr emote;
+        MessageElementFlags flags;
+    };
+
+    explicit MergedEmoteMap(const Sources &sources);
+
+    /// Returns the emote for name together with the flags of its provider,
+    /// or nullptr if there is none
+    const Item *find(const EmoteName &name) const;
+
+    size_t size() const;
+
+private:
+    void add(const std::shared_ptr<const EmoteMap> &emotes,
+             MessageElementFlags flags, bool allowZeroWidth = false);
+
+    std::unordered_map<EmoteName, Item> items_;
+};
+
+/// MergedEmoteMapCache publishes the MergedEmoteMap of a channel.
+///
+/// The map is rebuilt on the first lookup after the channel's or the global
+/// emotes changed. Readers get the current map with an atomic load and keep
+/// using it for as long as they hold on to it, e.g. for one message, without
+/// taking any locks per word.
+class MergedEmoteMapCache : boost::noncopyable
+{
+public:
+    /// channelEmotes fills in the channel emotes of the sources, the global
+    /// emotes are filled in by the cache. Without it, the map only contains
+    /// global emotes.
+    explicit MergedEmoteMapCache(
+        std::function<void(MergedEmoteMap::Sources &)> channelEmotes = {});
+
+    std::shared_ptr<const MergedEmoteMap> get();
+
+    /// Call after the emotes returned by channelEmotes changed
+    void invalidate();
+
+    /// Call after the global FrankerFaceZ or BetterTTV emotes changed
+    static void invalidateGlobal();
+
+private:
+    struct Snapshot {
+        MergedEmoteMap map;
+        uint64_t generation;
+        uint64_t globalGeneration;
+    };
+
+    std::function<void(MergedEmoteMap::Sources &)> channelEmotes_;
+    std::atomic<uint64_t> generation_{0};
+
+    // only accessed through std::atomic_load and std::atomic_store
+    std::shared_ptr<const Snapshot> snapshot_;
+    // only one thread rebuilds the map at a time
+    std::mutex buildMutex_;
+};
+
+}  // namespace chatterino
@@ -11,6 +11,7 @@
 #include "providers/bttv/BttvEmotes.hpp"
 #include "providers/bttv/LoadBttvChannelEmote.hpp"
 #include "providers/twitch/IrcMessageHandler.hpp"
+#include "providers/twitch/LocalMessageHistory.hpp"
 #include "providers/twitch/PubSubManager.hpp"
 #include "providers/twitch/TwitchCommon.hpp"
 #include "providers/twitch/TwitchIrcServer.hpp"
@@ -156,6 +157,10 @@ TwitchChannel::TwitchChannel(const QString &name)
                        name)
     , bttvEmotes_(std::make_shared<EmoteMap>())
     , ffzEmotes_(std::make_shared<EmoteMap>())
+    , mergedEmotes_([this](MergedEmoteMap::Sources &sources) {
+        sources.ffzChannel = this->ffzEmotes_.get();
+        sources.bttvChannel = this->bttvEmotes_.get();
+    })
     , mod_(false)
 {
     qCDebug(chatterinoTwitch) << "[TwitchChannel" << name << "] Opened";
@@ -244,8 +249,11 @@ void TwitchChannel::refreshBTTVChannelEmotes(bool manualRefresh)
         weakOf<Channel>(this), this->roomId(), this->getLocalizedName(),
         [this, weak = weakOf<Channel>(this)](auto &&emoteMap) {
             if (auto shared = weak.lock())
+            {
                 this->bttvEmotes_.set(
                     std::make_shared<EmoteMap>(std::move(emoteMap)));
+                this->mergedEmotes_.invalidate();
+            }
         },
         manualRefresh);
 }
@@ -256,8 +264,11 @@ void TwitchChannel::refreshFFZChannelEmotes(bool manualRefresh)
         weakOf<Channel>(this), this->roomId(),
         [this, weak = weakOf<Channel>(this)](auto &&emoteMap) {
             if (auto shared = weak.lock())
+            {
                 this->ffzEmotes_.set(
                     std::make_shared<EmoteMap>(std::move(emoteMap)));
+                this->mergedEmotes_.invalidate();
+            }
         },
         [this, weak = weakOf<Channel>(this)](auto &&modBadge) {
             if (auto shared = weak.lock())
@@ -546,6 +557,11 @@ std::shared_ptr<const EmoteMap> TwitchChannel::ffzEmotes() const
     return this->ffzEmotes_.get();
 }
 
+std::shared_ptr<const MergedEmoteMap> TwitchChannel::mergedEmotes() const
+{
+    return this->mergedEmotes_.get();
+}
+
 const QString &TwitchChannel::subscriptionUrl()
 {
     return this->subscriptionUrl_;
@@ -752,6 +768,27 @@ void TwitchChannel::loadRecentMessages()
         return;
     }
 
+    if (getSettings()->loadMessageHistoryFromLogs)
+    {
+        auto weak = weakOf<Channel>(this);
+
+        LocalMessageHistory::instance().load(
+            weak.lock(), getSettings()->twitchMessageHistoryLimit,
+            [this, weak] {
+                // nothing was logged, e.g. for a new channel
+                if (weak.lock())
+                {
+                    this->loadRecentMessagesFromService();
+                }
+            });
+        return;
+    }
+
+    this->loadRecentMessagesFromService();
+}
+
+void TwitchChannel::loadRecentMessagesFromService()
+{
     QUrl url(Env::get().recentMessagesApiUrl.arg(this->getName()));
     QUrlQuery urlQuery(url);
     if (!urlQuery.hasQueryItem("limit"))
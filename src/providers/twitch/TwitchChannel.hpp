@@ -8,6 +8,7 @@
 #include "common/Outcome.hpp"
 #include "common/UniqueAccess.hpp"
 #include "providers/twitch/ChannelPointReward.hpp"
+#include "providers/twitch/MergedEmoteMap.hpp"
 #include "providers/twitch/TwitchEmotes.hpp"
 #include "providers/twitch/api/Helix.hpp"
 #include "util/QStringHash.hpp"
@@ -105,6 +106,8 @@ public:
     boost::optional<EmotePtr> ffzEmote(const EmoteName &name) const;
     std::shared_ptr<const EmoteMap> bttvEmotes() const;
     std::shared_ptr<const EmoteMap> ffzEmotes() const;
+    /// Returns the FrankerFaceZ and BetterTTV emotes usable in this channel
+    std::shared_ptr<const MergedEmoteMap> mergedEmotes() const;
 
     virtual void refreshBTTVChannelEmotes(bool manualRefresh);
     virtual void refreshFFZChannelEmotes(bool manualRefresh);
@@ -150,6 +153,7 @@ private:
     void refreshBadges();
     void refreshCheerEmotes();
     void loadRecentMessages();
+    void loadRecentMessagesFromService();
     void fetchDisplayName();
 
     void setLive(bool newLiveStatus);
@@ -177,6 +181,8 @@ protected:
     Atomic<std::shared_ptr<const EmoteMap>> ffzEmotes_;
     Atomic<boost::optional<EmotePtr>> ffzCustomModBadge_;
     Atomic<boost::optional<EmotePtr>> ffzCustomVipBadge_;
+    // call invalidate after changing bttvEmotes_ or ffzEmotes_
+    mutable MergedEmoteMapCache mergedEmotes_;
 
 private:
     // Badges
@@ -4,9 +4,11 @@
 #include "controllers/accounts/AccountController.hpp"
 #include "controllers/ignores/IgnoreController.hpp"
 #include "controllers/ignores/IgnorePhrase.hpp"
+#include "controllers/ignores/IgnoreReplacer.hpp"
 #include "messages/Message.hpp"
 #include "providers/chatterino/ChatterinoBadges.hpp"
 #include "providers/ffz/FfzBadges.hpp"
+#include "providers/twitch/MergedEmoteMap.hpp"
 #include "providers/twitch/TwitchBadges.hpp"
 #include "providers/twitch/TwitchChannel.hpp"
 #include "providers/twitch/TwitchIrcServer.hpp"
@@ -25,6 +27,7 @@
 #include <QMediaPlayer>
 #include <QStringRef>
 #include <boost/variant.hpp>
+#include <limits>
 #include "common/QLogging.hpp"
 
 namespace {
@@ -37,11 +40,6 @@ const QRegularExpression mentionRegex("^@" + regexHelpString);
 // if findAllUsernames setting is enabled, matches strings like in the examples above, but without @ symbol at the beginning
 const QRegularExpression allUsernamesMentionRegex("^" + regexHelpString);
 
-const QSet<QString> zeroWidthEmotes{
-    "SoSnowy",  "IceCold",   "SantaHat", "TopHat",
-    "ReinDeer", "CandyCane", "cvMask",   "cvHazmat",
-};
-
 }  // namespace
 
 namespace chatterino {
@@ -147,6 +145,11 @@ MessagePtr TwitchMessageBuilder::build()
 
     this->message().channelName = this->channel->getName();
 
+    if (getSettings()->enableLogging && getSettings()->enableStructuredLogs)
+    {
+        this->message().ircLine = this->ircMessage->toData();
+    }
+
     this->parseMessageID();
 
     this->parseRoomID();
@@ -701,218 +704,145 @@ void TwitchMessageBuilder::appendUsername()
 void TwitchMessageBuilder::runIgnoreReplaces(
     std::vector<TwitchEmoteOccurence> &twitchEmotes)
 {
-    auto phrases = getCSettings().ignoredMessages.readOnly();
-    auto removeEmotesInRange = [](int pos, int len,
-                                  auto &twitchEmotes) mutable {
-        auto it = std::partition(
-            twitchEmotes.begin(), twitchEmotes.end(),
-            [pos, len](const auto &item) {
-                return !((item.start >= pos) && item.start < (pos + len));
-            });
-        for (auto copy = it; copy != twitchEmotes.end(); ++copy)
-        {
-            if ((*copy).ptr == nullptr)
-            {
-                qCDebug(chatterinoTwitch)
-                    << "remem nullptr" << (*copy).name.string;
-            }
-        }
-        std::vector<TwitchEmoteOccurence> v(it, twitchEmotes.end());
-        twitchEmotes.erase(it, twitchEmotes.end());
-        return v;
-    };
+    auto replacer = getCSettings().ignoredMessagesReplacer.get();
+    auto replacements = replacer->findReplacements(this->originalMessage_);
+    if (replacements.empty())
+    {
+        return;
+    }
+
+    std::sort(twitchEmotes.begin(), twitchEmotes.end(),
+              [](const auto &a, const auto &b) {
+                  return a.start < b.start;
+              });
 
-    auto shiftIndicesAfter = [&twitchEmotes](int pos, int by) mutable {
-        for (auto &item : twitchEmotes)
+    // Build the new message and move the emotes in one sweep. Emotes after a
+    // replacement are shifted, emotes starting inside of one are removed and
+    // looked for again once the message is complete.
+    QString message;
+    std::vector<TwitchEmoteOccurence> emotes;
+    std::vector<std::vector<TwitchEmoteOccurence>> removedEmotes(
+        replacements.size());
+    std::vector<int> newStarts;
+    newStarts.reserve(replacements.size());
+
+    auto emoteIt = twitchEmotes.begin();
+    int from = 0;
+    int shift = 0;
+
+    auto keepEmotesBefore = [&](int end) {
+        for (; emoteIt != twitchEmotes.end() && emoteIt->start < end;
+             ++emoteIt)
         {
-            auto &index = item.start;
-            if (index >= pos)
-            {
-                index += by;
-                item.end += by;
-            }
+            emoteIt->start += shift;
+            emoteIt->end += shift;
+            emotes.push_back(std::move(*emoteIt));
         }
     };
 
-    auto addReplEmotes = [&twitchEmotes](const IgnorePhrase &phrase,
-                                         const QStringRef &midrepl,
-                                         int startIndex) mutable {
-        if (!phrase.containsEmote())
-        {
-            return;
-        }
+    for (size_t i = 0; i < replacements.size(); i++)
+    {
+        const auto &replacement = replacements[i];
+        auto end = replacement.start + replacement.length;
 
-        QVector<QStringRef> words = midrepl.split(' ');
-        int pos = 0;
-        for (const auto &word : words)
+        keepEmotesBefore(replacement.start);
+        for (; emoteIt != twitchEmotes.end() && emoteIt->start < end;
+             ++emoteIt)
         {
-            for (const auto &emote : phrase.getEmotes())
-            {
-                if (word == emote.first.string)
-                {
-                    if (emote.second == nullptr)
-                    {
-                        qCDebug(chatterinoTwitch)
-                            << "emote null" << emote.first.string;
-                    }
-                    twitchEmotes.push_back(TwitchEmoteOccurence{
-                        startIndex + pos,
-                        startIndex + pos + emote.first.string.length(),
-                        emote.second,
-                        emote.first,
-                    });
-                }
-            }
-            pos += word.length() + 1;
+            removedEmotes[i].push_back(std::move(*emoteIt));
         }
+
+        message +=
+            this->originalMessage_.midRef(from, replacement.start - from);
+        newStarts.push_back(message.size());
+        message += replacement.replacement;
+
+        from = end;
+        shift += replacement.replacement.size() - replacement.length;
+    }
+    keepEmotesBefore(std::numeric_limits<int>::max());
+    message += this->originalMessage_.midRef(from);
+
+    this->originalMessage_ = message;
+    twitchEmotes = std::move(emotes);
+
+    auto isWordCharacter = [](QChar c) {
+        return c.isLetterOrNumber() || c == '_';
     };
 
-    for (const auto &phrase : *phrases)
+    for (size_t i = 0; i < replacements.size(); i++)
     {
-        if (phrase.isBlock())
+        const auto &phrase = replacer->phrases()[replacements[i].phrase];
+        auto start = newStarts[i];
+        auto size = replacements[i].replacement.size();
+
+        // extend the replaced span to whole words
+        int pos1 = start;
+        while (pos1 > 0 && message[pos1 - 1] != ' ')
         {
-            continue;
+            --pos1;
         }
-        const auto &pattern = phrase.getPattern();
-        if (pattern.isEmpty())
+        int pos2 = start + size;
+        while (pos2 < message.length() && message[pos2] != ' ')
         {
-            continue;
+            ++pos2;
         }
-        if (phrase.isRegex())
+        auto midExtendedRef = message.midRef(pos1, pos2 - pos1);
+
+        // keep removed emotes which are still in the text
+        for (auto &emote : removedEmotes[i])
         {
-            const auto &regex = phrase.getRegex();
-            if (!regex.isValid())
+            if (emote.ptr == nullptr)
             {
+                qCDebug(chatterinoTwitch) << "v nullptr" << emote.name.string;
                 continue;
             }
-            QRegularExpressionMatch match;
-            int from = 0;
-            while ((from = this->originalMessage_.indexOf(regex, from,
-                                                          &match)) != -1)
-            {
-                int len = match.capturedLength();
-                auto vret = removeEmotesInRange(from, len, twitchEmotes);
-                auto mid = this->originalMessage_.mid(from, len);
-                mid.replace(regex, phrase.getReplace());
-
-                int midsize = mid.size();
-                this->originalMessage_.replace(from, len, mid);
-                int pos1 = from;
-                while (pos1 > 0)
-                {
-                    if (this->originalMessage_[pos1 - 1] == ' ')
-                    {
-                        break;
-                    }
-                    --pos1;
-                }
-                int pos2 = from + midsize;
-                while (pos2 < this->originalMessage_.length())
-                {
-                    if (this->originalMessage_[pos2] == ' ')
-                    {
-                        break;
-                    }
-                    ++pos2;
-                }
 
-                shiftIndicesAfter(from + len, midsize - len);
-
-                auto midExtendedRef =
-                    this->originalMessage_.midRef(pos1, pos2 - pos1);
-
-                for (auto &tup : vret)
+            const auto &name = emote.name.string;
+            int index = -1;
+            while ((index = midExtendedRef.indexOf(name, index + 1)) != -1)
+            {
+                auto after = index + name.size();
+                if ((index == 0 ||
+                     !isWordCharacter(midExtendedRef.at(index - 1))) &&
+                    (after == midExtendedRef.size() ||
+                     !isWordCharacter(midExtendedRef.at(after))))
                 {
-                    if (tup.ptr == nullptr)
-                    {
-                        qCDebug(chatterinoTwitch)
-                            << "v nullptr" << tup.name.string;
-                        continue;
-                    }
-                    QRegularExpression emoteregex(
-                        "\\b" + tup.name.string + "\\b",
-                        QRegularExpression::UseUnicodePropertiesOption);
-                    auto _match = emoteregex.match(midExtendedRef);
-                    if (_match.hasMatch())
-                    {
-                        int last = _match.lastCapturedIndex();
-                        for (int i = 0; i <= last; ++i)
-                        {
-                            tup.start = from + _match.capturedStart();
-                            twitchEmotes.push_back(std::move(tup));
-                        }
-                    }
+                    emote.start = pos1 + index;
+                    emote.end = emote.start + name.size() - 1;
+                    twitchEmotes.push_back(std::move(emote));
+                    break;
                 }
-
-                addReplEmotes(phrase, midExtendedRef, pos1);
-
-                from += midsize;
             }
         }
-        else
-        {
-            int from = 0;
-            while ((from = this->originalMessage_.indexOf(
-                        pattern, from, phrase.caseSensitivity())) != -1)
-            {
-                int len = pattern.size();
-                auto vret = removeEmotesInRange(from, len, twitchEmotes);
-                auto replace = phrase.getReplace();
-
-                int replacesize = replace.size();
-                this->originalMessage_.replace(from, len, replace);
 
-                int pos1 = from;
-                while (pos1 > 0)
-                {
-                    if (this->originalMessage_[pos1 - 1] == ' ')
-                    {
-                        break;
-                    }
-                    --pos1;
-                }
-                int pos2 = from + replacesize;
-                while (pos2 < this->originalMessage_.length())
-                {
-                    if (this->originalMessage_[pos2] == ' ')
-                    {
-                        break;
-                    }
-                    ++pos2;
-                }
-
-                shiftIndicesAfter(from + len, replacesize - len);
-
-                auto midExtendedRef =
-                    this->originalMessage_.midRef(pos1, pos2 - pos1);
+        // add emotes from the replacement
+        if (!phrase.containsEmote())
+        {
+            continue;
+        }
 
-                for (auto &tup : vret)
+        int pos = 0;
+        for (const auto &word : midExtendedRef.split(' '))
+        {
+            for (const auto &emote : phrase.getEmotes())
+            {
+                if (word == emote.first.string)
                 {
-                    if (tup.ptr == nullptr)
+                    if (emote.second == nullptr)
                     {
                         qCDebug(chatterinoTwitch)
-                            << "v nullptr" << tup.name.string;
-                        continue;
-                    }
-                    QRegularExpression emoteregex(
-                        "\\b" + tup.name.string + "\\b",
-                        QRegularExpression::UseUnicodePropertiesOption);
-                    auto match = emoteregex.match(midExtendedRef);
-                    if (match.hasMatch())
-                    {
-                        int last = match.lastCapturedIndex();
-                        for (int i = 0; i <= last; ++i)
-                        {
-                            tup.start = from + match.capturedStart();
-                            twitchEmotes.push_back(std::move(tup));
-                        }
+                            << "emote null" << emote.first.string;
                     }
+                    twitchEmotes.push_back(TwitchEmoteOccurence{
+                        pos1 + pos,
+                        pos1 + pos + emote.first.string.length(),
+                        emote.second,
+                        emote.first,
+                    });
                 }
-
-                addReplEmotes(phrase, midExtendedRef, pos1);
-
-                from += replacesize;
             }
+            pos += word.length() + 1;
         }
     }
 }
@@ -970,45 +900,25 @@ void TwitchMessageBuilder::appendTwitchEmote(
 
 Outcome TwitchMessageBuilder::tryAppendEmote(const EmoteName &name)
 {
-    auto *app = getApp();
-
-    const auto &globalBttvEmotes = app->twitch->getBttvEmotes();
-    const auto &globalFfzEmotes = app->twitch->getFfzEmotes();
-
-    auto flags = MessageElementFlags();
-    auto emote = boost::optional<EmotePtr>{};
-
-    // Emote order:
-    //  - FrankerFaceZ Channel
-    //  - BetterTTV Channel
-    //  - FrankerFaceZ Global
-    //  - BetterTTV Global
-    if (this->twitchChannel && (emote = this->twitchChannel->ffzEmote(name)))
-    {
-        flags = MessageElementFlag::FfzEmote;
-    }
-    else if (this->twitchChannel &&
-             (emote = this->twitchChannel->bttvEmote(name)))
-    {
-        flags = MessageElementFlag::BttvEmote;
-    }
-    else if ((emote = globalFfzEmotes.emote(name)))
+    // the emotes are looked up once per message, the precedence of the
+    // providers is resolved in MergedEmoteMap
+    if (!this->mergedEmotes_)
     {
-        flags = MessageElementFlag::FfzEmote;
-    }
-    else if ((emote = globalBttvEmotes.emote(name)))
-    {
-        flags = MessageElementFlag::BttvEmote;
-
-        if (zeroWidthEmotes.contains(name.string))
+        if (this->twitchChannel)
         {
-            flags.set(MessageElementFlag::ZeroWidthEmote);
+            this->mergedEmotes_ = this->twitchChannel->mergedEmotes();
+        }
+        else
+        {
+            static auto *globalEmotes = new MergedEmoteMapCache();
+            this->mergedEmotes_ = globalEmotes->get();
         }
     }
 
-    if (emote)
+    if (const auto *item = this->mergedEmotes_->find(name))
     {
-        this->emplace<EmoteElement>(emote.get(), flags, this->textColor_);
+        this->emplace<EmoteElement>(item->emote, item->flags,
+                                    this->textColor_);
         return Success;
     }
 
@@ -18,6 +18,7 @@ using EmotePtr = std::shared_ptr<const Emote>;
 
 class Channel;
 class TwitchChannel;
+class MergedEmoteMap;
 
 struct TwitchEmoteOccurence {
     int start;
@@ -104,6 +105,9 @@ private:
 
     QString userId_;
     bool senderIsBroadcaster{};
+
+    // see tryAppendEmote
+    std::shared_ptr<const MergedEmoteMap> mergedEmotes_;
 };
 
 }  // namespace chatterino
@@ -2,6 +2,7 @@
 
 #include "BaseSettings.hpp"
 #include "debug/AssertInGuiThread.hpp"
+#include "messages/layouts/TextWidthCache.hpp"
 
 #include <QDebug>
 #include <QtGlobal>
@@ -53,10 +54,7 @@ void Fonts::initialize(Settings &, Paths &)
         [this]() {
             assertInGuiThread();
 
-            for (auto &map : this->fontsByType_)
-            {
-                map.clear();
-            }
+            this->clearFontData();
             this->fontChanged.invoke();
         },
         false);
@@ -65,10 +63,7 @@ void Fonts::initialize(Settings &, Paths &)
         [this]() {
             assertInGuiThread();
 
-            for (auto &map : this->fontsByType_)
-            {
-                map.clear();
-            }
+            this->clearFontData();
             this->fontChanged.invoke();
         },
         false);
@@ -81,10 +76,7 @@ void Fonts::initialize(Settings &, Paths &)
             // REMOVED
             getApp()->windows->incGeneration();
 
-            for (auto &map : this->fontsByType_)
-            {
-                map.clear();
-            }
+            this->clearFontData();
             this->fontChanged.invoke();
         },
         false);
@@ -93,18 +85,36 @@ void Fonts::initialize(Settings &, Paths &)
 
 QFont Fonts::getFont(FontStyle type, float scale)
 {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
     return this->getOrCreateFontData(type, scale).font;
 }
 
 QFontMetrics Fonts::getFontMetrics(FontStyle type, float scale)
 {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
     return this->getOrCreateFontData(type, scale).metrics;
 }
 
-Fonts::FontData &Fonts::getOrCreateFontData(FontStyle type, float scale)
+void Fonts::clearFontData()
 {
-    assertInGuiThread();
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        for (auto &map : this->fontsByType_)
+        {
+            map.clear();
+        }
+    }
+
+    // before fontChanged is invoked, which relayouts all messages
+    TextWidthCache::instance().clear();
+}
 
+// requires mutex_ to be locked
+Fonts::FontData &Fonts::getOrCreateFontData(FontStyle type, float scale)
+{
     assert(type < FontStyle::EndType);
 
     auto &map = this->fontsByType_[size_t(type)];
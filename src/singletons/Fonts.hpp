@@ -10,6 +10,7 @@
 #include <pajlada/signals/signal.hpp>
 
 #include <array>
+#include <mutex>
 #include <unordered_map>
 
 namespace chatterino {
@@ -48,6 +49,8 @@ public:
 
     // font data gets set in createFontData(...)
 
+    // getFont and getFontMetrics are thread safe, they get called by the
+    // message layout workers
     QFont getFont(FontStyle type, float scale);
     QFontMetrics getFontMetrics(FontStyle type, float scale);
 
@@ -84,7 +87,10 @@ private:
 
     FontData &getOrCreateFontData(FontStyle type, float scale);
     FontData createFontData(FontStyle type, float scale);
+    void clearFontData();
 
+    // guards fontsByType_
+    std::mutex mutex_;
     std::vector<std::unordered_map<float, FontData>> fontsByType_;
 };
 
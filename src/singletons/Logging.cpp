@@ -7,12 +7,41 @@
 #include <QDir>
 #include <QStandardPaths>
 
-#include <unordered_map>
+#include <chrono>
 
 namespace chatterino {
 
+namespace {
+
+    // lines are collected for this long before they are written, this is
+    // also about as much as is lost if chatterino crashes
+    constexpr auto flushDelay = std::chrono::seconds(1);
+    // lines are written right away once this many bytes are queued
+    constexpr int maxPendingBytes = 256 * 1024;
+
+}  // namespace
+
+Logging::~Logging()
+{
+    this->stop();
+}
+
 void Logging::initialize(Settings &settings, Paths &paths)
 {
+    this->pathManager = &paths;
+
+    settings.logPath.connect([this](const QString &logPath, auto) {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        this->baseDirectory_ = logPath.isEmpty()
+                                   ? this->pathManager->messageLogDirectory
+                                   : logPath;
+    });
+}
+
+void Logging::save()
+{
+    this->stop();
 }
 
 void Logging::addMessage(const QString &channelName, MessagePtr message)
@@ -22,17 +51,135 @@ void Logging::addMessage(const QString &channelName, MessagePtr message)
         return;
     }
 
-    auto it = this->loggingChannels_.find(channelName);
-    if (it == this->loggingChannels_.end())
+    PendingLine line{channelName, {}, getSettings()->enableStructuredLogs};
+    line.record.time = QDateTime::currentDateTime();
+    line.record.text = message->searchText;
+
+    if (line.structured)
+    {
+        line.record.loginName = message->loginName;
+        line.record.displayName = message->displayName;
+        line.record.flags = uint32_t(message->flags.value());
+        for (const auto &badge : message->badges)
+        {
+            line.record.badges.append(badge.key_ + "/" + badge.value_);
+        }
+        line.record.ircLine = message->ircLine;
+    }
+
+    bool flushNow = false;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        this->pending_.push_back(std::move(line));
+        this->pendingBytes_ += message->searchText.size();
+        flushNow = this->pendingBytes_ >= maxPendingBytes;
+
+        // started with the first message, logging is off by default
+        if (!this->thread_.joinable())
+        {
+            this->stopping_ = false;
+            this->thread_ = std::thread([this] {
+                this->run();
+            });
+        }
+    }
+
+    if (flushNow)
+    {
+        this->condition_.notify_one();
+    }
+}
+
+QString Logging::channelDirectory(const QString &channelName)
+{
+    std::lock_guard<std::mutex> lock(this->mutex_);
+
+    return this->baseDirectory_ + QDir::separator() +
+           LoggingChannel::subDirectoryOf(channelName);
+}
+
+void Logging::run()
+{
+    std::unique_lock<std::mutex> lock(this->mutex_);
+
+    while (true)
+    {
+        this->condition_.wait(lock, [this] {
+            return !this->pending_.empty() || this->stopping_;
+        });
+
+        // collect more lines before writing
+        this->condition_.wait_for(lock, flushDelay, [this] {
+            return this->pendingBytes_ >= maxPendingBytes || this->stopping_;
+        });
+
+        std::vector<PendingLine> lines;
+        std::swap(lines, this->pending_);
+        this->pendingBytes_ = 0;
+        auto baseDirectory = this->baseDirectory_;
+        auto stopping = this->stopping_;
+
+        lock.unlock();
+
+        this->write(lines, baseDirectory);
+
+        if (stopping)
+        {
+            // writes the closing lines
+            this->loggingChannels_.clear();
+            return;
+        }
+
+        lock.lock();
+    }
+}
+
+void Logging::stop()
+{
     {
-        auto channel = new LoggingChannel(channelName);
-        channel->addMessage(message);
-        this->loggingChannels_.emplace(
-            channelName, std::unique_ptr<LoggingChannel>(std::move(channel)));
+        std::lock_guard<std::mutex> lock(this->mutex_);
+
+        if (!this->thread_.joinable())
+        {
+            return;
+        }
+        this->stopping_ = true;
     }
-    else
+
+    this->condition_.notify_one();
+    this->thread_.join();
+}
+
+void Logging::write(const std::vector<PendingLine> &lines,
+                    const QString &baseDirectory)
+{
+    for (auto &&channel : this->loggingChannels_)
+    {
+        channel.second->setBaseDirectory(baseDirectory);
+    }
+
+    for (const auto &line : lines)
+    {
+        auto it = this->loggingChannels_.find(line.channelName);
+        if (it == this->loggingChannels_.end())
+        {
+            it = this->loggingChannels_
+                     .emplace(line.channelName,
+                              std::unique_ptr<LoggingChannel>(
+                                  new LoggingChannel(line.channelName,
+                                                     baseDirectory)))
+                     .first;
+        }
+
+        it->second->addMessage(line.record, line.structured);
+    }
+
+    // one write per channel and batch
+    for (auto &&channel : this->loggingChannels_)
     {
-        it->second->addMessage(message);
+        channel.second->flush();
     }
 }
 
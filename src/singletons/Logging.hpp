@@ -3,26 +3,63 @@
 #include "common/Singleton.hpp"
 
 #include "messages/Message.hpp"
+#include "singletons/helper/LogArchive.hpp"
 #include "singletons/helper/LoggingChannel.hpp"
 
+#include <condition_variable>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace chatterino {
 
 class Paths;
 
+/// Writes the chat logs on a dedicated thread. addMessage only queues the
+/// line, the logging thread collects lines for a while and writes them to
+/// the log files in batches, so the gui thread never touches a log file.
+/// Structured logs (see LogArchiveWriter) are written next to the plain text
+/// logs if they are enabled.
 class Logging : public Singleton
 {
     Paths *pathManager = nullptr;
 
 public:
     Logging() = default;
+    ~Logging() override;
 
     virtual void initialize(Settings &settings, Paths &paths) override;
+    // writes all queued lines and closes the log files
+    virtual void save() override;
 
     void addMessage(const QString &channelName, MessagePtr message);
 
+    // the directory the logs of channelName are written to
+    QString channelDirectory(const QString &channelName);
+
 private:
+    struct PendingLine {
+        QString channelName;
+        LogRecord record;
+        bool structured;
+    };
+
+    void run();
+    void stop();
+    void write(const std::vector<PendingLine> &lines,
+               const QString &baseDirectory);
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::vector<PendingLine> pending_;
+    int pendingBytes_ = 0;
+    QString baseDirectory_;
+    bool stopping_ = false;
+    std::thread thread_;
+
+    // only used on the logging thread
     std::map<QString, std::unique_ptr<LoggingChannel>> loggingChannels_;
 };
 
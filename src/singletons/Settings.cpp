@@ -4,6 +4,7 @@
 #include "controllers/highlights/HighlightBlacklistUser.hpp"
 #include "controllers/highlights/HighlightPhrase.hpp"
 #include "controllers/ignores/IgnorePhrase.hpp"
+#include "controllers/ignores/IgnoreReplacer.hpp"
 #include "singletons/Paths.hpp"
 #include "singletons/Resources.hpp"
 #include "singletons/WindowManager.hpp"
@@ -25,6 +26,11 @@ ConcurrentSettings::ConcurrentSettings()
     , filterRecords(*new SignalVector<FilterRecordPtr>())
     , nicknames(*new SignalVector<Nickname>())
     , moderationActions(*new SignalVector<ModerationAction>)
+    , highlightedMessagesMatcher(
+          *new HighlightMatcherCache(this->highlightedMessages))
+    , highlightedUsersMatcher(
+          *new HighlightMatcherCache(this->highlightedUsers))
+    , ignoredMessagesReplacer(*new IgnoreReplacerCache(this->ignoredMessages))
 {
     persist(this->highlightedMessages, "/highlighting/highlights");
     persist(this->blacklistedUsers, "/highlighting/blacklist");
@@ -40,15 +46,7 @@ ConcurrentSettings::ConcurrentSettings()
 
 bool ConcurrentSettings::isHighlightedUser(const QString &username)
 {
-    auto items = this->highlightedUsers.readOnly();
-
-    for (const auto &highlightedUser : *items)
-    {
-        if (highlightedUser.isMatch(username))
-            return true;
-    }
-
-    return false;
+    return this->highlightedUsersMatcher.get()->isMatch(username);
 }
 
 bool ConcurrentSettings::isBlacklistedUser(const QString &username)
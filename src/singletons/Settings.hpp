@@ -8,6 +8,7 @@
 #include "common/SignalVector.hpp"
 #include "controllers/filters/FilterRecord.hpp"
 #include "controllers/highlights/HighlightBadge.hpp"
+#include "controllers/highlights/HighlightMatcher.hpp"
 #include "controllers/highlights/HighlightPhrase.hpp"
 #include "controllers/moderationactions/ModerationAction.hpp"
 #include "controllers/nicknames/Nickname.hpp"
@@ -22,6 +23,7 @@ namespace chatterino {
 class HighlightPhrase;
 class HighlightBlacklistUser;
 class IgnorePhrase;
+class IgnoreReplacerCache;
 class FilterRecord;
 class Nickname;
 
@@ -41,6 +43,12 @@ public:
     SignalVector<Nickname> &nicknames;
     SignalVector<ModerationAction> &moderationActions;
 
+    /// Rebuilt lazily after highlightedMessages/highlightedUsers changed
+    HighlightMatcherCache &highlightedMessagesMatcher;
+    HighlightMatcherCache &highlightedUsersMatcher;
+    /// Rebuilt lazily after ignoredMessages changed
+    IgnoreReplacerCache &ignoredMessagesReplacer;
+
     bool isHighlightedUser(const QString &username);
     bool isBlacklistedUser(const QString &username);
     bool isMutedChannel(const QString &channelName);
@@ -308,6 +316,8 @@ public:
     BoolSetting enableLogging = {"/logging/enabled", false};
 
     QStringSetting logPath = {"/logging/path", ""};
+    // see LogArchiveWriter
+    BoolSetting enableStructuredLogs = {"/logging/structured", false};
 
     QStringSetting pathHighlightSound = {"/highlighting/highlightSoundPath",
                                          ""};
@@ -375,6 +385,9 @@ public:
         "/misc/twitch/messageHistoryLimit",
         800,
     };
+    // see LocalMessageHistory
+    BoolSetting loadMessageHistoryFromLogs = {
+        "/misc/twitch/loadMessageHistoryFromLogs", false};
 
     IntSetting emotesTooltipPreview = {"/misc/emotesTooltipPreview", 1};
     BoolSetting openLinksIncognito = {"/misc/openLinksIncognito", 0};
@@ -387,6 +400,8 @@ public:
     BoolSetting informOnTabVisibilityToggle = {"/misc/askOnTabVisibilityToggle",
                                                true};
     BoolSetting lockNotebookLayout = {"/misc/lockNotebookLayout", false};
+    // memory used for the pixmaps messages are drawn into, in megabytes
+    IntSetting messageBufferBudget = {"/misc/messageBufferBudget", 256};
 
     /// Debug
     BoolSetting showUnhandledIrcMessages = {"/debug/showUnhandledIrcMessages",
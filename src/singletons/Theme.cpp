@@ -1,19 +1,23 @@
 
 #include "singletons/Theme.hpp"
 
-#include "Application.hpp"
 #include "singletons/Resources.hpp"
 
 #include <QColor>
 
+#include <cassert>
 #include <cmath>
 
 #define LOOKUP_COLOR_COUNT 360
 
 namespace chatterino {
 
+Theme *Theme::instance = nullptr;
+
 Theme::Theme()
 {
+    Theme::instance = this;
+
     this->update();
 
     this->themeName.connectSimple(
@@ -137,7 +141,11 @@ void Theme::normalizeColor(QColor &color)
 
 Theme *getTheme()
 {
-    return getApp()->themes;
+    // the message layout workers read the theme as well, so this can't use
+    // getApp() which asserts that it's called from the gui thread
+    assert(Theme::instance != nullptr);
+
+    return Theme::instance;
 }
 
 }  // namespace chatterino
@@ -18,6 +18,8 @@ class Theme final : public Singleton, public BaseTheme
 public:
     Theme();
 
+    static Theme *instance;
+
     /// SPLITS
     struct {
         QColor messageSeperator;
@@ -1,6 +1,7 @@
 #include "TooltipPreviewImage.hpp"
 
 #include "Application.hpp"
+#include "singletons/Emotes.hpp"
 #include "singletons/WindowManager.hpp"
 #include "widgets/TooltipWidget.hpp"
 
@@ -54,6 +55,12 @@ void TooltipPreviewImage::refreshTooltipWidgetPixmap()
     {
         if (auto pixmap = this->image_->pixmapOrLoad())
         {
+            // keeps the animation going while the tooltip is shown
+            if (this->image_->animated())
+            {
+                getApp()->emotes->gifTimer.keepRunning();
+            }
+
             if (this->imageWidth_ != 0 && this->imageHeight_)
             {
                 tooltipWidget->setImage(pixmap->scaled(this->imageWidth_,
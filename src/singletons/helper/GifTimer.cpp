@@ -22,10 +22,28 @@ void GIFTimer::initialize()
             qApp->activeWindow() == nullptr)
             return;
 
+        this->keepRunning_ = false;
+
         this->position_ += gifFrameLength;
         this->signal.invoke();
         getApp()->windows->repaintGifEmotes();
+
+        // no visible animations left
+        if (!this->keepRunning_)
+        {
+            this->timer.stop();
+        }
     });
 }
 
+void GIFTimer::keepRunning()
+{
+    this->keepRunning_ = true;
+
+    if (!this->timer.isActive() && getSettings()->animateEmotes)
+    {
+        this->timer.start();
+    }
+}
+
 }  // namespace chatterino
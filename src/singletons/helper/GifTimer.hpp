@@ -12,7 +12,13 @@ class GIFTimer
 public:
     void initialize();
 
+    /// Keeps the timer running for the next tick. Everything showing
+    /// animated images calls this when it is painted and on every tick, the
+    /// timer pauses after a tick in which nothing did.
+    void keepRunning();
+
     pajlada::Signals::NoArgSignal signal;
+    // Time in milliseconds all animations derive their current frame from
     long unsigned position()
     {
         return this->position_;
@@ -21,6 +27,7 @@ public:
 private:
     QTimer timer;
     long unsigned position_{};
+    bool keepRunning_{false};
 };
 
 }  // namespace chatterino
@@ -0,0 +1,544 @@
+#include "singletons/helper/LogArchive.hpp"
+
+#include "common/QLogging.hpp"
+
+#include <QDataStream>
+#include <QDir>
+
+#include <algorithm>
+
+namespace chatterino {
+
+namespace {
+
+    constexpr quint32 fileMagic = 0x43484c47;  // "CHLG"
+    // bump when the format of the blocks or records changes
+    constexpr quint32 formatVersion = 2;
+    constexpr qint64 fileHeaderSize = 8;
+    // compressed size, record count, time range and the number of login
+    // names, followed by the hashes of the login names
+    constexpr qint64 blockHeaderSize = 4 + 4 + 8 + 8 + 4;
+    constexpr qint64 userHashSize = 4;
+
+    // uncompressed bytes of records which are compressed together
+    constexpr int maxBlockBytes = 64 * 1024;
+    // pending records are written after this long even if the block is
+    // small, they are only lost if chatterino crashes before that
+    constexpr qint64 maxBlockAge = 30 * 1000;
+
+    const QString fileSuffix = ".clog";
+    const QString dateFormat = "yyyy-MM-dd";
+
+    struct BlockHeader {
+        quint32 compressedSize = 0;
+        quint32 recordCount = 0;
+        qint64 firstTime = 0;
+        qint64 lastTime = 0;
+        // hashes of the login names in the block, sorted
+        std::vector<quint32> users;
+    };
+
+    void initStream(QDataStream &stream)
+    {
+        stream.setVersion(QDataStream::Qt_5_6);
+    }
+
+    QByteArray writeHeader(const BlockHeader &header)
+    {
+        QByteArray bytes;
+        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        initStream(stream);
+
+        stream << header.compressedSize << header.recordCount
+               << header.firstTime << header.lastTime
+               << quint32(header.users.size());
+        for (auto hash : header.users)
+        {
+            stream << hash;
+        }
+
+        return bytes;
+    }
+
+    // Reads the fixed part of a block header, returns the number of login
+    // hashes following it
+    quint32 readHeader(const QByteArray &bytes, BlockHeader &header)
+    {
+        QDataStream stream(bytes);
+        initStream(stream);
+
+        quint32 userCount = 0;
+        stream >> header.compressedSize >> header.recordCount >>
+            header.firstTime >> header.lastTime >> userCount;
+
+        return userCount;
+    }
+
+    void readUsers(const QByteArray &bytes, BlockHeader &header)
+    {
+        QDataStream stream(bytes);
+        initStream(stream);
+
+        header.users.resize(size_t(bytes.size() / userHashSize));
+        for (auto &hash : header.users)
+        {
+            stream >> hash;
+        }
+    }
+
+    void writeRecord(QDataStream &stream, const LogRecord &record)
+    {
+        stream << qint64(record.time.toMSecsSinceEpoch()) << record.loginName
+               << record.displayName << quint32(record.flags)
+               << record.badges << record.ircLine << record.text;
+    }
+
+    LogRecord readRecord(QDataStream &stream)
+    {
+        LogRecord record;
+        qint64 time = 0;
+        quint32 flags = 0;
+
+        stream >> time >> record.loginName >> record.displayName >> flags >>
+            record.badges >> record.ircLine >> record.text;
+
+        record.time = QDateTime::fromMSecsSinceEpoch(time);
+        record.flags = flags;
+
+        return record;
+    }
+
+    // The hash of a login name in the block headers. It is stored on disk,
+    // so it can't depend on the Qt version like qHash.
+    quint32 userHash(const QString &loginName)
+    {
+        quint32 hash = 2166136261U;
+        for (auto c : loginName.toLower())
+        {
+            hash ^= c.unicode();
+            hash *= 16777619U;
+        }
+
+        return hash;
+    }
+
+    bool mayContainUser(const BlockHeader &header, const QString &loginName)
+    {
+        return std::binary_search(header.users.begin(), header.users.end(),
+                                  userHash(loginName));
+    }
+
+    bool checkFileHeader(QFile &file)
+    {
+        file.seek(0);
+
+        QDataStream stream(file.read(fileHeaderSize));
+        initStream(stream);
+
+        quint32 magic = 0;
+        quint32 version = 0;
+        stream >> magic >> version;
+
+        return stream.status() == QDataStream::Ok && magic == fileMagic &&
+               version == formatVersion;
+    }
+
+    // Calls callback with every complete block and the offset of its
+    // compressed records. Returns the end of the last complete block.
+    template <typename F>
+    qint64 forEachBlock(QFile &file, F &&callback)
+    {
+        auto size = file.size();
+        qint64 offset = fileHeaderSize;
+
+        while (offset + blockHeaderSize <= size)
+        {
+            if (!file.seek(offset))
+            {
+                break;
+            }
+
+            BlockHeader header;
+            auto userCount = readHeader(file.read(blockHeaderSize), header);
+            auto recordsOffset =
+                offset + blockHeaderSize + userCount * userHashSize;
+            auto end = recordsOffset + header.compressedSize;
+
+            if (header.compressedSize == 0 ||
+                userCount > header.recordCount || end > size)
+            {
+                break;
+            }
+
+            readUsers(file.read(userCount * userHashSize), header);
+
+            if (!callback(header, recordsOffset))
+            {
+                break;
+            }
+
+            offset = end;
+        }
+
+        return offset;
+    }
+
+    std::vector<LogRecord> readBlock(QFile &file, const BlockHeader &header,
+                                     qint64 offset)
+    {
+        std::vector<LogRecord> records;
+
+        if (!file.seek(offset))
+        {
+            return records;
+        }
+
+        QDataStream stream(qUncompress(file.read(header.compressedSize)));
+        initStream(stream);
+
+        records.reserve(header.recordCount);
+        for (quint32 i = 0; i < header.recordCount; i++)
+        {
+            auto record = readRecord(stream);
+            if (stream.status() != QDataStream::Ok)
+            {
+                break;
+            }
+
+            records.push_back(std::move(record));
+        }
+
+        return records;
+    }
+
+}  // namespace
+
+//
+// LogArchiveWriter
+//
+LogArchiveWriter::LogArchiveWriter(const QString &path)
+    : file_(path)
+{
+    if (!this->file_.open(QIODevice::ReadWrite))
+    {
+        qCWarning(chatterinoHelper)
+            << "Unable to open structured log" << path;
+        return;
+    }
+
+    if (this->file_.size() == 0)
+    {
+        QByteArray header;
+        QDataStream stream(&header, QIODevice::WriteOnly);
+        initStream(stream);
+        stream << fileMagic << formatVersion;
+
+        this->file_.write(header);
+    }
+    else if (checkFileHeader(this->file_))
+    {
+        // drop a block which was cut short
+        auto end = forEachBlock(this->file_, [](auto &&, auto) {
+            return true;
+        });
+        if (end < this->file_.size())
+        {
+            this->file_.resize(end);
+        }
+    }
+    else
+    {
+        qCWarning(chatterinoHelper)
+            << "Not appending to structured log of another format" << path;
+        this->file_.close();
+        return;
+    }
+
+    this->file_.seek(this->file_.size());
+}
+
+LogArchiveWriter::~LogArchiveWriter()
+{
+    this->flush(true);
+}
+
+bool LogArchiveWriter::isOpen() const
+{
+    return this->file_.isOpen();
+}
+
+void LogArchiveWriter::add(const LogRecord &record)
+{
+    if (!this->isOpen())
+    {
+        return;
+    }
+
+    auto time = record.time.toMSecsSinceEpoch();
+
+    if (this->pendingCount_ == 0)
+    {
+        this->firstTime_ = time;
+        this->lastTime_ = time;
+        this->pendingSince_ = QDateTime::currentMSecsSinceEpoch();
+    }
+    this->firstTime_ = std::min(this->firstTime_, time);
+    this->lastTime_ = std::max(this->lastTime_, time);
+
+    this->users_.push_back(userHash(record.loginName));
+
+    QDataStream stream(&this->pending_, QIODevice::Append);
+    initStream(stream);
+    writeRecord(stream, record);
+
+    this->pendingCount_++;
+}
+
+void LogArchiveWriter::flush(bool force)
+{
+    if (this->pendingCount_ == 0)
+    {
+        return;
+    }
+
+    if (force || this->pending_.size() >= maxBlockBytes ||
+        QDateTime::currentMSecsSinceEpoch() - this->pendingSince_ >=
+            maxBlockAge)
+    {
+        this->writeBlock();
+    }
+}
+
+void LogArchiveWriter::writeBlock()
+{
+    auto compressed = qCompress(this->pending_);
+
+    BlockHeader header;
+    header.compressedSize = quint32(compressed.size());
+    header.recordCount = this->pendingCount_;
+    header.firstTime = this->firstTime_;
+    header.lastTime = this->lastTime_;
+    header.users = std::move(this->users_);
+    std::sort(header.users.begin(), header.users.end());
+    header.users.erase(std::unique(header.users.begin(), header.users.end()),
+                       header.users.end());
+
+    this->file_.write(writeHeader(header) + compressed);
+    this->file_.flush();
+
+    this->pending_.clear();
+    this->pendingCount_ = 0;
+    this->users_.clear();
+}
+
+//
+// LogArchiveReader
+//
+LogArchiveReader::LogArchiveReader(QString directory, QString channelName)
+    : directory_(std::move(directory))
+    , channelName_(std::move(channelName))
+{
+}
+
+void LogArchiveReader::readRange(const QDateTime &from, const QDateTime &to,
+                                 const Callback &callback) const
+{
+    this->read(from, to, QString(), callback);
+}
+
+void LogArchiveReader::readUser(const QString &loginName,
+                                const QDateTime &from, const QDateTime &to,
+                                const Callback &callback) const
+{
+    if (loginName.isEmpty())
+    {
+        return;
+    }
+
+    this->read(from, to, loginName, callback);
+}
+
+std::vector<LogRecord> LogArchiveReader::readLast(
+    size_t count, const QDateTime &before) const
+{
+    auto end = before.toMSecsSinceEpoch();
+    auto lastDay = before.toLocalTime().date();
+    auto days = this->days();
+
+    // the records of each block, newest block first
+    std::vector<std::vector<LogRecord>> blocks;
+    size_t found = 0;
+
+    for (auto day = days.rbegin(); day != days.rend() && found < count; ++day)
+    {
+        if (*day > lastDay)
+        {
+            continue;
+        }
+
+        QFile file(filePath(this->directory_, this->channelName_, *day));
+        if (!file.open(QIODevice::ReadOnly) || !checkFileHeader(file))
+        {
+            continue;
+        }
+
+        std::vector<std::pair<BlockHeader, qint64>> headers;
+        forEachBlock(file, [&](const BlockHeader &header, qint64 offset) {
+            headers.emplace_back(header, offset);
+            return true;
+        });
+
+        for (auto it = headers.rbegin(); it != headers.rend() && found < count;
+             ++it)
+        {
+            if (it->first.firstTime >= end)
+            {
+                continue;
+            }
+
+            auto records = readBlock(file, it->first, it->second);
+            records.erase(std::remove_if(records.begin(), records.end(),
+                                         [end](const LogRecord &record) {
+                                             return record.time
+                                                        .toMSecsSinceEpoch() >=
+                                                    end;
+                                         }),
+                          records.end());
+
+            found += records.size();
+            blocks.push_back(std::move(records));
+        }
+    }
+
+    std::vector<LogRecord> result;
+    result.reserve(found);
+    for (auto it = blocks.rbegin(); it != blocks.rend(); ++it)
+    {
+        result.insert(result.end(), std::make_move_iterator(it->begin()),
+                      std::make_move_iterator(it->end()));
+    }
+
+    if (result.size() > count)
+    {
+        result.erase(result.begin(), result.end() - count);
+    }
+
+    return result;
+}
+
+std::vector<QDate> LogArchiveReader::days() const
+{
+    auto prefix = this->channelName_ + "-";
+    auto names = QDir(this->directory_)
+                     .entryList({prefix + "*" + fileSuffix}, QDir::Files,
+                                QDir::Name);
+
+    std::vector<QDate> days;
+    for (const auto &name : names)
+    {
+        auto date = QDate::fromString(
+            name.mid(prefix.size(), name.size() - prefix.size() -
+                                        fileSuffix.size()),
+            dateFormat);
+
+        if (date.isValid())
+        {
+            days.push_back(date);
+        }
+    }
+
+    std::sort(days.begin(), days.end());
+
+    return days;
+}
+
+QString LogArchiveReader::filePath(const QString &directory,
+                                   const QString &channelName,
+                                   const QDate &day)
+{
+    return directory + QDir::separator() + channelName + "-" +
+           day.toString(dateFormat) + fileSuffix;
+}
+
+bool LogArchiveReader::read(const QDateTime &from, const QDateTime &to,
+                            const QString &loginName,
+                            const Callback &callback) const
+{
+    // files are named after the local date their records were written at
+    auto firstDay = from.toLocalTime().date();
+    auto lastDay = to.toLocalTime().date();
+
+    for (const auto &day : this->days())
+    {
+        if (day < firstDay)
+        {
+            continue;
+        }
+        if (day > lastDay)
+        {
+            break;
+        }
+
+        if (!this->readFile(
+                filePath(this->directory_, this->channelName_, day),
+                from.toMSecsSinceEpoch(), to.toMSecsSinceEpoch(), loginName,
+                callback))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool LogArchiveReader::readFile(const QString &path, qint64 from, qint64 to,
+                                const QString &loginName,
+                                const Callback &callback) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || !checkFileHeader(file))
+    {
+        return true;
+    }
+
+    bool keepGoing = true;
+
+    forEachBlock(file, [&](const BlockHeader &header, qint64 offset) {
+        if (header.lastTime < from || header.firstTime >= to)
+        {
+            return true;
+        }
+
+        if (!loginName.isEmpty() && !mayContainUser(header, loginName))
+        {
+            return true;
+        }
+
+        for (const auto &record : readBlock(file, header, offset))
+        {
+            auto time = record.time.toMSecsSinceEpoch();
+            if (time < from || time >= to)
+            {
+                continue;
+            }
+
+            if (!loginName.isEmpty() &&
+                record.loginName.compare(loginName, Qt::CaseInsensitive) != 0)
+            {
+                continue;
+            }
+
+            if (!callback(record))
+            {
+                keepGoing = false;
+                return false;
+            }
+        }
+
+        return true;
+    });
+
+    return keepGoing;
+}
+
+}  // namespace chatterino
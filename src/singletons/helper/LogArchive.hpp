@@ -0,0 +1,109 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDate>
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <boost/noncopyable.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace chatterino {
+
+/// One message in a structured log
+struct LogRecord {
+    QDateTime time;
+    QString loginName;
+    QString displayName;
+    // MessageFlags
+    uint32_t flags = 0;
+    // "key/value" of every badge
+    QStringList badges;
+    // the IRC line the message was parsed from including its tags, empty for
+    // messages chatterino created itself
+    QByteArray ircLine;
+    // the same text as in the plain text logs
+    QString text;
+};
+
+/// The structured log of one channel and day.
+///
+/// A log file is a sequence of blocks. Each block holds a few hundred
+/// records compressed together. Its header contains the time range of
+/// those records and the sorted hashes of their login names. This lets a
+/// reader skip blocks without decompressing them.
+///
+/// Blocks are only appended. When a log file is opened again, a block that
+/// was cut short by a crash is removed.
+class LogArchiveWriter : boost::noncopyable
+{
+public:
+    explicit LogArchiveWriter(const QString &path);
+    ~LogArchiveWriter();
+
+    bool isOpen() const;
+
+    void add(const LogRecord &record);
+    /// Writes the pending records as a block once there are enough of them
+    /// or they have been pending for a while. force writes them right away.
+    void flush(bool force = false);
+
+private:
+    void writeBlock();
+
+    QFile file_;
+
+    QByteArray pending_;
+    uint32_t pendingCount_ = 0;
+    qint64 firstTime_ = 0;
+    qint64 lastTime_ = 0;
+    // hashes of the login names of the pending records
+    std::vector<quint32> users_;
+    // when the first pending record was added
+    qint64 pendingSince_ = 0;
+};
+
+/// Reads the structured logs of one channel, see LogArchiveWriter
+class LogArchiveReader
+{
+public:
+    using Callback = std::function<bool(const LogRecord &)>;
+
+    /// directory contains the log files of channelName
+    LogArchiveReader(QString directory, QString channelName);
+
+    /// Calls callback with every record from from (inclusive) to to
+    /// (exclusive) in order until it returns false
+    void readRange(const QDateTime &from, const QDateTime &to,
+                   const Callback &callback) const;
+    /// Same as readRange, but only with the records of loginName
+    void readUser(const QString &loginName, const QDateTime &from,
+                  const QDateTime &to, const Callback &callback) const;
+    /// The last count records older than before, in order. Only the blocks
+    /// at the end of the newest log files are decompressed.
+    std::vector<LogRecord> readLast(size_t count,
+                                    const QDateTime &before) const;
+
+    /// Days a log file exists for, in ascending order
+    std::vector<QDate> days() const;
+
+    /// The log file of channelName and day in directory
+    static QString filePath(const QString &directory,
+                            const QString &channelName, const QDate &day);
+
+private:
+    // returns false if callback asked to stop
+    bool readFile(const QString &path, qint64 from, qint64 to,
+                  const QString &loginName, const Callback &callback) const;
+    bool read(const QDateTime &from, const QDateTime &to,
+              const QString &loginName, const Callback &callback) const;
+
+    const QString directory_;
+    const QString channelName_;
+};
+
+}  // namespace chatterino
@@ -1,9 +1,6 @@
 #include "LoggingChannel.hpp"
 
-#include "Application.hpp"
 #include "common/QLogging.hpp"
-#include "singletons/Paths.hpp"
-#include "singletons/Settings.hpp"
 
 #include <QDir>
 
@@ -13,58 +10,82 @@ namespace chatterino {
 
 QByteArray endline("\n");
 
-LoggingChannel::LoggingChannel(const QString &_channelName)
+LoggingChannel::LoggingChannel(const QString &_channelName,
+                               const QString &_baseDirectory)
     : channelName(_channelName)
+    , baseDirectory(_baseDirectory)
+    , subDirectory(subDirectoryOf(_channelName))
 {
-    if (this->channelName.startsWith("/whispers"))
+}
+
+QString LoggingChannel::subDirectoryOf(const QString &channelName)
+{
+    QString subDirectory;
+
+    if (channelName.startsWith("/whispers"))
     {
-        this->subDirectory = "Whispers";
+        subDirectory = "Whispers";
     }
     else if (channelName.startsWith("/mentions"))
     {
-        this->subDirectory = "Mentions";
+        subDirectory = "Mentions";
     }
     else if (channelName.startsWith("/live"))
     {
-        this->subDirectory = "Live";
+        subDirectory = "Live";
     }
     else
     {
-        this->subDirectory =
+        subDirectory =
             QStringLiteral("Channels") + QDir::separator() + channelName;
     }
 
     // FOURTF: change this when adding more providers
-    this->subDirectory = "Twitch/" + this->subDirectory;
-
-    getSettings()->logPath.connect([this](const QString &logPath, auto) {
-        this->baseDirectory =
-            logPath.isEmpty() ? getPaths()->messageLogDirectory : logPath;
-        this->openLogFile();
-    });
+    return "Twitch/" + subDirectory;
 }
 
 LoggingChannel::~LoggingChannel()
 {
-    this->appendLine(this->generateClosingString());
-    this->fileHandle.close();
+    if (this->fileHandle.isOpen())
+    {
+        this->appendLine(this->generateClosingString());
+        this->flush();
+        this->fileHandle.close();
+    }
 }
 
-void LoggingChannel::openLogFile()
+void LoggingChannel::setBaseDirectory(const QString &directory)
+{
+    if (directory == this->baseDirectory)
+    {
+        return;
+    }
+
+    this->baseDirectory = directory;
+
+    // the file is opened with the first message otherwise
+    if (!this->dateString.isEmpty())
+    {
+        this->openLogFile(QDateTime::currentDateTime());
+    }
+}
+
+void LoggingChannel::openLogFile(const QDateTime &now)
 {
-    QDateTime now = QDateTime::currentDateTime();
     this->dateString = this->generateDateString(now);
 
     if (this->fileHandle.isOpen())
     {
-        this->fileHandle.flush();
+        // the buffered lines still belong to the previous file
+        this->flush();
         this->fileHandle.close();
     }
+    this->buffer.clear();
+    this->archive.reset();
 
     QString baseFileName = this->channelName + "-" + this->dateString + ".log";
 
-    QString directory =
-        this->baseDirectory + QDir::separator() + this->subDirectory;
+    QString directory = this->directory();
 
     if (!QDir().mkpath(directory))
     {
@@ -82,26 +103,55 @@ void LoggingChannel::openLogFile()
     this->appendLine(this->generateOpeningString(now));
 }
 
-void LoggingChannel::addMessage(MessagePtr message)
+void LoggingChannel::addMessage(const LogRecord &record, bool structured)
 {
-    QDateTime now = QDateTime::currentDateTime();
-
-    QString messageDateString = this->generateDateString(now);
-    if (messageDateString != this->dateString)
+    if (this->generateDateString(record.time) != this->dateString)
     {
-        this->dateString = messageDateString;
-        this->openLogFile();
+        this->openLogFile(record.time);
     }
 
     QString str;
     str.append('[');
-    str.append(now.toString("HH:mm:ss"));
+    str.append(record.time.toString("HH:mm:ss"));
     str.append("] ");
 
-    str.append(message->searchText);
+    str.append(record.text);
     str.append(endline);
 
     this->appendLine(str);
+
+    if (structured && this->fileHandle.isOpen())
+    {
+        if (!this->archive)
+        {
+            this->archive = std::make_unique<LogArchiveWriter>(
+                LogArchiveReader::filePath(
+                    this->directory(), this->channelName,
+                    QDate::fromString(this->dateString, "yyyy-MM-dd")));
+        }
+
+        this->archive->add(record);
+    }
+}
+
+void LoggingChannel::flush()
+{
+    if (this->archive)
+    {
+        this->archive->flush();
+    }
+
+    if (this->buffer.isEmpty())
+    {
+        return;
+    }
+
+    if (this->fileHandle.isOpen())
+    {
+        this->fileHandle.write(this->buffer);
+        this->fileHandle.flush();
+    }
+    this->buffer.clear();
 }
 
 QString LoggingChannel::generateOpeningString(const QDateTime &now) const
@@ -128,8 +178,7 @@ QString LoggingChannel::generateClosingString(const QDateTime &now) const
 
 void LoggingChannel::appendLine(const QString &line)
 {
-    this->fileHandle.write(line.toUtf8());
-    this->fileHandle.flush();
+    this->buffer.append(line.toUtf8());
 }
 
 QString LoggingChannel::generateDateString(const QDateTime &now)
@@ -137,4 +186,9 @@ QString LoggingChannel::generateDateString(const QDateTime &now)
     return now.toString("yyyy-MM-dd");
 }
 
+QString LoggingChannel::directory() const
+{
+    return this->baseDirectory + QDir::separator() + this->subDirectory;
+}
+
 }  // namespace chatterino
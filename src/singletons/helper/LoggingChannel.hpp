@@ -1,7 +1,8 @@
 #pragma once
 
-#include "messages/Message.hpp"
+#include "singletons/helper/LogArchive.hpp"
 
+#include <QByteArray>
 #include <QDateTime>
 #include <QFile>
 #include <QString>
@@ -13,16 +14,24 @@ namespace chatterino {
 
 class Logging;
 
+/// The log file of one channel. Only used on the logging thread, see
+/// Logging.
 class LoggingChannel : boost::noncopyable
 {
-    explicit LoggingChannel(const QString &_channelName);
+    LoggingChannel(const QString &_channelName, const QString &_baseDirectory);
 
 public:
     ~LoggingChannel();
-    void addMessage(MessagePtr message);
+
+    // Buffers a line, the log file is switched when the date changes. The
+    // record is also added to the structured log if structured is set.
+    void addMessage(const LogRecord &record, bool structured);
+    // Writes the buffered lines to the log file
+    void flush();
 
 private:
-    void openLogFile();
+    void setBaseDirectory(const QString &directory);
+    void openLogFile(const QDateTime &now);
 
     QString generateOpeningString(
         const QDateTime &now = QDateTime::currentDateTime()) const;
@@ -32,12 +41,20 @@ private:
     void appendLine(const QString &line);
 
     QString generateDateString(const QDateTime &now);
+    QString directory() const;
+    // the directory the logs of channelName are in, relative to the base
+    // directory
+    static QString subDirectoryOf(const QString &channelName);
 
     const QString channelName;
     QString baseDirectory;
     QString subDirectory;
 
     QFile fileHandle;
+    // lines which haven't been written to fileHandle yet
+    QByteArray buffer;
+    // opened with the first structured record of the day
+    std::unique_ptr<LogArchiveWriter> archive;
 
     QString dateString;
 
@@ -0,0 +1,94 @@
+#include "util/AhoCorasick.hpp"
+
+#include <algorithm>
+#include <deque>
+
+namespace chatterino {
+
+void AhoCorasick::add(const QString &pattern, size_t id)
+{
+    int node = 0;
+
+    for (auto c : pattern)
+    {
+        auto code = char16_t(c.unicode());
+        auto child = this->find(node, code);
+
+        if (child == -1)
+        {
+            child = int(this->nodes_.size());
+            this->nodes_.emplace_back();
+
+            auto &next = this->nodes_[node].next;
+            next.insert(std::upper_bound(next.begin(), next.end(),
+                                         std::make_pair(code, 0)),
+                        {code, child});
+        }
+
+        node = child;
+    }
+
+    this->nodes_[node].outputs.push_back(id);
+}
+
+void AhoCorasick::build()
+{
+    std::deque<int> queue;
+
+    for (auto &edge : this->nodes_[0].next)
+    {
+        this->nodes_[edge.second].fail = 0;
+        queue.push_back(edge.second);
+    }
+
+    while (!queue.empty())
+    {
+        auto node = queue.front();
+        queue.pop_front();
+
+        for (auto &edge : this->nodes_[node].next)
+        {
+            auto child = edge.second;
+
+            auto fail = this->nodes_[node].fail;
+            while (fail != 0 && this->find(fail, edge.first) == -1)
+            {
+                fail = this->nodes_[fail].fail;
+            }
+
+            auto target = this->find(fail, edge.first);
+            this->nodes_[child].fail =
+                target != -1 && target != child ? target : 0;
+
+            auto &failNode = this->nodes_[this->nodes_[child].fail];
+            this->nodes_[child].outputLink = failNode.outputs.empty()
+                                                 ? failNode.outputLink
+                                                 : this->nodes_[child].fail;
+
+            queue.push_back(child);
+        }
+    }
+}
+
+bool AhoCorasick::empty() const
+{
+    return this->nodes_.size() == 1;
+}
+
+int AhoCorasick::find(int node, char16_t c) const
+{
+    auto &next = this->nodes_[node].next;
+    auto it = std::lower_bound(
+        next.begin(), next.end(), c,
+        [](const std::pair<char16_t, int> &edge, char16_t value) {
+            return edge.first < value;
+        });
+
+    if (it == next.end() || it->first != c)
+    {
+        return -1;
+    }
+    return it->second;
+}
+
+}  // namespace chatterino
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QString>
+
+#include <utility>
+#include <vector>
+
+namespace chatterino {
+
+/// Aho-Corasick automaton over UTF-16 code units. Finds all occurrences of
+/// any number of patterns in a single scan over the text.
+///
+/// Add all patterns, then call build() once before searching. A built
+/// automaton can be searched from multiple threads.
+class AhoCorasick
+{
+public:
+    /// Adds a non-empty pattern which is reported as id when found
+    void add(const QString &pattern, size_t id);
+    void build();
+    bool empty() const;
+
+    /// Calls onMatch(end, id) for every occurrence of a pattern in text,
+    /// including overlapping ones, end being the index of its last code unit.
+    /// Occurrences are reported in increasing order of end.
+    template <typename OnMatch>
+    void search(const QString &text, OnMatch &&onMatch) const
+    {
+        int node = 0;
+
+        for (int i = 0; i < text.size(); i++)
+        {
+            auto code = char16_t(text[i].unicode());
+
+            int next;
+            while ((next = this->find(node, code)) == -1 && node != 0)
+            {
+                node = this->nodes_[node].fail;
+            }
+            node = next == -1 ? 0 : next;
+
+            for (int output = this->nodes_[node].outputs.empty()
+                                  ? this->nodes_[node].outputLink
+                                  : node;
+                 output != -1; output = this->nodes_[output].outputLink)
+            {
+                for (auto id : this->nodes_[output].outputs)
+                {
+                    onMatch(i, id);
+                }
+            }
+        }
+    }
+
+private:
+    struct Node {
+        // sorted by code unit
+        std::vector<std::pair<char16_t, int>> next;
+        int fail = 0;
+        // closest node on the fail chain which has outputs
+        int outputLink = -1;
+        std::vector<size_t> outputs;
+    };
+
+    int find(int node, char16_t c) const;
+
+    std::vector<Node> nodes_{Node{}};
+};
+
+}  // namespace chatterino
@@ -89,15 +89,13 @@ namespace {
 
     ChannelPtr filterMessages(const QString &userName, ChannelPtr channel)
     {
-        LimitedQueueSnapshot<MessagePtr> snapshot =
-            channel->getMessageSnapshot();
-
         ChannelPtr channelPtr(
             new Channel(channel->getName(), Channel::Type::None));
 
-        for (size_t i = 0; i < snapshot.size(); i++)
+        // the channel's user index gives us a superset of the messages we
+        // want, checkMessageUserName does the exact filtering
+        for (const auto &message : channel->findUserMessages(userName))
         {
-            MessagePtr message = snapshot[i];
             if (checkMessageUserName(userName, message))
             {
                 channelPtr->addMessage(message);
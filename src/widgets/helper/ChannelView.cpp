@@ -7,6 +7,7 @@
 #include <QGraphicsBlurEffect>
 #include <QMessageBox>
 #include <QPainter>
+#include <QPointer>
 #include <QScreen>
 #include <algorithm>
 #include <chrono>
@@ -30,6 +31,7 @@
 #include "providers/LinkResolver.hpp"
 #include "providers/twitch/TwitchChannel.hpp"
 #include "providers/twitch/TwitchIrcServer.hpp"
+#include "singletons/Emotes.hpp"
 #include "singletons/Resources.hpp"
 #include "singletons/Settings.hpp"
 #include "singletons/Theme.hpp"
@@ -198,7 +200,7 @@ void ChannelView::initializeSignals()
 
     this->signalHolder_.managedConnect(getApp()->windows->gifRepaintRequested,
                                        [&] {
-                                           this->queueUpdate();
+                                           this->updateAnimatedImages();
                                        });
 
     this->signalHolder_.managedConnect(
@@ -386,11 +388,19 @@ void ChannelView::performLayout(bool causedByScrollbar)
     this->showingLatestMessages_ =
         this->scrollBar_->isAtBottom() || !this->scrollBar_->isVisible();
 
+    std::vector<MessageLayoutWorker::Job> jobs;
+
     /// Layout visible messages
-    this->layoutVisibleMessages(messages);
+    this->layoutVisibleMessages(messages, jobs);
 
     /// Update scrollbar
-    this->updateScrollbar(messages, causedByScrollbar);
+    this->updateScrollbar(messages, jobs, causedByScrollbar);
+
+    /// Relayout outdated messages in the background
+    if (!jobs.empty())
+    {
+        this->runLayoutJobs(std::move(jobs));
+    }
 
     this->goToBottom_->setVisible(this->enableScrollingToBottom_ &&
                                   this->scrollBar_->isVisible() &&
@@ -398,7 +408,8 @@ void ChannelView::performLayout(bool causedByScrollbar)
 }
 
 void ChannelView::layoutVisibleMessages(
-    LimitedQueueSnapshot<MessageLayoutPtr> &messages)
+    LimitedQueueSnapshot<MessageLayoutPtr> &messages,
+    std::vector<MessageLayoutWorker::Job> &jobs)
 {
     const auto start = size_t(this->scrollBar_->getCurrentValue());
     const auto layoutWidth = this->getLayoutWidth();
@@ -415,7 +426,7 @@ void ChannelView::layoutVisibleMessages(
             auto message = messages[i];
 
             redrawRequired |=
-                message->layout(layoutWidth, this->scale(), flags);
+                this->layoutMessage(message, layoutWidth, flags, jobs);
 
             y += message->getHeight();
         }
@@ -425,8 +436,49 @@ void ChannelView::layoutVisibleMessages(
         this->queueUpdate();
 }
 
+// Returns true if the layout of the message changed right away. Messages that
+// have been laid out before keep their current layout until the new one has
+// been built by the layout workers.
+bool ChannelView::layoutMessage(const MessageLayoutPtr &message,
+                                int layoutWidth, MessageElementFlags flags,
+                                std::vector<MessageLayoutWorker::Job> &jobs)
+{
+    if (!message->hasLayout())
+    {
+        return message->layout(layoutWidth, this->scale(),
+                               this->devicePixelRatioF(), flags);
+    }
+
+    if (auto request = message->requestLayout(
+            layoutWidth, this->scale(), this->devicePixelRatioF(), flags))
+    {
+        // another view might already show the message with the same layout
+        if (message->applyCachedLayout(*request))
+        {
+            return true;
+        }
+
+        jobs.push_back({message, std::move(*request)});
+    }
+
+    return false;
+}
+
+void ChannelView::runLayoutJobs(std::vector<MessageLayoutWorker::Job> jobs)
+{
+    MessageLayoutWorker::instance().run(
+        std::move(jobs), [weak = QPointer<ChannelView>(this)] {
+            if (weak)
+            {
+                weak->queueLayout();
+                weak->queueUpdate();
+            }
+        });
+}
+
 void ChannelView::updateScrollbar(
-    LimitedQueueSnapshot<MessageLayoutPtr> &messages, bool causedByScrollbar)
+    LimitedQueueSnapshot<MessageLayoutPtr> &messages,
+    std::vector<MessageLayoutWorker::Job> &jobs, bool causedByScrollbar)
 {
     if (messages.size() == 0)
     {
@@ -443,9 +495,9 @@ void ChannelView::updateScrollbar(
     // convert i to int since it checks >= 0
     for (auto i = int(messages.size()) - 1; i >= 0; i--)
     {
-        auto *message = messages[i].get();
+        const auto &message = messages[i];
 
-        message->layout(layoutWidth, this->scale(), flags);
+        this->layoutMessage(message, layoutWidth, flags, jobs);
 
         h -= message->getHeight();
 
@@ -1030,7 +1082,7 @@ MessageElementFlags ChannelView::getFlags() const
     return flags;
 }
 
-void ChannelView::paintEvent(QPaintEvent * /*event*/)
+void ChannelView::paintEvent(QPaintEvent *event)
 {
     //    BenchmarkGuard benchmark("paint");
 
@@ -1039,7 +1091,7 @@ void ChannelView::paintEvent(QPaintEvent * /*event*/)
     painter.fillRect(rect(), this->theme->splits.background);
 
     // draw messages
-    this->drawMessages(painter);
+    this->drawMessages(painter, event->region());
 
     // draw paused sign
     if (this->paused())
@@ -1053,10 +1105,12 @@ void ChannelView::paintEvent(QPaintEvent * /*event*/)
 
 // if overlays is false then it draws the message, if true then it draws things
 // such as the grey overlay when a message is disabled
-void ChannelView::drawMessages(QPainter &painter)
+void ChannelView::drawMessages(QPainter &painter, const QRegion &region)
 {
     auto messagesSnapshot = this->getMessagesSnapshot();
 
+    this->animatedImages_.clear();
+
     size_t start = size_t(this->scrollBar_->getCurrentValue());
 
     if (start >= messagesSnapshot.size())
@@ -1083,8 +1137,14 @@ void ChannelView::drawMessages(QPainter &painter)
             isLastMessage = this->lastReadMessage_.get() == layout;
         }
 
-        layout->paint(painter, DRAW_WIDTH, y, i, this->selection_,
-                      isLastMessage, windowFocused, isMentions);
+        // e.g. only an animated image changed, see updateAnimatedImages
+        if (region.intersects(QRect(0, y, this->width(), layout->getHeight())))
+        {
+            layout->paint(painter, DRAW_WIDTH, y, i, this->selection_,
+                          isLastMessage, windowFocused, isMentions);
+        }
+
+        layout->addAnimatedImages(this->animatedImages_, y);
 
         y += layout->getHeight();
 
@@ -1095,6 +1155,11 @@ void ChannelView::drawMessages(QPainter &painter)
         }
     }
 
+    if (!this->animatedImages_.empty())
+    {
+        getApp()->emotes->gifTimer.keepRunning();
+    }
+
     if (end == nullptr)
     {
         return;
@@ -1133,6 +1198,30 @@ void ChannelView::drawMessages(QPainter &painter)
     }
 }
 
+void ChannelView::updateAnimatedImages()
+{
+    if (!this->isVisible() || this->animatedImages_.empty())
+    {
+        return;
+    }
+
+    getApp()->emotes->gifTimer.keepRunning();
+
+    QRegion region;
+    for (const auto &[image, rect] : this->animatedImages_)
+    {
+        if (image->frameChanged())
+        {
+            region += rect;
+        }
+    }
+
+    if (!region.isEmpty())
+    {
+        this->update(region);
+    }
+}
+
 void ChannelView::wheelEvent(QWheelEvent *event)
 {
     if (!event->angleDelta().y())
@@ -1182,8 +1271,9 @@ void ChannelView::wheelEvent(QWheelEvent *event)
                 }
                 else
                 {
-                    snapshot[i - 1]->layout(this->getLayoutWidth(),
-                                            this->scale(), this->getFlags());
+                    snapshot[i - 1]->layout(
+                        this->getLayoutWidth(), this->scale(),
+                        this->devicePixelRatioF(), this->getFlags());
                     scrollFactor = 1;
                     currentScrollLeft = snapshot[i - 1]->getHeight();
                 }
@@ -1216,8 +1306,9 @@ void ChannelView::wheelEvent(QWheelEvent *event)
                 }
                 else
                 {
-                    snapshot[i + 1]->layout(this->getLayoutWidth(),
-                                            this->scale(), this->getFlags());
+                    snapshot[i + 1]->layout(
+                        this->getLayoutWidth(), this->scale(),
+                        this->devicePixelRatioF(), this->getFlags());
 
                     scrollFactor = 1;
                     currentScrollLeft = snapshot[i + 1]->getHeight();
@@ -15,6 +15,7 @@
 #include "messages/LimitedQueue.hpp"
 #include "messages/LimitedQueueSnapshot.hpp"
 #include "messages/Selection.hpp"
+#include "messages/layouts/MessageLayoutWorker.hpp"
 #include "widgets/BaseWidget.hpp"
 
 namespace chatterino {
@@ -152,11 +153,20 @@ private:
 
     void performLayout(bool causedByScollbar = false);
     void layoutVisibleMessages(
-        LimitedQueueSnapshot<MessageLayoutPtr> &messages);
+        LimitedQueueSnapshot<MessageLayoutPtr> &messages,
+        std::vector<MessageLayoutWorker::Job> &jobs);
     void updateScrollbar(LimitedQueueSnapshot<MessageLayoutPtr> &messages,
+                         std::vector<MessageLayoutWorker::Job> &jobs,
                          bool causedByScrollbar);
-
-    void drawMessages(QPainter &painter);
+    bool layoutMessage(const MessageLayoutPtr &message, int layoutWidth,
+                       MessageElementFlags flags,
+                       std::vector<MessageLayoutWorker::Job> &jobs);
+    void runLayoutJobs(std::vector<MessageLayoutWorker::Job> jobs);
+
+    // only messages intersecting region are painted
+    void drawMessages(QPainter &painter, const QRegion &region);
+    // repaints the animated images which moved to another frame
+    void updateAnimatedImages();
     void setSelection(const SelectionItem &start, const SelectionItem &end);
     MessageElementFlags getFlags() const;
     void selectWholeMessage(MessageLayout *layout, int &messageIndex);
@@ -267,6 +277,8 @@ private:
     pajlada::Signals::SignalHolder channelConnections_;
 
     std::unordered_set<std::shared_ptr<MessageLayout>> messagesOnScreen_;
+    // animated images on screen and where they were painted last
+    std::vector<std::pair<ImagePtr, QRect>> animatedImages_;
 
     static constexpr int leftPadding = 8;
     static constexpr int scrollbarPadding = 8;
@@ -5,6 +5,7 @@
 #include <QScrollArea>
 
 #include "Application.hpp"
+#include "common/NetworkCache.hpp"
 #include "common/Version.hpp"
 #include "singletons/Fonts.hpp"
 #include "singletons/NativeMessaging.hpp"
@@ -522,9 +523,7 @@ void GeneralPage::initLayout(GeneralPageView &layout)
 
             if (reply == QMessageBox::Yes)
             {
-                auto cacheDir = QDir(getPaths()->cacheDirectory());
-                cacheDir.removeRecursively();
-                cacheDir.mkdir(getPaths()->cacheDirectory());
+                NetworkCache::instance().clear();
             }
         }));
         box->addStretch(1);
@@ -681,6 +680,11 @@ void GeneralPage::initLayout(GeneralPageView &layout)
     // TODO: Change phrasing to use better english once we can tag settings, right now it's kept as history instead of historical so that the setting shows up when the user searches for history
     layout.addIntInput("Max number of history messages to load on connect",
                        s.twitchMessageHistoryLimit, 10, 800, 10);
+    layout.addCheckbox(
+        "Load message history from compressed logs when there are any",
+        s.loadMessageHistoryFromLogs);
+    layout.addIntInput("Memory for drawing messages (MB)",
+                       s.messageBufferBudget, 32, 4096, 32);
 
     layout.addCheckbox("Enable experimental IRC support (requires restart)",
                        s.enableExperimentalIrc);
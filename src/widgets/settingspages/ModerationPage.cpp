@@ -74,6 +74,9 @@ ModerationPage::ModerationPage()
     {
         logs.append(this->createCheckBox("Enable logging",
                                          getSettings()->enableLogging));
+        logs.append(this->createCheckBox(
+            "Also keep compressed logs with message details",
+            getSettings()->enableStructuredLogs));
         auto logsPathLabel = logs.emplace<QLabel>();
 
         // Logs (copied from LoggingMananger)
@@ -0,0 +1,111 @@
+#include "controllers/filters/parser/FilterParser.hpp"
+
+#include "messages/Message.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace chatterino;
+using namespace filterparser;
+
+namespace {
+
+MessagePtr makeMessage()
+{
+    auto message = std::make_shared<Message>();
+    message->displayName = "SomeUser";
+    message->channelName = "somechannel";
+    message->messageText = "hello there, cheer100 here";
+    message->usernameColor = QColor("#ff0000");
+    message->badges.emplace_back("moderator", "1");
+    message->badges.emplace_back("subscriber", "12");
+    message->badgeInfos.emplace("subscriber", "14");
+    message->flags.set(MessageFlag::Highlighted);
+    return message;
+}
+
+bool run(const QString &filter, const MessagePtr &message)
+{
+    FilterParser parser(filter);
+    EXPECT_TRUE(parser.valid()) << filter.toStdString();
+
+    return parser.execute(FilterContext(message, nullptr));
+}
+
+}  // namespace
+
+TEST(FilterParser, Identifiers)
+{
+    auto message = makeMessage();
+
+    EXPECT_TRUE(run("author.name == \"someuser\"", message));
+    EXPECT_TRUE(run("author.badges contains \"Moderator\"", message));
+    EXPECT_FALSE(run("author.badges contains \"vip\"", message));
+    EXPECT_TRUE(run("author.subbed && author.sub_length == 14", message));
+    EXPECT_FALSE(run("author.no_color", message));
+    EXPECT_TRUE(run("channel.name startswith \"some\"", message));
+    EXPECT_FALSE(run("channel.live", message));
+    EXPECT_TRUE(run("flags.highlighted && !flags.whisper", message));
+    EXPECT_TRUE(run("message.length > 10 && message.length <= 26", message));
+    EXPECT_TRUE(run("message.content contains \"THERE\"", message));
+    EXPECT_TRUE(run("message.content match r\"cheer\\d+\"", message));
+}
+
+TEST(FilterParser, Operators)
+{
+    auto message = makeMessage();
+
+    EXPECT_TRUE(run("(1 + 2) * 3 == 9", message));
+    EXPECT_TRUE(run("7 % 4 == 3 && 7 / 2 == 3", message));
+    EXPECT_TRUE(run("\"cheer\" + 100 == \"CHEER100\"", message));
+    EXPECT_TRUE(run("author.name == \"foo\" || message.length > 0", message));
+    EXPECT_FALSE(run("author.name == \"foo\" || message.length > 100",
+                     message));
+
+    // both sides of && and || have to be convertible to bool
+    EXPECT_FALSE(run("flags.highlighted || author.badges", message));
+    EXPECT_FALSE(run("author.badges && flags.highlighted", message));
+    EXPECT_TRUE(run("flags.highlighted || message.length", message));
+}
+
+TEST(FilterParser, Lists)
+{
+    auto message = makeMessage();
+
+    EXPECT_TRUE(run("{\"a\", \"b\"} contains \"B\"", message));
+    EXPECT_TRUE(run("{author.name, channel.name} contains \"someuser\"",
+                    message));
+    EXPECT_TRUE(
+        run("(message.content match {r\"cheer(\\d+)\", 1}) == \"100\"",
+            message));
+    EXPECT_FALSE(run("message.content match {r\"bits(\\d+)\", 1}", message));
+    EXPECT_TRUE(run("{1, 2} contains 2", message));
+}
+
+TEST(FilterParser, Cacheable)
+{
+    EXPECT_TRUE(FilterParser("author.subbed").isCacheable());
+    EXPECT_TRUE(FilterParser("channel.name == \"forsen\"").isCacheable());
+    EXPECT_FALSE(FilterParser("channel.live || author.subbed").isCacheable());
+    EXPECT_FALSE(FilterParser("!channel.watching").isCacheable());
+}
+
+TEST(FilterParser, ResultMemo)
+{
+    FilterResultMemo memo;
+
+    EXPECT_EQ(memo.get(1), boost::none);
+
+    memo.set(1, true);
+    memo.set(2, false);
+    EXPECT_EQ(memo.get(1), boost::optional<bool>(true));
+    EXPECT_EQ(memo.get(2), boost::optional<bool>(false));
+
+    // only the newest results are kept
+    for (uint64_t key = 3; key < 10; key++)
+    {
+        memo.set(key, true);
+    }
+    EXPECT_EQ(memo.get(1), boost::none);
+    EXPECT_EQ(memo.get(2), boost::optional<bool>(false));
+    EXPECT_EQ(memo.get(9), boost::optional<bool>(true));
+}
@@ -0,0 +1,136 @@
+#include "controllers/highlights/HighlightMatcher.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace chatterino;
+
+namespace {
+
+HighlightPhrase buildHighlightPhrase(const QString &phrase, bool isRegex,
+                                     bool isCaseSensitive)
+{
+    return HighlightPhrase(phrase,           // pattern
+                           false,            // showInMentions
+                           false,            // hasAlert
+                           false,            // hasSound
+                           isRegex,          // isRegex
+                           isCaseSensitive,  // isCaseSensitive
+                           "",               // soundURL
+                           QColor()          // color
+    );
+}
+
+// The indices of all phrases matching subject, checked one by one
+std::vector<size_t> matchEach(const std::vector<HighlightPhrase> &phrases,
+                              const QString &subject)
+{
+    std::vector<size_t> matches;
+    for (size_t i = 0; i < phrases.size(); i++)
+    {
+        if (phrases[i].isMatch(subject))
+        {
+            matches.push_back(i);
+        }
+    }
+    return matches;
+}
+
+const std::vector<QString> SUBJECTS = {
+    "",
+    "test",
+    "TEst",
+    "foo tEst",
+    "foo teSt bar",
+    "!teSt",
+    "test!",
+    "testbar",
+    "footest",
+    "foo!test bar",
+    "!testbar",
+    "test!bar",
+    "xd tesT!",
+    "testtest test",
+    "ÄÖÜ äöü ß",
+    "ΣΊΣΥΦΟΣ σίσυφος",
+    "emoji 😂 test 😂",
+    "_test_ a_test b-test",
+    "hello world foo bar",
+    "ababab abab",
+    "user 12345 posted 67890",
+    "tab\ttest\tline",
+};
+
+}  // namespace
+
+TEST(HighlightMatcher, MatchesLikeIsMatch)
+{
+    std::vector<HighlightPhrase> phrases = {
+        buildHighlightPhrase("test", false, false),
+        buildHighlightPhrase("TEST", false, true),
+        buildHighlightPhrase("!test", false, false),
+        buildHighlightPhrase("test!", false, true),
+        buildHighlightPhrase("st", false, false),
+        buildHighlightPhrase("abab", false, false),
+        buildHighlightPhrase("bab", false, false),
+        buildHighlightPhrase("äöü", false, false),
+        buildHighlightPhrase("σίσυφος", false, false),
+        buildHighlightPhrase("😂", false, false),
+        buildHighlightPhrase("_test_", false, false),
+        buildHighlightPhrase("", false, false),
+        buildHighlightPhrase("test", false, false),
+        buildHighlightPhrase("[0-9]{5}", true, false),
+        buildHighlightPhrase("^foo", true, false),
+        buildHighlightPhrase("BAR$", true, true),
+        buildHighlightPhrase("bar$", true, false),
+        buildHighlightPhrase("(a)(b)\\1\\2", true, false),
+        buildHighlightPhrase("(?<word>te)st", true, false),
+        buildHighlightPhrase("(?x) hello \\s world # comment", true, false),
+        buildHighlightPhrase("^$", true, false),
+        buildHighlightPhrase("(", true, false),
+        buildHighlightPhrase("(?<=foo )bar", true, false),
+    };
+
+    HighlightMatcher matcher(phrases);
+
+    for (const auto &subject : SUBJECTS)
+    {
+        EXPECT_EQ(matcher.match(subject), matchEach(phrases, subject))
+            << "subject: " << subject.toStdString();
+        EXPECT_EQ(matcher.isMatch(subject),
+                  !matchEach(phrases, subject).empty())
+            << "subject: " << subject.toStdString();
+    }
+}
+
+TEST(HighlightMatcher, OverlappingPhrases)
+{
+    std::vector<HighlightPhrase> phrases = {
+        buildHighlightPhrase("he", false, false),
+        buildHighlightPhrase("she", false, false),
+        buildHighlightPhrase("his", false, false),
+        buildHighlightPhrase("hers", false, false),
+    };
+
+    HighlightMatcher matcher(phrases);
+
+    EXPECT_EQ(matcher.match("ushers"), (std::vector<size_t>{}));
+    EXPECT_EQ(matcher.match("she said hers"), (std::vector<size_t>{1, 3}));
+    EXPECT_EQ(matcher.match("he his she"), (std::vector<size_t>{0, 1, 2}));
+}
+
+TEST(HighlightMatcher, NamedGroups)
+{
+    // named groups would clash once combined, so these are checked one by
+    // one
+    std::vector<HighlightPhrase> phrases = {
+        buildHighlightPhrase("(?<a>foo)", true, false),
+        buildHighlightPhrase("(?<a>bar)", true, false),
+        buildHighlightPhrase("baz", true, true),
+    };
+
+    HighlightMatcher matcher(phrases);
+
+    EXPECT_EQ(matcher.match("foo bar"), (std::vector<size_t>{0, 1}));
+    EXPECT_EQ(matcher.match("BAZ baz"), (std::vector<size_t>{2}));
+    EXPECT_TRUE(matcher.match("BAZ").empty());
+}
@@ -0,0 +1,107 @@
+#include "controllers/ignores/IgnoreReplacer.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace chatterino;
+
+namespace {
+
+IgnorePhrase buildIgnorePhrase(const QString &pattern, bool isRegex,
+                               const QString &replace, bool isCaseSensitive,
+                               bool isBlock = false)
+{
+    return IgnorePhrase(pattern, isRegex, isBlock, replace, isCaseSensitive);
+}
+
+// Applies the replacements the way TwitchMessageBuilder does
+QString apply(const IgnoreReplacer &replacer, const QString &message)
+{
+    QString result;
+    int from = 0;
+    for (const auto &replacement : replacer.findReplacements(message))
+    {
+        result += message.midRef(from, replacement.start - from);
+        result += replacement.replacement;
+        from = replacement.start + replacement.length;
+    }
+    result += message.midRef(from);
+    return result;
+}
+
+}  // namespace
+
+TEST(IgnoreReplacer, Plain)
+{
+    IgnoreReplacer replacer({
+        buildIgnorePhrase("foo", false, "***", false),
+        buildIgnorePhrase("Bar", false, "baz", true),
+    });
+
+    EXPECT_EQ(apply(replacer, "foo FOO bar Bar"), "*** *** bar baz");
+    EXPECT_EQ(apply(replacer, "foofoo"), "******");
+    EXPECT_EQ(apply(replacer, "nothing here"), "nothing here");
+}
+
+TEST(IgnoreReplacer, Regex)
+{
+    IgnoreReplacer replacer({
+        buildIgnorePhrase("(\\w+)@example\\.com", true, "\\1@...", false),
+        buildIgnorePhrase("z*", true, "y", true),
+    });
+
+    EXPECT_EQ(apply(replacer, "mail me: Me@EXAMPLE.com"), "mail me: Me@...");
+    // empty matches are skipped
+    EXPECT_EQ(apply(replacer, "abc"), "abc");
+}
+
+TEST(IgnoreReplacer, Overlaps)
+{
+    IgnoreReplacer replacer({
+        buildIgnorePhrase("bcd", false, "1", true),
+        buildIgnorePhrase("abc", false, "2", true),
+        buildIgnorePhrase("cde", false, "3", true),
+        buildIgnorePhrase("aa", false, "4", true),
+    });
+
+    // earlier phrases win over later ones
+    EXPECT_EQ(apply(replacer, "abcde"), "a1e");
+    // a phrase doesn't overlap itself
+    EXPECT_EQ(apply(replacer, "aaa"), "4a");
+
+    auto replacements = replacer.findReplacements("abc bcd");
+    ASSERT_EQ(replacements.size(), 2U);
+    EXPECT_EQ(replacements[0].start, 0);
+    EXPECT_EQ(replacements[0].phrase, 1U);
+    EXPECT_EQ(replacements[1].start, 4);
+    EXPECT_EQ(replacements[1].phrase, 0U);
+}
+
+TEST(IgnoreReplacer, SkipsBlocksAndInvalid)
+{
+    IgnoreReplacer replacer({
+        buildIgnorePhrase("foo", false, "bar", false, true),
+        buildIgnorePhrase("", false, "bar", false),
+        buildIgnorePhrase("(", true, "bar", false),
+    });
+
+    EXPECT_TRUE(replacer.findReplacements("foo ( bar").empty());
+}
+
+TEST(IgnoreReplacer, CaseFoldingChangesLength)
+{
+    // "ß" is case folded to "ss"
+    const QString sharpS(QChar(0x00DF));
+
+    IgnoreReplacer replacer({
+        buildIgnorePhrase("stra" + sharpS + "e", false, "***", false),
+        buildIgnorePhrase("s", false, "z", false),
+    });
+
+    // only the pattern is longer once folded
+    EXPECT_EQ(apply(replacer, "STRASSE ok"), "*** ok");
+    // only the message is longer once folded
+    EXPECT_EQ(apply(replacer, "in der Stra" + sharpS + "e ok"),
+              "in der *** ok");
+    // "s" doesn't replace half of a "ß"
+    EXPECT_EQ(apply(replacer, "gro" + sharpS + " S"), "gro" + sharpS + " z");
+}
@@ -0,0 +1,83 @@
+#include "messages/Image.hpp"
+
+#include "messages/layouts/MessageLayoutCache.hpp"
+
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QPixmap>
+
+namespace chatterino {
+
+// Images load their frames from the network, the tests set them directly
+class ImageTest : public ::testing::Test
+{
+protected:
+    static void setFrames(Image &image, const QPixmap &pixmap)
+    {
+        image.setFrames(
+            std::make_unique<detail::Frames>(QVector<detail::Frame<QPixmap>>{
+                detail::Frame<QPixmap>{pixmap, 1}}));
+    }
+
+    static void expireFrames(Image &image)
+    {
+        image.expireFrames();
+    }
+
+    // frames and layout buffers are gui thread only, the tests run on
+    // another thread
+    template <typename Func>
+    static void runInGuiThread(Func func)
+    {
+        QMetaObject::invokeMethod(QCoreApplication::instance(), func,
+                                  Qt::BlockingQueuedConnection);
+    }
+};
+
+}  // namespace chatterino
+
+using namespace chatterino;
+
+TEST_F(ImageTest, ReloadRepaintsBuffer)
+{
+    runInGuiThread([] {
+        auto &cache = MessageLayoutCache::instance();
+
+        QPixmap pixmap(28, 28);
+        pixmap.fill(Qt::red);
+
+        auto image = Image::fromUrl(Url{"https://chatterino.test/reload.png"});
+        setFrames(*image, pixmap);
+        cache.takeImageUpdates();
+
+        // built while the image was loaded, so it isn't a dependent yet
+        auto shared = std::make_shared<SharedMessageLayout>();
+        shared->bufferValid = true;
+
+        // dropped by ImageMemoryBudget while the message was off screen
+        expireFrames(*image);
+        EXPECT_FALSE(image->loaded());
+        EXPECT_EQ(image->width(), 28);
+
+        // what MessageLayoutCache::bufferPainted does for every image that is
+        // missing from the buffer, once for each time it is painted
+        image->addLayoutDependent(shared);
+        image->addLayoutDependent(shared);
+
+        setFrames(*image, pixmap);
+
+        EXPECT_TRUE(image->loaded());
+        EXPECT_FALSE(shared->bufferValid);
+        // the size didn't change, the layout can be kept
+        EXPECT_FALSE(shared->stale);
+        EXPECT_TRUE(cache.takeImageUpdates());
+
+        // a later load doesn't touch the buffer again
+        shared->bufferValid = true;
+        expireFrames(*image);
+        setFrames(*image, pixmap);
+
+        EXPECT_TRUE(shared->bufferValid);
+        EXPECT_FALSE(cache.takeImageUpdates());
+    });
+}
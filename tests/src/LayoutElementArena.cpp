@@ -0,0 +1,143 @@
+#include "messages/layouts/LayoutElementArena.hpp"
+
+#include "messages/MessageElement.hpp"
+#include "messages/layouts/MessageLayoutElement.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace chatterino;
+
+namespace {
+
+class CountedElement : public MessageLayoutElement
+{
+public:
+    CountedElement(int &alive, int value)
+        : MessageLayoutElement(EmptyElement::instance(), QSize(1, 1))
+        , alive_(alive)
+        , value_(value)
+    {
+        this->alive_++;
+    }
+
+    ~CountedElement() override
+    {
+        this->alive_--;
+    }
+
+    int value() const
+    {
+        return this->value_;
+    }
+
+protected:
+    void addCopyTextToString(QString &, int, int) const override
+    {
+    }
+    int getSelectionIndexCount() const override
+    {
+        return 0;
+    }
+    void paint(QPainter &) override
+    {
+    }
+    void paintAnimated(QPainter &, int) override
+    {
+    }
+    int getMouseOverIndex(const QPoint &) const override
+    {
+        return 0;
+    }
+    int getXFromIndex(int) override
+    {
+        return 0;
+    }
+
+private:
+    int &alive_;
+    int value_;
+    // makes elements large enough to need a few blocks
+    char padding_[100]{};
+};
+
+}  // namespace
+
+TEST(LayoutElementArena, Create)
+{
+    int alive = 0;
+
+    {
+        LayoutElementArena arena;
+        std::vector<CountedElement *> elements;
+
+        for (int i = 0; i < 100; i++)
+        {
+            elements.push_back(arena.create<CountedElement>(alive, i));
+        }
+
+        EXPECT_EQ(alive, 100);
+        for (int i = 0; i < 100; i++)
+        {
+            EXPECT_EQ(elements[i]->value(), i);
+        }
+    }
+
+    // the arena destroys its elements
+    EXPECT_EQ(alive, 0);
+}
+
+TEST(LayoutElementArena, Destroy)
+{
+    int alive = 0;
+    LayoutElementArena arena;
+
+    auto *first = arena.create<CountedElement>(alive, 1);
+    arena.create<CountedElement>(alive, 2);
+    auto used = arena.usedBytes();
+    auto *last = arena.create<CountedElement>(alive, 3);
+
+    // the memory of the last element is reused right away
+    arena.destroy(last);
+    EXPECT_EQ(alive, 2);
+    EXPECT_EQ(arena.usedBytes(), used);
+
+    // others are only destroyed, but not twice
+    arena.destroy(first);
+    EXPECT_EQ(alive, 1);
+    EXPECT_EQ(arena.usedBytes(), used);
+
+    arena.clear();
+    EXPECT_EQ(alive, 0);
+    EXPECT_EQ(arena.usedBytes(), 0U);
+}
+
+TEST(LayoutElementArena, Reuse)
+{
+    int alive = 0;
+    LayoutElementArena arena;
+
+    for (int i = 0; i < 100; i++)
+    {
+        arena.create<CountedElement>(alive, i);
+    }
+
+    auto used = arena.usedBytes();
+    arena.clear();
+
+    // only the largest block is kept
+    auto capacity = arena.capacity();
+    EXPECT_LT(capacity, used);
+
+    // no more blocks are needed after reserving the previous size
+    arena.reserve(used);
+    auto reserved = arena.capacity();
+    EXPECT_GE(reserved, used);
+
+    for (int i = 0; i < 100; i++)
+    {
+        arena.create<CountedElement>(alive, i);
+    }
+
+    EXPECT_EQ(arena.capacity(), reserved);
+    EXPECT_EQ(arena.usedBytes(), used);
+}
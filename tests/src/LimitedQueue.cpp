@@ -0,0 +1,150 @@
+#include "messages/LimitedQueue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace chatterino;
+
+namespace {
+
+template <typename T>
+std::vector<T> toVector(const LimitedQueueSnapshot<T> &snapshot)
+{
+    std::vector<T> out;
+    for (size_t i = 0; i < snapshot.size(); i++)
+    {
+        out.push_back(snapshot[i]);
+    }
+    return out;
+}
+
+}  // namespace
+
+TEST(LimitedQueue, PushBack)
+{
+    LimitedQueue<int> queue(5);
+    int deleted = -1;
+
+    EXPECT_TRUE(queue.empty());
+
+    for (int i = 0; i < 5; i++)
+    {
+        EXPECT_FALSE(queue.pushBack(i, deleted));
+    }
+    EXPECT_FALSE(queue.empty());
+    EXPECT_EQ(toVector(queue.getSnapshot()), (std::vector<int>{0, 1, 2, 3, 4}));
+
+    EXPECT_TRUE(queue.pushBack(5, deleted));
+    EXPECT_EQ(deleted, 0);
+    EXPECT_EQ(toVector(queue.getSnapshot()), (std::vector<int>{1, 2, 3, 4, 5}));
+}
+
+TEST(LimitedQueue, SnapshotIsImmutable)
+{
+    LimitedQueue<int> queue(5);
+    int deleted;
+
+    for (int i = 0; i < 3; i++)
+    {
+        queue.pushBack(i, deleted);
+    }
+
+    auto snapshot = queue.getSnapshot();
+
+    // push enough items to force the queue to move to a new buffer
+    for (int i = 3; i < 200; i++)
+    {
+        queue.pushBack(i, deleted);
+    }
+    queue.replaceItem(size_t(0), -1);
+    queue.pushFront({-2});
+
+    EXPECT_EQ(toVector(snapshot), (std::vector<int>{0, 1, 2}));
+    EXPECT_EQ(toVector(queue.getSnapshot()),
+              (std::vector<int>{-1, 196, 197, 198, 199}));
+}
+
+TEST(LimitedQueue, PushFront)
+{
+    LimitedQueue<int> queue(5);
+    int deleted;
+
+    queue.pushBack(3, deleted);
+    queue.pushBack(4, deleted);
+
+    // only the last three items fit
+    auto accepted = queue.pushFront({-1, 0, 1, 2});
+    EXPECT_EQ(accepted, (std::vector<int>{0, 1, 2}));
+    EXPECT_EQ(toVector(queue.getSnapshot()), (std::vector<int>{0, 1, 2, 3, 4}));
+
+    // the queue is full now
+    EXPECT_TRUE(queue.pushFront({-2}).empty());
+
+    // pushing back still evicts from the front
+    EXPECT_TRUE(queue.pushBack(5, deleted));
+    EXPECT_EQ(deleted, 0);
+}
+
+TEST(LimitedQueue, ReplaceItem)
+{
+    LimitedQueue<int> queue(5);
+    int deleted;
+
+    for (int i = 0; i < 8; i++)
+    {
+        queue.pushBack(i, deleted);
+    }
+
+    EXPECT_EQ(queue.replaceItem(5, 50), 2);
+    EXPECT_EQ(queue.replaceItem(0, 10), -1);
+    EXPECT_TRUE(queue.replaceItem(size_t(4), 70));
+    EXPECT_FALSE(queue.replaceItem(size_t(5), 80));
+
+    EXPECT_EQ(toVector(queue.getSnapshot()),
+              (std::vector<int>{3, 4, 50, 6, 70}));
+}
+
+TEST(LimitedQueue, Clear)
+{
+    LimitedQueue<int> queue(5);
+    int deleted;
+
+    queue.pushBack(1, deleted);
+    auto snapshot = queue.getSnapshot();
+
+    queue.clear();
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.getSnapshot().size(), 0U);
+    EXPECT_EQ(toVector(snapshot), (std::vector<int>{1}));
+}
+
+TEST(LimitedQueue, ConcurrentSnapshots)
+{
+    LimitedQueue<std::shared_ptr<int>> queue(100);
+    std::atomic<bool> done{false};
+
+    std::thread reader([&] {
+        while (!done)
+        {
+            auto snapshot = queue.getSnapshot();
+
+            // items are always pushed in increasing order
+            for (size_t i = 1; i < snapshot.size(); i++)
+            {
+                ASSERT_EQ(*snapshot[i], *snapshot[i - 1] + 1);
+            }
+        }
+    });
+
+    std::shared_ptr<int> deleted;
+    for (int i = 0; i < 100000; i++)
+    {
+        queue.pushBack(std::make_shared<int>(i), deleted);
+    }
+
+    done = true;
+    reader.join();
+}
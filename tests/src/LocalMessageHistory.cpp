@@ -0,0 +1,44 @@
+#include "providers/twitch/LocalMessageHistory.hpp"
+
+#include "singletons/helper/LogArchive.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace chatterino;
+
+namespace {
+
+LogRecord makeRecord(const QDateTime &time)
+{
+    LogRecord record;
+    record.time = time;
+    record.text = "hello";
+    return record;
+}
+
+}  // namespace
+
+TEST(LocalMessageHistory, StartsDay)
+{
+    QDateTime now(QDate::currentDate(), QTime(12, 0));
+    auto yesterday = now.addDays(-1);
+
+    std::vector<LogRecord> records{
+        makeRecord(yesterday),
+        makeRecord(yesterday.addSecs(1)),
+        makeRecord(now),
+        makeRecord(now.addSecs(1)),
+    };
+
+    EXPECT_TRUE(LocalMessageHistory::startsDay(records, 0));
+    EXPECT_FALSE(LocalMessageHistory::startsDay(records, 1));
+    EXPECT_TRUE(LocalMessageHistory::startsDay(records, 2));
+    EXPECT_FALSE(LocalMessageHistory::startsDay(records, 3));
+
+    // a history of only today still starts with the date, like the one of
+    // the recent messages service
+    std::vector<LogRecord> today{makeRecord(now), makeRecord(now.addSecs(1))};
+
+    EXPECT_TRUE(LocalMessageHistory::startsDay(today, 0));
+    EXPECT_FALSE(LocalMessageHistory::startsDay(today, 1));
+}
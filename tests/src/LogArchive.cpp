@@ -0,0 +1,240 @@
+#include "singletons/helper/LogArchive.hpp"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <gtest/gtest.h>
+
+using namespace chatterino;
+
+namespace {
+
+const QDate day(2021, 6, 1);
+
+LogRecord makeRecord(int minute, const QString &loginName)
+{
+    LogRecord record;
+    record.time = QDateTime(day, QTime(12, minute));
+    record.loginName = loginName;
+    record.displayName = loginName.toUpper();
+    record.flags = 4;
+    record.badges = QStringList{"subscriber/12"};
+    record.ircLine = "@badges=subscriber/12 :" + loginName.toUtf8() +
+                     " PRIVMSG #forsen :hello";
+    record.text = loginName + ": hello " + QString::number(minute);
+    return record;
+}
+
+std::vector<QString> texts(const LogArchiveReader &reader,
+                           const QDateTime &from, const QDateTime &to)
+{
+    std::vector<QString> out;
+    reader.readRange(from, to, [&](const LogRecord &record) {
+        out.push_back(record.text);
+        return true;
+    });
+    return out;
+}
+
+}  // namespace
+
+TEST(LogArchive, ReadRange)
+{
+    QTemporaryDir dir;
+
+    {
+        LogArchiveWriter writer(
+            LogArchiveReader::filePath(dir.path(), "forsen", day));
+        ASSERT_TRUE(writer.isOpen());
+
+        for (int i = 0; i < 6; i++)
+        {
+            writer.add(makeRecord(i, i % 2 == 0 ? "foo" : "bar"));
+
+            // a few blocks
+            if (i % 2 == 1)
+            {
+                writer.flush(true);
+            }
+        }
+    }
+
+    LogArchiveReader reader(dir.path(), "forsen");
+
+    EXPECT_EQ(reader.days(), std::vector<QDate>{day});
+
+    auto all = texts(reader, QDateTime(day, QTime(0, 0)),
+                     QDateTime(day.addDays(1), QTime(0, 0)));
+    ASSERT_EQ(all.size(), 6U);
+    EXPECT_EQ(all[0], "foo: hello 0");
+    EXPECT_EQ(all[5], "bar: hello 5");
+
+    // to is exclusive
+    EXPECT_EQ(texts(reader, QDateTime(day, QTime(12, 2)),
+                    QDateTime(day, QTime(12, 4))),
+              (std::vector<QString>{"foo: hello 2", "bar: hello 3"}));
+
+    // all fields survive
+    reader.readRange(QDateTime(day, QTime(12, 1)), QDateTime(day, QTime(13, 0)),
+                     [](const LogRecord &record) {
+                         EXPECT_EQ(record.loginName, "bar");
+                         EXPECT_EQ(record.displayName, "BAR");
+                         EXPECT_EQ(record.flags, 4U);
+                         EXPECT_EQ(record.badges,
+                                   QStringList{"subscriber/12"});
+                         EXPECT_EQ(record.ircLine,
+                                   QByteArray("@badges=subscriber/12 :bar "
+                                              "PRIVMSG #forsen :hello"));
+                         // stop after the first record
+                         return false;
+                     });
+}
+
+TEST(LogArchive, ReadUser)
+{
+    QTemporaryDir dir;
+
+    {
+        LogArchiveWriter writer(
+            LogArchiveReader::filePath(dir.path(), "forsen", day));
+
+        for (int i = 0; i < 10; i++)
+        {
+            writer.add(makeRecord(i, i == 7 ? "Baz" : "foo"));
+            writer.flush(true);
+        }
+    }
+
+    LogArchiveReader reader(dir.path(), "forsen");
+    std::vector<QString> found;
+
+    reader.readUser("baz", QDateTime(day, QTime(0, 0)),
+                    QDateTime(day.addDays(1), QTime(0, 0)),
+                    [&](const LogRecord &record) {
+                        found.push_back(record.text);
+                        return true;
+                    });
+
+    EXPECT_EQ(found, std::vector<QString>{"Baz: hello 7"});
+}
+
+TEST(LogArchive, ReadUserBusyBlock)
+{
+    QTemporaryDir dir;
+
+    // a busy chat puts hundreds of chatters into one block
+    {
+        LogArchiveWriter writer(
+            LogArchiveReader::filePath(dir.path(), "forsen", day));
+
+        for (int i = 0; i < 500; i++)
+        {
+            writer.add(makeRecord(i % 60, "user" + QString::number(i)));
+        }
+    }
+
+    LogArchiveReader reader(dir.path(), "forsen");
+    auto from = QDateTime(day, QTime(0, 0));
+    auto to = QDateTime(day.addDays(1), QTime(0, 0));
+    std::vector<QString> found;
+
+    reader.readUser("USER123", from, to, [&](const LogRecord &record) {
+        found.push_back(record.loginName);
+        return true;
+    });
+    EXPECT_EQ(found, std::vector<QString>{"user123"});
+
+    found.clear();
+    reader.readUser("user500", from, to, [&](const LogRecord &record) {
+        found.push_back(record.loginName);
+        return true;
+    });
+    EXPECT_TRUE(found.empty());
+}
+
+TEST(LogArchive, TruncatedBlock)
+{
+    QTemporaryDir dir;
+    auto path = LogArchiveReader::filePath(dir.path(), "forsen", day);
+
+    {
+        LogArchiveWriter writer(path);
+        writer.add(makeRecord(0, "foo"));
+        writer.flush(true);
+        writer.add(makeRecord(1, "foo"));
+    }
+
+    // cut the second block short like a crash would
+    {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+        file.resize(file.size() - 4);
+    }
+
+    LogArchiveReader reader(dir.path(), "forsen");
+    auto from = QDateTime(day, QTime(0, 0));
+    auto to = QDateTime(day.addDays(1), QTime(0, 0));
+
+    EXPECT_EQ(texts(reader, from, to), std::vector<QString>{"foo: hello 0"});
+
+    // appending drops the broken block
+    {
+        LogArchiveWriter writer(path);
+        writer.add(makeRecord(2, "foo"));
+    }
+
+    EXPECT_EQ(texts(reader, from, to),
+              (std::vector<QString>{"foo: hello 0", "foo: hello 2"}));
+}
+
+TEST(LogArchive, ReadLast)
+{
+    QTemporaryDir dir;
+    auto previousDay = day.addDays(-1);
+
+    {
+        LogArchiveWriter writer(
+            LogArchiveReader::filePath(dir.path(), "forsen", previousDay));
+        auto record = makeRecord(0, "foo");
+        record.time = QDateTime(previousDay, QTime(23, 0));
+        record.text = "yesterday";
+        writer.add(record);
+    }
+    {
+        LogArchiveWriter writer(
+            LogArchiveReader::filePath(dir.path(), "forsen", day));
+
+        for (int i = 0; i < 5; i++)
+        {
+            writer.add(makeRecord(i, "foo"));
+            if (i % 2 == 1)
+            {
+                writer.flush(true);
+            }
+        }
+    }
+
+    LogArchiveReader reader(dir.path(), "forsen");
+    auto textsOf = [](const std::vector<LogRecord> &records) {
+        std::vector<QString> out;
+        for (const auto &record : records)
+        {
+            out.push_back(record.text);
+        }
+        return out;
+    };
+
+    EXPECT_EQ(textsOf(reader.readLast(3, QDateTime(day, QTime(13, 0)))),
+              (std::vector<QString>{"foo: hello 2", "foo: hello 3",
+                                    "foo: hello 4"}));
+
+    // before is exclusive
+    EXPECT_EQ(textsOf(reader.readLast(2, QDateTime(day, QTime(12, 3)))),
+              (std::vector<QString>{"foo: hello 1", "foo: hello 2"}));
+
+    // continues with the previous day
+    EXPECT_EQ(textsOf(reader.readLast(3, QDateTime(day, QTime(12, 2)))),
+              (std::vector<QString>{"yesterday", "foo: hello 0",
+                                    "foo: hello 1"}));
+
+    EXPECT_EQ(reader.readLast(100, QDateTime(day, QTime(13, 0))).size(), 6U);
+}
@@ -0,0 +1,64 @@
+#include "providers/twitch/MergedEmoteMap.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace chatterino;
+
+namespace {
+
+std::shared_ptr<const EmoteMap> makeEmotes(std::vector<QString> names)
+{
+    auto emotes = std::make_shared<EmoteMap>();
+    for (const auto &name : names)
+    {
+        emotes->emplace(EmoteName{name},
+                        std::make_shared<const Emote>(Emote{EmoteName{name}}));
+    }
+    return emotes;
+}
+
+}  // namespace
+
+TEST(MergedEmoteMap, Precedence)
+{
+    MergedEmoteMap::Sources sources;
+    sources.ffzChannel = makeEmotes({"a"});
+    sources.bttvChannel = makeEmotes({"a", "b"});
+    sources.ffzGlobal = makeEmotes({"b", "c"});
+    sources.bttvGlobal = makeEmotes({"c", "d"});
+
+    MergedEmoteMap merged(sources);
+
+    EXPECT_EQ(merged.size(), 4U);
+    EXPECT_EQ(merged.find(EmoteName{"x"}), nullptr);
+
+    auto expect = [&](const QString &name,
+                      const std::shared_ptr<const EmoteMap> &source,
+                      MessageElementFlag flag) {
+        const auto *item = merged.find(EmoteName{name});
+        ASSERT_NE(item, nullptr);
+        EXPECT_EQ(item->emote, source->at(EmoteName{name}));
+        EXPECT_TRUE(item->flags.has(flag));
+        EXPECT_FALSE(item->flags.has(MessageElementFlag::ZeroWidthEmote));
+    };
+
+    expect("a", sources.ffzChannel, MessageElementFlag::FfzEmote);
+    expect("b", sources.bttvChannel, MessageElementFlag::BttvEmote);
+    expect("c", sources.ffzGlobal, MessageElementFlag::FfzEmote);
+    expect("d", sources.bttvGlobal, MessageElementFlag::BttvEmote);
+}
+
+TEST(MergedEmoteMap, ZeroWidth)
+{
+    MergedEmoteMap::Sources sources;
+    sources.bttvChannel = makeEmotes({"TopHat"});
+    sources.bttvGlobal = makeEmotes({"SantaHat", "TopHat"});
+
+    MergedEmoteMap merged(sources);
+
+    // only global BetterTTV emotes can be zero width
+    EXPECT_TRUE(merged.find(EmoteName{"SantaHat"})
+                    ->flags.has(MessageElementFlag::ZeroWidthEmote));
+    EXPECT_FALSE(merged.find(EmoteName{"TopHat"})
+                     ->flags.has(MessageElementFlag::ZeroWidthEmote));
+}
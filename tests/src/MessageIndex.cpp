@@ -0,0 +1,133 @@
+#include "messages/MessageIndex.hpp"
+
+#include "messages/Message.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace chatterino;
+
+namespace {
+
+MessagePtr makeMessage(const QString &id, const QString &loginName)
+{
+    auto message = std::make_shared<Message>();
+    message->id = id;
+    message->loginName = loginName;
+    return message;
+}
+
+MessagePtr makeTimeout(const QString &user)
+{
+    auto message = std::make_shared<Message>();
+    message->timeoutUser = user;
+    message->flags.set(MessageFlag::Timeout);
+    return message;
+}
+
+}  // namespace
+
+TEST(MessageIndex, FindById)
+{
+    MessageIndex index;
+
+    auto a = makeMessage("a", "foo");
+    auto b = makeMessage("b", "bar");
+    auto c = makeMessage("c", "foo");
+
+    index.append(a);
+    index.append(b);
+    index.append(c);
+
+    EXPECT_EQ(index.findById("a"), boost::optional<size_t>(0));
+    EXPECT_EQ(index.findById("c"), boost::optional<size_t>(2));
+    EXPECT_EQ(index.find(b), boost::optional<size_t>(1));
+    EXPECT_EQ(index.findById("d"), boost::none);
+
+    // evicting the first message shifts all positions
+    index.removeFirst(a);
+
+    EXPECT_EQ(index.findById("a"), boost::none);
+    EXPECT_EQ(index.findById("b"), boost::optional<size_t>(0));
+    EXPECT_EQ(index.findById("c"), boost::optional<size_t>(1));
+}
+
+TEST(MessageIndex, Prepend)
+{
+    MessageIndex index;
+
+    auto live = makeMessage("a", "foo");
+    index.append(live);
+
+    auto old1 = makeMessage("x", "foo");
+    auto old2 = makeMessage("a", "foo");
+    index.prepend({old1, old2});
+
+    EXPECT_EQ(index.findById("x"), boost::optional<size_t>(0));
+    // the live copy of a duplicate message wins
+    EXPECT_EQ(index.findById("a"), boost::optional<size_t>(2));
+    EXPECT_EQ(index.findByUser("foo"), (std::vector<size_t>{0, 1, 2}));
+}
+
+TEST(MessageIndex, Replace)
+{
+    MessageIndex index;
+
+    auto a = makeMessage("a", "foo");
+    auto b = makeMessage("b", "bar");
+    index.append(a);
+    index.append(b);
+
+    auto replacement = makeMessage("c", "baz");
+    index.replace(0, a, replacement);
+
+    EXPECT_EQ(index.findById("a"), boost::none);
+    EXPECT_EQ(index.findById("c"), boost::optional<size_t>(0));
+    EXPECT_TRUE(index.findByUser("foo").empty());
+    EXPECT_EQ(index.findByUser("baz"), (std::vector<size_t>{0}));
+}
+
+TEST(MessageIndex, Timeouts)
+{
+    MessageIndex index;
+
+    auto message = makeMessage("a", "Foo");
+    auto timeout1 = makeTimeout("foo");
+    auto timeout2 = makeTimeout("foo");
+
+    index.append(message);
+    index.append(timeout1);
+    index.append(timeout2);
+
+    EXPECT_EQ(index.findLastTimeout("foo"), boost::optional<size_t>(2));
+    EXPECT_EQ(index.find(timeout2), boost::optional<size_t>(2));
+    // only the newest timeout of a user can be found
+    EXPECT_EQ(index.find(timeout1), boost::none);
+
+    // user names are matched case insensitively
+    EXPECT_EQ(index.findByUser("FOO"), (std::vector<size_t>{0, 1, 2}));
+}
+
+TEST(MessageIndex, DisabledUntil)
+{
+    MessageIndex index;
+
+    for (int i = 0; i < 5; i++)
+    {
+        index.append(makeMessage(QString::number(i), "foo"));
+    }
+
+    EXPECT_EQ(index.disabledUntil(), 0U);
+    index.setDisabledUntil(5);
+    EXPECT_EQ(index.disabledUntil(), 5U);
+
+    index.removeFirst(makeMessage("0", "foo"));
+    EXPECT_EQ(index.disabledUntil(), 4U);
+
+    // replacing a message makes it eligible for disabling again
+    index.replace(2, makeMessage("3", "foo"), makeMessage("x", "foo"));
+    EXPECT_EQ(index.disabledUntil(), 2U);
+
+    // so do messages added at the start
+    index.prepend({makeMessage("y", "foo")});
+    EXPECT_EQ(index.disabledUntil(), 0U);
+}
@@ -0,0 +1,99 @@
+#include "messages/MessageSimilarity.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace chatterino;
+
+namespace {
+
+// The quadratic dynamic program IrcMessageHandler used before
+int referenceLongestCommonSubstring(const QString &a, const QString &b)
+{
+    std::vector<std::vector<int>> tree(a.size(), std::vector<int>(b.size()));
+    int longest = 0;
+
+    for (int i = 0; i < a.size(); ++i)
+    {
+        for (int j = 0; j < b.size(); ++j)
+        {
+            if (a[i] == b[j])
+            {
+                tree[i][j] = i == 0 || j == 0 ? 1 : tree[i - 1][j - 1] + 1;
+                longest = std::max(longest, tree[i][j]);
+            }
+        }
+    }
+
+    return longest;
+}
+
+QString randomText(std::mt19937 &random, int maxLength)
+{
+    // a small alphabet, so texts share plenty of substrings
+    std::uniform_int_distribution<int> length(0, maxLength);
+    std::uniform_int_distribution<int> letter('a', 'd');
+
+    QString text;
+    for (int i = length(random); i > 0; i--)
+    {
+        text.append(QChar(letter(random)));
+    }
+    return text;
+}
+
+}  // namespace
+
+TEST(MessageSimilarity, LongestCommonSubstring)
+{
+    EXPECT_EQ(MessageSimilarity::longestCommonSubstring("", "abc"), 0);
+    EXPECT_EQ(MessageSimilarity::longestCommonSubstring("abc", "xyz"), 0);
+    EXPECT_EQ(MessageSimilarity::longestCommonSubstring("xabcy", "zzabc"), 3);
+    EXPECT_EQ(MessageSimilarity::longestCommonSubstring("Kappa", "Kappa"), 5);
+
+    EXPECT_FLOAT_EQ(MessageSimilarity::relativeSimilarity("abcd", "abxx"),
+                    0.5f);
+    EXPECT_FLOAT_EQ(MessageSimilarity::relativeSimilarity("", ""), 0.f);
+}
+
+TEST(MessageSimilarity, MatchesReference)
+{
+    std::mt19937 random(42);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        auto a = randomText(random, 40);
+        auto b = randomText(random, 40);
+        auto expected = referenceLongestCommonSubstring(a, b);
+
+        ASSERT_EQ(MessageSimilarity::longestCommonSubstring(a, b), expected)
+            << a.toStdString() << " " << b.toStdString();
+
+        auto longer = std::max(1, std::max(a.size(), b.size()));
+        auto similarity = expected == 0 ? 0.f : float(expected) / longer;
+
+        for (auto threshold : {0.f, 0.25f, 0.5f, 0.75f, 0.9f})
+        {
+            ASSERT_EQ(MessageSimilarity(a).isSimilarTo(MessageSimilarity(b),
+                                                       threshold),
+                      similarity > threshold)
+                << a.toStdString() << " " << b.toStdString() << " "
+                << threshold;
+        }
+    }
+}
+
+TEST(MessageSimilarity, Copypasta)
+{
+    MessageSimilarity original(
+        "I'm not a bot, I just type really fast and my keyboard is on fire");
+    MessageSimilarity copy(
+        "I'm not a bot, I just type really fast and my keyboard is on fire!!");
+    MessageSimilarity other("hello chat, how is everyone doing today?");
+
+    EXPECT_TRUE(original.isSimilarTo(copy, 0.9f));
+    EXPECT_TRUE(copy.isSimilarTo(original, 0.9f));
+    EXPECT_FALSE(original.isSimilarTo(other, 0.9f));
+    EXPECT_FALSE(original.isSimilarTo(copy, 1.f));
+}
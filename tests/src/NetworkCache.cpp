@@ -0,0 +1,201 @@
+#include "common/NetworkCache.hpp"
+
+#include "common/NetworkBlobStore.hpp"
+
+#include <QDateTime>
+#include <QFile>
+#include <QTemporaryDir>
+#include <gtest/gtest.h>
+
+using namespace chatterino;
+
+namespace {
+
+// Writes only half of the next batch, like a full disk
+class ShortWriteBlobStore : public NetworkBlobStore
+{
+public:
+    using NetworkBlobStore::NetworkBlobStore;
+
+    bool failNextWrite = false;
+
+protected:
+    qint64 write(QFile &file, const QByteArray &buffer) override
+    {
+        if (this->failNextWrite)
+        {
+            this->failNextWrite = false;
+            return file.write(buffer.left(buffer.size() / 2));
+        }
+
+        return NetworkBlobStore::write(file, buffer);
+    }
+};
+
+}  // namespace
+
+TEST(NetworkCache, ReadWrite)
+{
+    QTemporaryDir dir;
+    NetworkCache cache(dir.path(), 1024);
+
+    EXPECT_FALSE(cache.find("a"));
+    EXPECT_EQ(cache.read("a"), boost::none);
+
+    cache.write("a", "hello", "\"etag\"", 0);
+
+    // readable before it is written to disk
+    EXPECT_EQ(cache.read("a"), boost::optional<QByteArray>("hello"));
+    EXPECT_EQ(cache.find("a")->etag, QByteArray("\"etag\""));
+
+    cache.flush();
+
+    // small responses are packed into a segment
+    EXPECT_FALSE(QFile::exists(dir.path() + "/a"));
+    EXPECT_GE(cache.find("a")->location.segment, 0);
+    EXPECT_EQ(cache.read("a"), boost::optional<QByteArray>("hello"));
+    EXPECT_EQ(cache.totalBytes(), 5);
+}
+
+TEST(NetworkCache, LargeResponse)
+{
+    QTemporaryDir dir;
+    NetworkCache cache(dir.path(), 16 * 1024 * 1024);
+
+    QByteArray large(NetworkCache::maxBlobSize + 1, 'x');
+    cache.write("a", large, {}, 0);
+    cache.write("b", "hello", {}, 0);
+    cache.flush();
+
+    EXPECT_TRUE(QFile::exists(dir.path() + "/a"));
+    EXPECT_EQ(cache.find("a")->location.segment, -1);
+    EXPECT_EQ(cache.read("a"), boost::optional<QByteArray>(large));
+    EXPECT_EQ(cache.read("b"), boost::optional<QByteArray>("hello"));
+
+    // the file is removed once the response moves into a segment
+    cache.write("a", "small", {}, 0);
+    cache.flush();
+
+    EXPECT_FALSE(QFile::exists(dir.path() + "/a"));
+    EXPECT_EQ(cache.read("a"), boost::optional<QByteArray>("small"));
+}
+
+TEST(NetworkCache, Index)
+{
+    QTemporaryDir dir;
+    auto expires = QDateTime::currentSecsSinceEpoch() + 60;
+
+    {
+        NetworkCache cache(dir.path(), 1024);
+        cache.write("a", "hello", "\"etag\"", expires);
+    }
+
+    NetworkCache cache(dir.path(), 1024);
+
+    auto entry = cache.find("a");
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(entry->size, 5);
+    EXPECT_EQ(entry->expires, expires);
+    EXPECT_EQ(entry->etag, QByteArray("\"etag\""));
+    EXPECT_FALSE(entry->isExpired(QDateTime::currentSecsSinceEpoch()));
+    EXPECT_TRUE(entry->isExpired(expires));
+    EXPECT_EQ(cache.read("a"), boost::optional<QByteArray>("hello"));
+}
+
+TEST(NetworkCache, Evict)
+{
+    QTemporaryDir dir;
+    NetworkCache cache(dir.path(), 10);
+
+    cache.write("a", "12345", {}, 0);
+    cache.flush();
+    cache.write("b", "12345", {}, 0);
+    cache.flush();
+    EXPECT_EQ(cache.totalBytes(), 10);
+
+    // exceeding the budget removes responses until it fits again
+    cache.write("c", "12345", {}, 0);
+    cache.flush();
+
+    EXPECT_EQ(cache.totalBytes(), 10);
+    EXPECT_EQ(cache.find("c")->size, 5);
+    EXPECT_EQ(int(bool(cache.find("a"))) + int(bool(cache.find("b"))), 1);
+}
+
+TEST(NetworkCache, Migrate)
+{
+    QTemporaryDir dir;
+
+    // caches from before the index existed
+    {
+        QFile file(dir.path() + "/a");
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write("hello");
+    }
+
+    NetworkCache cache(dir.path(), 1024);
+
+    EXPECT_EQ(cache.read("a"), boost::optional<QByteArray>("hello"));
+    EXPECT_EQ(cache.totalBytes(), 5);
+}
+
+TEST(NetworkCache, Compact)
+{
+    QTemporaryDir dir;
+    NetworkCache cache(dir.path(), 20, 32);
+
+    cache.write("a", "12345", {}, 0);
+    cache.write("b", "12345", {}, 0);
+    cache.write("c", "12345", {}, 0);
+    cache.write("d", "12345", {}, 0);
+    cache.flush();
+
+    auto segment = cache.find("d")->location.segment;
+    auto segmentPath = dir.path() + "/segment-" + QString::number(segment);
+    ASSERT_TRUE(QFile::exists(segmentPath));
+
+    // doesn't fit into the first segment anymore and evicts a, b and c
+    // from it
+    cache.write("e", "12345", {}, 0);
+    cache.write("f", "12345", {}, 0);
+    cache.write("g", "12345", {}, 0);
+    cache.flush();
+
+    EXPECT_FALSE(cache.find("a"));
+    EXPECT_FALSE(cache.find("b"));
+    EXPECT_FALSE(cache.find("c"));
+
+    // d was moved out of the mostly empty segment, which is gone now
+    auto entry = cache.find("d");
+    ASSERT_TRUE(entry);
+    EXPECT_NE(entry->location.segment, segment);
+    EXPECT_EQ(entry->location.segment, cache.find("e")->location.segment);
+    EXPECT_FALSE(QFile::exists(segmentPath));
+
+    EXPECT_EQ(cache.read("d"), boost::optional<QByteArray>("12345"));
+    EXPECT_EQ(cache.read("e"), boost::optional<QByteArray>("12345"));
+    EXPECT_EQ(cache.totalBytes(), 20);
+}
+
+TEST(NetworkBlobStore, ShortWrite)
+{
+    QTemporaryDir dir;
+    ShortWriteBlobStore store(dir.path());
+
+    auto first = store.append({"hello"});
+    ASSERT_TRUE(first);
+
+    store.failNextWrite = true;
+    EXPECT_FALSE(store.append({"broken", "batch"}));
+
+    // the partial write is gone, so the next blob is where its location says
+    auto second = store.append({"world"});
+    ASSERT_TRUE(second);
+    EXPECT_EQ((*second)[0].segment, (*first)[0].segment);
+    EXPECT_EQ((*second)[0].offset, 5);
+
+    EXPECT_EQ(store.read((*first)[0], 5), boost::optional<QByteArray>("hello"));
+    EXPECT_EQ(store.read((*second)[0], 5),
+              boost::optional<QByteArray>("world"));
+    EXPECT_EQ(store.segments()[(*first)[0].segment], 10);
+}
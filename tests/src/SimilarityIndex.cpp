@@ -0,0 +1,128 @@
+#include "messages/SimilarityIndex.hpp"
+
+#include "messages/Message.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace chatterino;
+
+namespace {
+
+const QTime start(12, 0);
+
+MessagePtr makeMessage(const QString &loginName, int second)
+{
+    auto message = std::make_shared<Message>();
+    message->loginName = loginName;
+    message->parseTime = start.addSecs(second);
+    return message;
+}
+
+}  // namespace
+
+TEST(SimilarityIndex, Window)
+{
+    SimilarityIndex index;
+    SimilarityIndex::Window window{2, 5};
+
+    auto a = makeMessage("foo", 0);
+    auto b = makeMessage("bar", 1);
+    auto c = makeMessage("foo", 2);
+
+    index.append(a, window, start);
+    index.append(b, window, start.addSecs(1));
+    index.append(c, window, start.addSecs(2));
+
+    // only the newest maxMessages messages, newest first
+    EXPECT_EQ(index.find(boost::none, window, start.addSecs(2)),
+              (std::vector<MessagePtr>{c, b}));
+    EXPECT_EQ(index.find(QString("foo"), window, start.addSecs(2)),
+              (std::vector<MessagePtr>{c, a}));
+    EXPECT_TRUE(index.find(QString("baz"), window, start.addSecs(2)).empty());
+
+    // messages older than maxDelaySeconds are skipped
+    EXPECT_EQ(index.find(QString("foo"), window, start.addSecs(5)),
+              (std::vector<MessagePtr>{c}));
+    EXPECT_TRUE(index.find(boost::none, window, start.addSecs(7)).empty());
+}
+
+TEST(SimilarityIndex, SameUserInBusyChannel)
+{
+    SimilarityIndex index;
+    SimilarityIndex::Window window{3, 60};
+
+    auto first = makeMessage("foo", 0);
+    index.append(first, window, start);
+
+    // other users don't push the user's messages out of the window
+    for (int i = 0; i < 1000; i++)
+    {
+        index.append(makeMessage(QString("user%1").arg(i), 1), window,
+                     start.addSecs(1));
+    }
+
+    auto second = makeMessage("foo", 2);
+    index.append(second, window, start.addSecs(2));
+
+    EXPECT_EQ(index.find(QString("foo"), window, start.addSecs(2)),
+              (std::vector<MessagePtr>{second, first}));
+    EXPECT_EQ(index.find(boost::none, window, start.addSecs(2)).size(), 3U);
+}
+
+TEST(SimilarityIndex, Replace)
+{
+    SimilarityIndex index;
+    SimilarityIndex::Window window{3, 5};
+
+    auto message = makeMessage("foo", 0);
+    auto replacement = makeMessage("foo", 0);
+    index.append(message, window, start);
+    index.replace(message, replacement);
+
+    EXPECT_EQ(index.find(QString("foo"), window, start),
+              (std::vector<MessagePtr>{replacement}));
+    EXPECT_EQ(index.find(boost::none, window, start),
+              (std::vector<MessagePtr>{replacement}));
+}
+
+TEST(SimilarityIndex, Midnight)
+{
+    SimilarityIndex index;
+    SimilarityIndex::Window window{3, 5};
+
+    auto message = std::make_shared<Message>();
+    message->loginName = "foo";
+    message->parseTime = QTime(23, 59, 58);
+    index.append(message, window, message->parseTime);
+
+    EXPECT_EQ(index.find(QString("foo"), window, QTime(0, 0, 1)).size(), 1U);
+    EXPECT_TRUE(index.find(QString("foo"), window, QTime(0, 0, 4)).empty());
+}
+
+TEST(SimilarityIndex, Prepend)
+{
+    SimilarityIndex index;
+    SimilarityIndex::Window window{2, 60};
+
+    auto newest = makeMessage("foo", 10);
+    index.append(newest, window, start.addSecs(10));
+
+    // the recent messages are older than everything in the channel, only the
+    // newest of them fill up the user's window
+    auto tooOld = makeMessage("bar", -100);
+    auto a = makeMessage("foo", 1);
+    auto b = makeMessage("foo", 2);
+    auto c = makeMessage("bar", 3);
+    index.prepend({tooOld, a, b, c}, window, start.addSecs(10));
+
+    EXPECT_EQ(index.find(QString("foo"), window, start.addSecs(10)),
+              (std::vector<MessagePtr>{newest, b}));
+    EXPECT_EQ(index.find(QString("bar"), window, start.addSecs(10)),
+              (std::vector<MessagePtr>{c}));
+    EXPECT_EQ(index.find(boost::none, window, start.addSecs(10)),
+              (std::vector<MessagePtr>{newest, c}));
+
+    // prepended messages expire like appended ones
+    EXPECT_EQ(index.find(QString("foo"), window, start.addSecs(62)),
+              (std::vector<MessagePtr>{newest}));
+}
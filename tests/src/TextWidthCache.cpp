@@ -0,0 +1,37 @@
+#include "messages/layouts/TextWidthCache.hpp"
+
+#include <QFont>
+#include <gtest/gtest.h>
+
+using namespace chatterino;
+
+TEST(TextWidthCache, Width)
+{
+    TextWidthCache cache;
+    QFontMetrics small(QFont("Arial", 8));
+    QFontMetrics large(QFont("Arial", 16));
+
+    EXPECT_EQ(cache.width(FontStyle::ChatMedium, 1.f, small, "Kappa"),
+              small.horizontalAdvance("Kappa"));
+    // cached per scale
+    EXPECT_EQ(cache.width(FontStyle::ChatMedium, 2.f, large, "Kappa"),
+              large.horizontalAdvance("Kappa"));
+    EXPECT_EQ(cache.width(FontStyle::ChatMedium, 1.f, large, "Kappa"),
+              small.horizontalAdvance("Kappa"));
+}
+
+TEST(TextWidthCache, Clear)
+{
+    TextWidthCache cache;
+    QFontMetrics small(QFont("Arial", 8));
+    QFontMetrics large(QFont("Arial", 16));
+
+    cache.width(FontStyle::ChatMedium, 1.f, small, "Kappa");
+
+    auto generation = cache.generation();
+    cache.clear();
+
+    EXPECT_NE(cache.generation(), generation);
+    EXPECT_EQ(cache.width(FontStyle::ChatMedium, 1.f, large, "Kappa"),
+              large.horizontalAdvance("Kappa"));
+}